@@ -0,0 +1,229 @@
+/*!
+ * \file Autotuner.cpp
+ *
+ * \brief Implements Autotuner.
+ */
+#include "Autotuner.hpp"
+#include "Jacobi2D.hpp"
+#include "DiamondTiling.hpp"
+#include "TileFootprint.hpp"
+#include "CacheSizes.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Index of val in vals, or of the closest value if it is not there.
+static int closestIndex(const std::vector<int>& vals, int val) {
+    int best = 0;
+    for (int k = 1; k < (int)vals.size(); k++) {
+        if (abs(vals[k]-val) < abs(vals[best]-val)) { best = k; }
+    }
+    return best;
+}
+
+// Bytes of ping/pong doubles that a full diamond of size tau touches.
+static long long diamondBytes(int tau) {
+    DiamondTiling tiling(2*tau, 1, 3*tau, 1, 3*tau, tau);
+    return tileFootprint(tiling, largestTile(tiling), 2,
+                         sizeof(double)).totalBytes;
+}
+
+// Largest multiple of 3 from 15 to tau_max whose diamond fits in size
+// bytes, or 15 if none does.  The footprint grows with tau and takes
+// time proportional to tau^2, so tau doubles until the diamond does
+// not fit and then a binary search finds the largest one that does.
+static int largestFittingTau(int tau_max, long long size) {
+    int lo = 5, hi = tau_max/3;
+    if (diamondBytes(3*lo) > size) { return 3*lo; }
+    while (2*lo <= hi) {
+        if (diamondBytes(6*lo) > size) {
+            hi = 2*lo-1;
+            break;
+        }
+        lo *= 2;
+    }
+    while (lo < hi) {
+        int mid = (lo+hi+1)/2;
+        if (diamondBytes(3*mid) <= size) {
+            lo = mid;
+        } else {
+            hi = mid-1;
+        }
+    }
+    return 3*lo;
+}
+
+Autotuner::Autotuner(int N, int T, int max_threads, int num_reps)
+    : mN(N), mT(T), mMaxThreads(max_threads), mNumReps(num_reps)
+{
+    mCores = (int)std::thread::hardware_concurrency();
+    if (mCores < 1) { mCores = 1; }
+
+    // Tiles much bigger than the grid all behave the same, and tiles
+    // that do not fit in L3 only get slower.
+    int tau_max = (N > 15) ? N : 15;
+    CacheLevel levels[NUM_CACHE_LEVELS];
+    detectCacheSizes(levels);
+    if (levels[2].size > 0) {
+        tau_max = largestFittingTau(tau_max, levels[2].size);
+    }
+    for (int tau = 15; tau <= tau_max; tau += 3) {
+        mTaus.push_back(tau);
+    }
+    mSlabs.push_back(0);
+    for (int slab = 2; slab < T; slab *= 2) {
+        mSlabs.push_back(slab);
+    }
+    for (int p = 1; p < max_threads; p *= 2) {
+        mThreads.push_back(p);
+    }
+    mThreads.push_back(max_threads);
+
+    mBest.tau = mTaus[0];
+    mBest.slab = 0;
+    mBest.threads = max_threads;
+    mBest.time = -1.0;
+}
+
+double Autotuner::measure(int tau, int slab, int threads) {
+    std::vector<int> key = {tau, slab, threads};
+    std::map<std::vector<int>,double>::iterator iter = mMeasured.find(key);
+    if (iter != mMeasured.end()) { return iter->second; }
+
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    Jacobi2D grid(mN);
+    kernel_type choice = kernel_auto;
+    grid.setKernel(choice);
+    int L = grid.lower(), U = grid.upper();
+    double best = -1.0;
+    for (int r = 0; r < mNumReps; r++) {
+        grid.init(1);
+        std::chrono::steady_clock::time_point start
+            = std::chrono::steady_clock::now();
+        grid.runSlabs(mT, (slab>0) ? slab : mT, true, [&](int Ts) {
+            return DiamondTiling(Ts, L, U, L, U, tau);
+        });
+        double time = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        if (best < 0 || time < best) { best = time; }
+    }
+    mMeasured[key] = best;
+
+    std::cout << "autotune: tau = " << tau << ", slab = " << slab
+              << ", threads = " << threads << ", time = " << best << " s"
+              << std::endl;
+    return best;
+}
+
+void Autotuner::tryConfig(int tau, int slab, int threads) {
+    double time = measure(tau, slab, threads);
+    if (mBest.time < 0 || time < mBest.time) {
+        mBest.tau = tau;
+        mBest.slab = slab;
+        mBest.threads = threads;
+        mBest.time = time;
+    }
+}
+
+TuneConfig Autotuner::tune(const std::string& cache_file) {
+    TuneConfig cached;
+    if (readCache(cache_file, cached)) {
+        // Warm start from the cached configuration, its time is
+        // remeasured since the machine may be loaded differently.
+        std::cout << "autotune: starting from cached tau = " << cached.tau
+                  << ", slab = " << cached.slab << ", threads = "
+                  << cached.threads << std::endl;
+        tryConfig(mTaus[closestIndex(mTaus, cached.tau)],
+                  mSlabs[closestIndex(mSlabs, cached.slab)],
+                  mThreads[closestIndex(mThreads, cached.threads)]);
+    } else {
+        // Coarse sweep over doubling tau up to the largest one, and
+        // then over slab depth.
+        int tau_max = mTaus.back();
+        for (int tau = mTaus[0]; tau < tau_max; tau *= 2) {
+            tryConfig(tau, 0, mMaxThreads);
+        }
+        tryConfig(tau_max, 0, mMaxThreads);
+        int tau = mBest.tau;
+        for (int k = 0; k < (int)mSlabs.size(); k++) {
+            tryConfig(tau, mSlabs[k], mMaxThreads);
+        }
+    }
+
+    // Hill climb over neighboring tau and slab values until neither
+    // improves the time.
+    bool improved = true;
+    while (improved) {
+        TuneConfig start = mBest;
+        int t = closestIndex(mTaus, mBest.tau);
+        int s = closestIndex(mSlabs, mBest.slab);
+        for (int d = -2; d <= 2; d++) {
+            if (d != 0 && t+d >= 0 && t+d < (int)mTaus.size()) {
+                tryConfig(mTaus[t+d], start.slab, start.threads);
+            }
+        }
+        for (int d = -1; d <= 1; d += 2) {
+            if (s+d >= 0 && s+d < (int)mSlabs.size()) {
+                tryConfig(start.tau, mSlabs[s+d], start.threads);
+            }
+        }
+        improved = (mBest.tau != start.tau || mBest.slab != start.slab);
+    }
+
+    // Finally the number of threads.
+    int tau = mBest.tau, slab = mBest.slab;
+    for (int k = 0; k < (int)mThreads.size(); k++) {
+        tryConfig(tau, slab, mThreads[k]);
+    }
+
+    writeCache(cache_file, mBest);
+    return mBest;
+}
+
+// The cache has one line per key:  N T cores tau slab threads time
+bool Autotuner::readCache(const std::string& cache_file,
+                          TuneConfig& config) {
+    std::ifstream in(cache_file.c_str());
+    int n, t, cores;
+    TuneConfig entry;
+    bool found = false;
+    while (in >> n >> t >> cores
+              >> entry.tau >> entry.slab >> entry.threads >> entry.time) {
+        if (n==mN && t==mT && cores==mCores) {
+            config = entry;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void Autotuner::writeCache(const std::string& cache_file,
+                           const TuneConfig& config) {
+    // Keep the other keys and replace the entry for this one.
+    std::stringstream kept;
+    std::ifstream in(cache_file.c_str());
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        int n, t, cores;
+        if ((ss >> n >> t >> cores) && !(n==mN && t==mT && cores==mCores)) {
+            kept << line << std::endl;
+        }
+    }
+    in.close();
+
+    std::ofstream out(cache_file.c_str());
+    out << kept.str();
+    out << mN << " " << mT << " " << mCores << " " << config.tau << " "
+        << config.slab << " " << config.threads << " " << config.time
+        << std::endl;
+}
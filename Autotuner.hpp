@@ -0,0 +1,61 @@
+/*!
+ * \file Autotuner.hpp
+ *
+ * \brief Tile size autotuner for the diamond tiled Jacobi 2D stencil.
+ *
+ * Searches over tau (multiples of 3 that are 15 or more, as required
+ * by diamond-slice-viz), slab depth (subset_s in diamond-slice-viz,
+ * 0 means no slabs), and number of threads by timing the wavefront
+ * parallel execution.  The search is coarse to fine: tau = 15, 30, 60,
+ * and so on with no slabs and all threads, then the slab depths at the
+ * best tau, then a hill climb over neighboring tau (steps of 3) and slab
+ * values, then the thread counts.  tau stops at N and at the largest
+ * tau whose diamond fits in the L3 cache (see TileFootprint.hpp), since
+ * bigger tiles only spill.  Results are cached in a text file keyed by
+ * (N, T, cores) and a cached result is used as the starting point for
+ * the hill climb instead of the coarse sweep.
+ */
+#ifndef AUTOTUNER_HPP_
+#define AUTOTUNER_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct TuneConfig {
+    int tau;
+    int slab;
+    int threads;
+    double time;
+};
+
+class Autotuner {
+  public:
+    Autotuner(int N, int T, int max_threads, int num_reps);
+
+    // Runs the search, reading and updating the cache in cache_file.
+    TuneConfig tune(const std::string& cache_file);
+
+    int cores() const { return mCores; }
+
+  private:
+    // Time for the configuration, measured once and then remembered.
+    double measure(int tau, int slab, int threads);
+    // Measures and makes the configuration the best if it is faster.
+    void tryConfig(int tau, int slab, int threads);
+
+    bool readCache(const std::string& cache_file, TuneConfig& config);
+    void writeCache(const std::string& cache_file, const TuneConfig& config);
+
+    int mN, mT;
+    int mMaxThreads;
+    int mNumReps;
+    int mCores;
+    std::vector<int> mTaus;
+    std::vector<int> mSlabs;
+    std::vector<int> mThreads;
+    std::map<std::vector<int>,double> mMeasured;
+    TuneConfig mBest;
+};
+
+#endif
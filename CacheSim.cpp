@@ -0,0 +1,89 @@
+/*!
+ * \file CacheSim.cpp
+ *
+ * \brief Implements CacheSim and parseCacheLevels.
+ */
+#include "CacheSim.hpp"
+
+#include <stdlib.h>
+#include <sstream>
+
+CacheSim::CacheSim(const std::vector<CacheLevel>& levels) : mAccesses(0) {
+    for (size_t l = 0; l < levels.size(); l++) {
+        Level level;
+        level.lineShift = 0;
+        while ((1 << (level.lineShift+1)) <= levels[l].lineSize) {
+            level.lineShift++;
+        }
+        long long num_lines = levels[l].size >> level.lineShift;
+        if (num_lines < 1) { num_lines = 1; }
+        level.assoc = levels[l].assoc;
+        if (level.assoc <= 0 || level.assoc > num_lines) {
+            level.assoc = (int)num_lines;
+        }
+        level.numSets = num_lines / level.assoc;
+        level.tags.assign(level.numSets*level.assoc, 0);
+        level.misses = 0;
+        mLevels.push_back(level);
+    }
+}
+
+int CacheSim::access(unsigned long long addr) {
+    mAccesses++;
+    int missed = 0;
+    while (missed < numLevels() && !lookup(mLevels[missed], addr)) {
+        mLevels[missed].misses++;
+        missed++;
+    }
+    return missed;
+}
+
+bool CacheSim::lookup(Level& level, unsigned long long addr) {
+    // Tags are line numbers plus one so that 0 can mean empty.
+    unsigned long long tag = (addr >> level.lineShift) + 1;
+    unsigned long long* set =
+        &level.tags[(size_t)((tag-1) % level.numSets) * level.assoc];
+    int way = 0;
+    while (way < level.assoc && set[way] != tag && set[way] != 0) {
+        way++;
+    }
+    bool hit = (way < level.assoc && set[way] == tag);
+    // Shift the more recently used lines down and put this line first.
+    // On a miss in a full set this drops the least recently used.
+    if (way == level.assoc) { way--; }
+    for (int k = way; k > 0; k--) {
+        set[k] = set[k-1];
+    }
+    set[0] = tag;
+    return hit;
+}
+
+bool parseCacheLevels(const std::string& spec,
+                      std::vector<CacheLevel>& levels) {
+    levels.clear();
+    std::stringstream list(spec);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        std::stringstream fields(item);
+        std::string size_str, assoc_str, line_str;
+        std::getline(fields, size_str, ':');
+        std::getline(fields, assoc_str, ':');
+        std::getline(fields, line_str, ':');
+        if (size_str.empty()) { return false; }
+
+        CacheLevel level;
+        char* end;
+        level.size = strtoll(size_str.c_str(), &end, 10);
+        switch (*end) {
+            case 'K': case 'k': level.size *= 1024; end++; break;
+            case 'M': case 'm': level.size *= 1024*1024; end++; break;
+            case 'G': case 'g': level.size *= 1024LL*1024*1024; end++; break;
+        }
+        if (*end != '\0' || level.size <= 0) { return false; }
+        level.assoc = assoc_str.empty() ? 0 : atoi(assoc_str.c_str());
+        level.lineSize = line_str.empty() ? 64 : atoi(line_str.c_str());
+        if (level.assoc < 0 || level.lineSize <= 0) { return false; }
+        levels.push_back(level);
+    }
+    return !levels.empty();
+}
@@ -0,0 +1,99 @@
+/*!
+ * \file CacheSim.hpp
+ *
+ * \brief Trace driven simulator of a multi-level set-associative LRU
+ *        cache, and the address stream of the Jacobi 2D stencil.
+ *
+ * Every level is checked in order until one hits, and the line is
+ * then brought into every level that missed.  Writes are treated like
+ * reads, i.e. write-allocate.  Levels are not kept inclusive, so a
+ * line evicted from L2 can still be in L1.
+ *
+ * The address stream is the one from facts.piscc where A(t,i,j) is
+ * stored in the ping/pong buffer t%2 of NxN doubles.  Computing
+ * A(t,i,j) reads the 5 points of A(t-1) and then writes A(t,i,j).
+ */
+#ifndef CACHESIM_HPP_
+#define CACHESIM_HPP_
+
+#include "Tiling.hpp"
+#include "CacheSizes.hpp"
+
+#include <vector>
+#include <string>
+
+class CacheSim {
+  public:
+    // Levels in order starting with L1.  An associativity of 0 means
+    // fully associative.
+    CacheSim(const std::vector<CacheLevel>& levels);
+
+    // Simulates an access to the byte address and returns the number
+    // of levels that missed.
+    int access(unsigned long long addr);
+
+    int numLevels() const { return (int)mLevels.size(); }
+    long long accesses() const { return mAccesses; }
+    long long misses(int level) const { return mLevels[level].misses; }
+
+  private:
+    struct Level {
+        int lineShift;
+        int assoc;
+        long long numSets;
+        // Tags of each set from most to least recently used, 0 is empty.
+        std::vector<unsigned long long> tags;
+        long long misses;
+    };
+
+    // Returns true on a hit and moves the line to most recently used,
+    // otherwise inserts the line and evicts the least recently used.
+    bool lookup(Level& level, unsigned long long addr);
+
+    std::vector<Level> mLevels;
+    long long mAccesses;
+};
+
+// Parses a list of levels like "48K:12,2M:16:64,300M:20" where each
+// level is size:associativity:line size and the line size defaults to
+// 64.  Returns false if the list is malformed.
+bool parseCacheLevels(const std::string& spec,
+                      std::vector<CacheLevel>& levels);
+
+// Simulates the stencil over an NxN grid with the tiling's schedule
+// order and calls per_tile(tile, points, misses) after each tile, where
+// misses[l] is the number of misses in level l during that tile.
+template <typename Tiling, typename F>
+void simulateTiling(const Tiling& tiling, int N, CacheSim& sim, F per_tile) {
+    const unsigned long long elem = sizeof(double);
+    const unsigned long long buf_size = (unsigned long long)N*N*elem;
+    std::vector<long long> before(sim.numLevels()), misses(sim.numLevels());
+    for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront(); w++) {
+        tiling.forEachTile(w, [&](const TileCoord& tile) {
+            for (int l = 0; l < sim.numLevels(); l++) {
+                before[l] = sim.misses(l);
+            }
+            long long points = 0;
+            tiling.forEachRow(tile, [&](int t, int i, int jlo, int jhi) {
+                unsigned long long out = (t&1)*buf_size;
+                unsigned long long in = ((t-1)&1)*buf_size;
+                unsigned long long row = (unsigned long long)i*N;
+                for (int j = jlo; j <= jhi; j++) {
+                    sim.access(in + (row-N+j)*elem);
+                    sim.access(in + (row+j-1)*elem);
+                    sim.access(in + (row+N+j)*elem);
+                    sim.access(in + (row+j+1)*elem);
+                    sim.access(in + (row+j)*elem);
+                    sim.access(out + (row+j)*elem);
+                }
+                points += jhi-jlo+1;
+            });
+            for (int l = 0; l < sim.numLevels(); l++) {
+                misses[l] = sim.misses(l) - before[l];
+            }
+            per_tile(tile, points, misses);
+        });
+    }
+}
+
+#endif
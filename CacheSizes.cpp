@@ -0,0 +1,77 @@
+/*!
+ * \file CacheSizes.cpp
+ *
+ * \brief Implements detectCacheSizes.
+ */
+#include "CacheSizes.hpp"
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Reads one value from /sys/devices/system/cpu/cpu0/cache/index<k>/<name>.
+static std::string readSysCache(int index, const char* name) {
+    std::stringstream path;
+    path << "/sys/devices/system/cpu/cpu0/cache/index" << index << "/"
+         << name;
+    std::ifstream in(path.str().c_str());
+    std::string val;
+    in >> val;
+    return val;
+}
+
+// Sizes in sysfs look like "48K" or "2048K".
+static long long parseSize(const std::string& str) {
+    long long size = atoll(str.c_str());
+    if (!str.empty()) {
+        switch (str[str.size()-1]) {
+            case 'K': size *= 1024; break;
+            case 'M': size *= 1024*1024; break;
+        }
+    }
+    return size;
+}
+
+void detectCacheSizes(CacheLevel levels[NUM_CACHE_LEVELS]) {
+    for (int l = 0; l < NUM_CACHE_LEVELS; l++) {
+        levels[l].size = 0;
+        levels[l].assoc = 0;
+        levels[l].lineSize = 64;
+    }
+
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    long vals[NUM_CACHE_LEVELS][3] = {
+        {sysconf(_SC_LEVEL1_DCACHE_SIZE), sysconf(_SC_LEVEL1_DCACHE_ASSOC),
+         sysconf(_SC_LEVEL1_DCACHE_LINESIZE)},
+        {sysconf(_SC_LEVEL2_CACHE_SIZE), sysconf(_SC_LEVEL2_CACHE_ASSOC),
+         sysconf(_SC_LEVEL2_CACHE_LINESIZE)},
+        {sysconf(_SC_LEVEL3_CACHE_SIZE), sysconf(_SC_LEVEL3_CACHE_ASSOC),
+         sysconf(_SC_LEVEL3_CACHE_LINESIZE)}
+    };
+    for (int l = 0; l < NUM_CACHE_LEVELS; l++) {
+        if (vals[l][0] > 0) { levels[l].size = vals[l][0]; }
+        if (vals[l][1] > 0) { levels[l].assoc = (int)vals[l][1]; }
+        if (vals[l][2] > 0) { levels[l].lineSize = (int)vals[l][2]; }
+    }
+#endif
+
+    // Fill in anything sysconf did not know from sysfs, skipping the
+    // instruction caches.
+    for (int index = 0; index < 8; index++) {
+        std::string type = readSysCache(index, "type");
+        if (type.empty()) { break; }
+        if (type == "Instruction") { continue; }
+        int level = atoi(readSysCache(index, "level").c_str());
+        if (level < 1 || level > NUM_CACHE_LEVELS) { continue; }
+        CacheLevel& cache = levels[level-1];
+        if (cache.size == 0) {
+            cache.size = parseSize(readSysCache(index, "size"));
+        }
+        if (cache.assoc == 0) {
+            cache.assoc = atoi(
+                readSysCache(index, "ways_of_associativity").c_str());
+        }
+    }
+}
@@ -0,0 +1,24 @@
+/*!
+ * \file CacheSizes.hpp
+ *
+ * \brief Detects the sizes of the data caches on this machine.
+ *
+ * Uses sysconf when glibc knows the cache sizes and falls back to
+ * /sys/devices/system/cpu/cpu0/cache otherwise.  Levels that can not be
+ * found have a size of 0.
+ */
+#ifndef CACHESIZES_HPP_
+#define CACHESIZES_HPP_
+
+#define NUM_CACHE_LEVELS 3
+
+struct CacheLevel {
+    long long size;     // in bytes
+    int assoc;
+    int lineSize;       // in bytes
+};
+
+// Fills in levels[0] through levels[NUM_CACHE_LEVELS-1] for L1D, L2, L3.
+void detectCacheSizes(CacheLevel levels[NUM_CACHE_LEVELS]);
+
+#endif
@@ -7,11 +7,14 @@ using namespace std;
 int CellField::sSpacing = 10;
 int CellField::sRadius = 5;
 
-CellField::CellField(int x_start, int y_start, int width, int height) {
+CellField::CellField(int x_start, int y_start, int width, int height,
+                     int spacing, int radius) {
     mXStart = x_start;
     mYStart = y_start;
     mWidth = width;
     mHeight = height;
+    mSpacing = spacing;
+    mRadius = radius;
 
     mLabel = new string*[mHeight];
     mStroke = new string*[mHeight];
@@ -35,14 +38,25 @@ CellField::CellField(int x_start, int y_start, int width, int height) {
     mBoxY2 = NO_BOX;
 }
 
+CellField::~CellField() {
+    for(int i = 0; i < mHeight; i++) {
+        delete [] mLabel[i];
+        delete [] mStroke[i];
+        delete [] mFill[i];
+    }
+    delete [] mLabel;
+    delete [] mStroke;
+    delete [] mFill;
+}
+
 void CellField::printToSVG(SVGPrinter& svg_printer) {
 
     // place a box behind cells if specified
     if(mBoxX1 != NO_BOX) {
-        int x = (mBoxX1) * sSpacing + sSpacing/2;
-        int y = (mHeight - mBoxY2) * sSpacing - sSpacing/2;
-        int w = (mBoxX2 - mBoxX1 + 1) * sSpacing;
-        int h = (mBoxY2 - mBoxY1 + 1) * sSpacing;
+        int x = (mBoxX1) * mSpacing + mSpacing/2;
+        int y = (mHeight - mBoxY2) * mSpacing - mSpacing/2;
+        int w = (mBoxX2 - mBoxX1 + 1) * mSpacing;
+        int h = (mBoxY2 - mBoxY1 + 1) * mSpacing;
 
         svg_printer.printRectangle(mXStart+x, mYStart+y, 
                                    w, h, "darkgrey", "lightgrey");
@@ -51,11 +65,11 @@ void CellField::printToSVG(SVGPrinter& svg_printer) {
     // output the field of cells
     for(int i = 0; i < mHeight; i++) {
         for(int j = 0; j < mWidth; j++) {
-            int x = (j+1) * sSpacing;
-            int y = (mHeight - i) * sSpacing;
+            int x = (j+1) * mSpacing;
+            int y = (mHeight - i) * mSpacing;
             
             svg_printer.printCircle(
-                mXStart+x, mYStart+y, sRadius, mStroke[j][i], mFill[j][i]);
+                mXStart+x, mYStart+y, mRadius, mStroke[j][i], mFill[j][i]);
                 
             svg_printer.printCenteredText(
                 mXStart+x, mYStart+y, mLabel[j][i]);
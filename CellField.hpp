@@ -30,7 +30,10 @@ using namespace std;
  */
 class CellField {
   public:
-    CellField(int x_start, int y_start, int width, int height);
+    // The spacing and radius default to sSpacing and sRadius.
+    CellField(int x_start, int y_start, int width, int height,
+              int spacing = sSpacing, int radius = sRadius);
+    ~CellField();
 
     // File I/O for just this CellField.  SVG file headers and footers
     // must be handled by another file.
@@ -55,6 +58,7 @@ class CellField {
   private:
     int mXStart, mYStart;
     int mWidth; int mHeight;
+    int mSpacing, mRadius;
     string **mLabel;
     string **mStroke;
     string **mFill;
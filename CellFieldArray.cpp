@@ -5,7 +5,8 @@
 using namespace std;
 
 CellFieldArray::CellFieldArray(int num_fields, int width, int height, 
-                               int slice_spacing, int Tstart, int Tend) {
+                               int slice_spacing, int Tstart, int Tend,
+                               int cell_spacing, int cell_radius) {
     // create an array for all fields
     mNumFields = num_fields;
     mArray = new CellField*[mNumFields];
@@ -14,7 +15,8 @@ CellFieldArray::CellFieldArray(int num_fields, int width, int height,
     // But only do the shifting for fields in [Tstart,Tend]
     int count = 0;
     for(int i = 0; i < mNumFields; i++) {
-        mArray[i] = new CellField(0, count*slice_spacing, width, height);
+        mArray[i] = new CellField(0, count*slice_spacing, width, height,
+                                  cell_spacing, cell_radius);
         int t = i+1;
         if (Tstart<=t && t<=Tend) {
             count++;
@@ -22,6 +24,13 @@ CellFieldArray::CellFieldArray(int num_fields, int width, int height,
     }
 }
 
+CellFieldArray::~CellFieldArray() {
+    for(int i = 0; i < mNumFields; i++) {
+        delete mArray[i];
+    }
+    delete [] mArray;
+}
+
 void CellFieldArray::printToSVG(SVGPrinter& svg_printer, int Tstart, int Tend) {
     assert(Tstart>=1 && Tstart<=mNumFields && Tend>=1 && Tend<=mNumFields);
     // -1 because mArray is indexed starting at 0 and t indices start at 1
@@ -31,7 +40,7 @@ void CellFieldArray::printToSVG(SVGPrinter& svg_printer, int Tstart, int Tend) {
 }
 
 void CellFieldArray::setLabel(int t, int x, int y, string label) {
-    assert(t>=1 && t<mNumFields);
+    assert(t>=1 && t<=mNumFields);
     mArray[t-1]->setLabel(x,y,label);
 }
 
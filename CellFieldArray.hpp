@@ -32,7 +32,10 @@ using namespace std;
 class CellFieldArray {
   public:
     CellFieldArray(int num_fields, int width, int height, 
-                   int slice_spacing, int Tstart, int Tend);
+                   int slice_spacing, int Tstart, int Tend,
+                   int cell_spacing = CellField::sSpacing,
+                   int cell_radius = CellField::sRadius);
+    ~CellFieldArray();
 
     // File I/O for just this CellFieldArray.  SVG file headers and footers
     // must be handled by another file.
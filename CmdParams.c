@@ -411,3 +411,90 @@ void CmdParams_parseParams(CmdParams *thee, int argc, char **argv)
         }
     }
 }
+
+char CmdParams_flagForName(CmdParams *thee, const char *paramName)
+/*------------------------------------------------------------*//*!
+  Return the flag character of the parameter with the given name,
+  or '\0' if there is no such parameter.
+*//*--------------------------------------------------------------*/
+{
+    int i;
+    struct cmd_param *cps = thee->cmd_params;
+
+    for (i=0; i<thee->numParams; i++) {
+        if (strcmp(cps[i].paramName, paramName)==0) {
+            return cps[i].flagChar;
+        }
+    }
+    return '\0';
+}
+
+int CmdParams_checkParams(CmdParams *thee, int argc, char **argv,
+                          char *errstr, int errlen)
+/*------------------------------------------------------------*//*!
+  Check argv[1] through argv[argc-1] the way CmdParams_parseParams
+  would, but return 0 with a message in errstr instead of exiting.
+  Returns 1 if parseParams will accept them.  Every parameter has to
+  be given as "-f val", and help is not allowed.  For programs that
+  parse parameters that come from somewhere other than their own
+  command line.
+*//*--------------------------------------------------------------*/
+{
+    int a, i, j, found;
+    char *val, *end;
+    long num;
+    struct cmd_param *cps = thee->cmd_params;
+
+    for (a=1; a<argc; a+=2) {
+        if (argv[a][0]!='-' || argv[a][1]=='\0' || argv[a][2]!='\0') {
+            snprintf(errstr, errlen, "expected a flag instead of %s",
+                     argv[a]);
+            return 0;
+        }
+        for (i=0; i<thee->numParams; i++) {
+            if (cps[i].flagChar == argv[a][1]) { break; }
+        }
+        if (i==thee->numParams) {
+            snprintf(errstr, errlen, "-%c is not a known flag", argv[a][1]);
+            return 0;
+        }
+        if (a+1>=argc) {
+            snprintf(errstr, errlen, "-%c needs a value", argv[a][1]);
+            return 0;
+        }
+        val = argv[a+1];
+        switch(cps[i].paramType) {
+            case paramType_STRING:
+                if (strlen(val) >= MAXPOSSVALSTRING) {
+                    snprintf(errstr, errlen, "-%c value is too long",
+                             argv[a][1]);
+                    return 0;
+                }
+                break;
+            case paramType_INT:
+                num = strtol(val, &end, 10);
+                if (*val=='\0' || *end!='\0' || num < cps[i].startRange
+                        || num > cps[i].endRange) {
+                    snprintf(errstr, errlen, "-%c %s is out of range",
+                             argv[a][1], val);
+                    return 0;
+                }
+                break;
+            case paramType_ENUM:
+                found = 0;
+                for (j=0; j<cps[i].numPairs; j++) {
+                    if (strcmp(val, cps[i].possibleStrings[j].string)==0) {
+                        found = 1;
+                    }
+                }
+                if (!found) {
+                    snprintf(errstr, errlen,
+                             "-%c %s is not in list of possible strings",
+                             argv[a][1], val);
+                    return 0;
+                }
+                break;
+        }
+    }
+    return 1;
+}
@@ -135,4 +135,8 @@ int CmdParams_getValue(CmdParams* thee, char whichFlag);
 
 char* CmdParams_getString(CmdParams* thee, char whichFlag);
 
+char CmdParams_flagForName(CmdParams *thee, const char *paramName);
+int CmdParams_checkParams(CmdParams *thee, int argc, char **argv,
+                          char *errstr, int errlen);
+
 #endif
@@ -3,6 +3,13 @@
  *
  * \brief Implements ColorInfo.
  *
+ * The perfect hash is hash and displace: a name goes to one of
+ * COLOR_BUCKETS buckets with seed 0, and each bucket has its own seed
+ * that sends its names to free slots of a COLOR_SLOTS table.  The
+ * seeds are searched for by buildColorHash when this file compiles,
+ * biggest bucket first, and a static_assert fails the build if the
+ * table is changed so that there is no perfect hash.
+ *
  * \date Started: 12/19/14
  *
  * \authors Michelle Strout
@@ -13,6 +20,12 @@
 
 #include "ColorInfo.hpp"
 
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
 // Since I don't want to install boost.
 // http://stackoverflow.com/questions/236129/split-a-string-in-c
 std::vector<std::string> &split(const std::string &s, char delim,
@@ -31,76 +44,336 @@ std::vector<std::string> split(const std::string &s, char delim) {
     return elems;
 }
 
+namespace {
 
-Color::Color(int pR, int pG, int pB, std::string hc) 
-    : r(pR), g(pG), b(pB), hexcode(hc) { }
-Color::Color() : r(0), g(0), b(0) {}
-Color::Color(const Color& other) 
-    : r(other.r), g(other.g), b(other.b), hexcode(other.hexcode) {}
-
-ColorInfo::ColorInfo(std::string filename) {
-    std::cout << "In constructor" << std::endl;
-    
-    std::ifstream infile;
-    infile.open(filename);
-    std::string line;
-    if (infile.is_open()) {
-        std::vector<std::string> tokens;
-        
-        // Grab all the tokens from the file.
-        std::copy(std::istream_iterator<std::string>(infile),
-                  std::istream_iterator<std::string>(),
-                  std::back_inserter(tokens));
-
-        // Assuming color name, hex code, and rgb, then can unpack rgb.
-        for (int i=0; i<tokens.size(); i+=3) {
-            // getting rgb and hexcode
-            std::vector<std::string> rgbstring = split(tokens[i+2], ',');
-            
-            colorMap[tokens[i]] = Color(std::stoi(rgbstring[0]),
-                                        std::stoi(rgbstring[1]),
-                                        std::stoi(rgbstring[2]),
-                                        tokens[i+1]);                            
+struct NamedColor {
+    const char* name;
+    const char* hexcode;
+    unsigned int rgb;       // 0xRRGGBB
+};
+
+// SVG 1.1 color keywords in alphabetical order.
+constexpr NamedColor svgColorTable[] = {
+    {"aliceblue", "#f0f8ff", 0xf0f8ff},
+    {"antiquewhite", "#faebd7", 0xfaebd7},
+    {"aqua", "#00ffff", 0x00ffff},
+    {"aquamarine", "#7fffd4", 0x7fffd4},
+    {"azure", "#f0ffff", 0xf0ffff},
+    {"beige", "#f5f5dc", 0xf5f5dc},
+    {"bisque", "#ffe4c4", 0xffe4c4},
+    {"black", "#000000", 0x000000},
+    {"blanchedalmond", "#ffebcd", 0xffebcd},
+    {"blue", "#0000ff", 0x0000ff},
+    {"blueviolet", "#8a2be2", 0x8a2be2},
+    {"brown", "#a52a2a", 0xa52a2a},
+    {"burlywood", "#deb887", 0xdeb887},
+    {"cadetblue", "#5f9ea0", 0x5f9ea0},
+    {"chartreuse", "#7fff00", 0x7fff00},
+    {"chocolate", "#d2691e", 0xd2691e},
+    {"coral", "#ff7f50", 0xff7f50},
+    {"cornflowerblue", "#6495ed", 0x6495ed},
+    {"cornsilk", "#fff8dc", 0xfff8dc},
+    {"crimson", "#dc143c", 0xdc143c},
+    {"cyan", "#00ffff", 0x00ffff},
+    {"darkblue", "#00008b", 0x00008b},
+    {"darkcyan", "#008b8b", 0x008b8b},
+    {"darkgoldenrod", "#b8860b", 0xb8860b},
+    {"darkgray", "#a9a9a9", 0xa9a9a9},
+    {"darkgreen", "#006400", 0x006400},
+    {"darkgrey", "#a9a9a9", 0xa9a9a9},
+    {"darkkhaki", "#bdb76b", 0xbdb76b},
+    {"darkmagenta", "#8b008b", 0x8b008b},
+    {"darkolivegreen", "#556b2f", 0x556b2f},
+    {"darkorange", "#ff8c00", 0xff8c00},
+    {"darkorchid", "#9932cc", 0x9932cc},
+    {"darkred", "#8b0000", 0x8b0000},
+    {"darksalmon", "#e9967a", 0xe9967a},
+    {"darkseagreen", "#8fbc8f", 0x8fbc8f},
+    {"darkslateblue", "#483d8b", 0x483d8b},
+    {"darkslategray", "#2f4f4f", 0x2f4f4f},
+    {"darkslategrey", "#2f4f4f", 0x2f4f4f},
+    {"darkturquoise", "#00ced1", 0x00ced1},
+    {"darkviolet", "#9400d3", 0x9400d3},
+    {"deeppink", "#ff1493", 0xff1493},
+    {"deepskyblue", "#00bfff", 0x00bfff},
+    {"dimgray", "#696969", 0x696969},
+    {"dimgrey", "#696969", 0x696969},
+    {"dodgerblue", "#1e90ff", 0x1e90ff},
+    {"firebrick", "#b22222", 0xb22222},
+    {"floralwhite", "#fffaf0", 0xfffaf0},
+    {"forestgreen", "#228b22", 0x228b22},
+    {"fuchsia", "#ff00ff", 0xff00ff},
+    {"gainsboro", "#dcdcdc", 0xdcdcdc},
+    {"ghostwhite", "#f8f8ff", 0xf8f8ff},
+    {"gold", "#ffd700", 0xffd700},
+    {"goldenrod", "#daa520", 0xdaa520},
+    {"gray", "#808080", 0x808080},
+    {"grey", "#808080", 0x808080},
+    {"green", "#008000", 0x008000},
+    {"greenyellow", "#adff2f", 0xadff2f},
+    {"honeydew", "#f0fff0", 0xf0fff0},
+    {"hotpink", "#ff69b4", 0xff69b4},
+    {"indianred", "#cd5c5c", 0xcd5c5c},
+    {"indigo", "#4b0082", 0x4b0082},
+    {"ivory", "#fffff0", 0xfffff0},
+    {"khaki", "#f0e68c", 0xf0e68c},
+    {"lavender", "#e6e6fa", 0xe6e6fa},
+    {"lavenderblush", "#fff0f5", 0xfff0f5},
+    {"lawngreen", "#7cfc00", 0x7cfc00},
+    {"lemonchiffon", "#fffacd", 0xfffacd},
+    {"lightblue", "#add8e6", 0xadd8e6},
+    {"lightcoral", "#f08080", 0xf08080},
+    {"lightcyan", "#e0ffff", 0xe0ffff},
+    {"lightgoldenrodyellow", "#fafad2", 0xfafad2},
+    {"lightgray", "#d3d3d3", 0xd3d3d3},
+    {"lightgreen", "#90ee90", 0x90ee90},
+    {"lightgrey", "#d3d3d3", 0xd3d3d3},
+    {"lightpink", "#ffb6c1", 0xffb6c1},
+    {"lightsalmon", "#ffa07a", 0xffa07a},
+    {"lightseagreen", "#20b2aa", 0x20b2aa},
+    {"lightskyblue", "#87cefa", 0x87cefa},
+    {"lightslategray", "#778899", 0x778899},
+    {"lightslategrey", "#778899", 0x778899},
+    {"lightsteelblue", "#b0c4de", 0xb0c4de},
+    {"lightyellow", "#ffffe0", 0xffffe0},
+    {"lime", "#00ff00", 0x00ff00},
+    {"limegreen", "#32cd32", 0x32cd32},
+    {"linen", "#faf0e6", 0xfaf0e6},
+    {"magenta", "#ff00ff", 0xff00ff},
+    {"maroon", "#800000", 0x800000},
+    {"mediumaquamarine", "#66cdaa", 0x66cdaa},
+    {"mediumblue", "#0000cd", 0x0000cd},
+    {"mediumorchid", "#ba55d3", 0xba55d3},
+    {"mediumpurple", "#9370db", 0x9370db},
+    {"mediumseagreen", "#3cb371", 0x3cb371},
+    {"mediumslateblue", "#7b68ee", 0x7b68ee},
+    {"mediumspringgreen", "#00fa9a", 0x00fa9a},
+    {"mediumturquoise", "#48d1cc", 0x48d1cc},
+    {"mediumvioletred", "#c71585", 0xc71585},
+    {"midnightblue", "#191970", 0x191970},
+    {"mintcream", "#f5fffa", 0xf5fffa},
+    {"mistyrose", "#ffe4e1", 0xffe4e1},
+    {"moccasin", "#ffe4b5", 0xffe4b5},
+    {"navajowhite", "#ffdead", 0xffdead},
+    {"navy", "#000080", 0x000080},
+    {"oldlace", "#fdf5e6", 0xfdf5e6},
+    {"olive", "#808000", 0x808000},
+    {"olivedrab", "#6b8e23", 0x6b8e23},
+    {"orange", "#ffa500", 0xffa500},
+    {"orangered", "#ff4500", 0xff4500},
+    {"orchid", "#da70d6", 0xda70d6},
+    {"palegoldenrod", "#eee8aa", 0xeee8aa},
+    {"palegreen", "#98fb98", 0x98fb98},
+    {"paleturquoise", "#afeeee", 0xafeeee},
+    {"palevioletred", "#db7093", 0xdb7093},
+    {"papayawhip", "#ffefd5", 0xffefd5},
+    {"peachpuff", "#ffdab9", 0xffdab9},
+    {"peru", "#cd853f", 0xcd853f},
+    {"pink", "#ffc0cb", 0xffc0cb},
+    {"plum", "#dda0dd", 0xdda0dd},
+    {"powderblue", "#b0e0e6", 0xb0e0e6},
+    {"purple", "#800080", 0x800080},
+    {"red", "#ff0000", 0xff0000},
+    {"rosybrown", "#bc8f8f", 0xbc8f8f},
+    {"royalblue", "#4169e1", 0x4169e1},
+    {"saddlebrown", "#8b4513", 0x8b4513},
+    {"salmon", "#fa8072", 0xfa8072},
+    {"sandybrown", "#f4a460", 0xf4a460},
+    {"seagreen", "#2e8b57", 0x2e8b57},
+    {"seashell", "#fff5ee", 0xfff5ee},
+    {"sienna", "#a0522d", 0xa0522d},
+    {"silver", "#c0c0c0", 0xc0c0c0},
+    {"skyblue", "#87ceeb", 0x87ceeb},
+    {"slateblue", "#6a5acd", 0x6a5acd},
+    {"slategray", "#708090", 0x708090},
+    {"slategrey", "#708090", 0x708090},
+    {"snow", "#fffafa", 0xfffafa},
+    {"springgreen", "#00ff7f", 0x00ff7f},
+    {"steelblue", "#4682b4", 0x4682b4},
+    {"tan", "#d2b48c", 0xd2b48c},
+    {"teal", "#008080", 0x008080},
+    {"thistle", "#d8bfd8", 0xd8bfd8},
+    {"tomato", "#ff6347", 0xff6347},
+    {"turquoise", "#40e0d0", 0x40e0d0},
+    {"violet", "#ee82ee", 0xee82ee},
+    {"wheat", "#f5deb3", 0xf5deb3},
+    {"white", "#ffffff", 0xffffff},
+    {"whitesmoke", "#f5f5f5", 0xf5f5f5},
+    {"yellow", "#ffff00", 0xffff00},
+    {"yellowgreen", "#9acd32", 0x9acd32}
+};
+
+constexpr int NUM_SVG_COLORS = sizeof(svgColorTable)/sizeof(svgColorTable[0]);
+constexpr int COLOR_BUCKETS = 64;
+constexpr int COLOR_SLOTS = 256;
+constexpr int MAX_COLOR_SEED = 1<<16;
+static_assert(NUM_SVG_COLORS == 147, "the SVG color table is incomplete");
+
+// FNV-1a with the seed mixed into the starting value.
+constexpr unsigned int hashColorName(const char* s, unsigned int seed) {
+    unsigned int h = 2166136261u ^ (seed*0x9e3779b9u);
+    for (; *s; s++) {
+        h = (h ^ (unsigned char)*s) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+struct ColorHash {
+    bool perfect;
+    unsigned short seed[COLOR_BUCKETS];
+    short slot[COLOR_SLOTS];        // index into svgColorTable or -1
+};
+
+constexpr ColorHash buildColorHash() {
+    ColorHash hash = {true, {}, {}};
+    for (int s = 0; s < COLOR_SLOTS; s++) { hash.slot[s] = -1; }
+    int bucket_of[NUM_SVG_COLORS] = {};
+    int size[COLOR_BUCKETS] = {};
+    for (int c = 0; c < NUM_SVG_COLORS; c++) {
+        bucket_of[c] = hashColorName(svgColorTable[c].name, 0)
+                       % COLOR_BUCKETS;
+        size[bucket_of[c]]++;
+    }
+    bool placed[COLOR_BUCKETS] = {};
+    for (int n = 0; n < COLOR_BUCKETS; n++) {
+        // Biggest bucket that is left.
+        int b = -1;
+        for (int k = 0; k < COLOR_BUCKETS; k++) {
+            if (!placed[k] && (b < 0 || size[k] > size[b])) { b = k; }
+        }
+        placed[b] = true;
+        if (size[b] == 0) { continue; }
+        bool found = false;
+        for (int seed = 1; seed < MAX_COLOR_SEED && !found; seed++) {
+            found = true;
+            for (int c = 0; c < NUM_SVG_COLORS; c++) {
+                if (bucket_of[c] != b) { continue; }
+                int s = hashColorName(svgColorTable[c].name, seed)
+                        % COLOR_SLOTS;
+                if (hash.slot[s] >= 0) {
+                    found = false;
+                    break;
+                }
+                hash.slot[s] = (short)c;
+            }
+            if (!found) {
+                // Take back the slots of this bucket, keeping the ones
+                // earlier buckets hold.
+                for (int s = 0; s < COLOR_SLOTS; s++) {
+                    if (hash.slot[s] >= 0 && bucket_of[hash.slot[s]] == b) {
+                        hash.slot[s] = -1;
+                    }
+                }
+            } else {
+                hash.seed[b] = (unsigned short)seed;
+            }
         }
+        if (!found) { hash.perfect = false; }
+    }
+    return hash;
+}
+
+constexpr ColorHash colorHash = buildColorHash();
+static_assert(colorHash.perfect, "no perfect hash for the SVG colors");
+
+// Index in svgColorTable of the name, or -1.
+int findSvgColor(const char* name) {
+    int b = hashColorName(name, 0) % COLOR_BUCKETS;
+    int c = colorHash.slot[hashColorName(name, colorHash.seed[b])
+                           % COLOR_SLOTS];
+    return (c >= 0 && strcmp(svgColorTable[c].name, name) == 0) ? c : -1;
+}
+
+}
 
-    } else {
-        std::cout << "File not found: " << filename << std::endl;
-        exit(0);
+Color::Color(int pR, int pG, int pB, std::string hc)
+    : hexcode(hc), r(pR), g(pG), b(pB) { }
+Color::Color() : r(0), g(0), b(0) {}
+Color::Color(const Color& other)
+    : name(other.name), hexcode(other.hexcode),
+      r(other.r), g(other.g), b(other.b) {}
+
+ColorInfo::ColorInfo() {
+    mColors.reserve(NUM_SVG_COLORS);
+    for (int c = 0; c < NUM_SVG_COLORS; c++) {
+        const NamedColor& nc = svgColorTable[c];
+        Color color((nc.rgb >> 16) & 0xff, (nc.rgb >> 8) & 0xff,
+                    nc.rgb & 0xff, nc.hexcode);
+        color.name = nc.name;
+        mColors.push_back(color);
     }
+}
 
+ColorInfo::ColorInfo(std::string filename) : ColorInfo() {
+    readFile(filename);
 }
 
-// The below 3 getters will return black if the given color is not found.
+void ColorInfo::readFile(const std::string& filename) {
+    std::ifstream infile(filename.c_str());
+    if (!infile.is_open()) {
+        std::cerr << "File not found: " << filename
+                  << ", using the built in colors" << std::endl;
+        return;
+    }
+    // Assuming color name, hex code, and rgb, then can unpack rgb.
+    std::string name, hexcode, rgb;
+    while (infile >> name >> hexcode >> rgb) {
+        std::vector<std::string> rgbstring = split(rgb, ',');
+        int value[3];
+        bool ok = (rgbstring.size() == 3);
+        for (int k = 0; ok && k < 3; k++) {
+            const char* field = rgbstring[k].c_str();
+            char* end;
+            long v = strtol(field, &end, 10);
+            ok = (end != field && *end == '\0' && v >= 0 && v <= 255);
+            value[k] = (int)v;
+        }
+        if (!ok) {
+            std::cerr << "Bad rgb for color " << name << " in " << filename
+                      << ": " << rgb << std::endl;
+            continue;
+        }
+        Color color(value[0], value[1], value[2], hexcode);
+        color.name = name;
+        int index = lookup(name);
+        if (index >= 0) {
+            mColors[index] = color;
+        } else {
+            mExtraColors[name] = (int)mColors.size();
+            mColors.push_back(color);
+        }
+    }
+}
+
+int ColorInfo::lookup(const std::string& colorname) const {
+    int index = findSvgColor(colorname.c_str());
+    if (index >= 0 || mExtraColors.empty()) { return index; }
+    std::map<std::string,int>::const_iterator iter
+        = mExtraColors.find(colorname);
+    return (iter != mExtraColors.end()) ? iter->second : -1;
+}
+
+int ColorInfo::lookupOrBlack(const std::string& colorname) const {
+    int index = lookup(colorname);
+    return (index >= 0) ? index : findSvgColor("black");
+}
 
 int ColorInfo::getR( std::string colorname ) {
-    if (colorMap.find( colorname ) != colorMap.end() ) {
-        return colorMap[colorname].r;
-    } else {
-        return 0;
-    }
+    return color(lookupOrBlack(colorname)).r;
 }
 
 int ColorInfo::getG( std::string colorname ) {
-    if (colorMap.find( colorname ) != colorMap.end() ) {
-        return colorMap[colorname].g;
-    } else {
-        return 0;
-    }
+    return color(lookupOrBlack(colorname)).g;
 }
 
 int ColorInfo::getB( std::string colorname ) {
-    if (colorMap.find( colorname ) != colorMap.end() ) {
-        return colorMap[colorname].b;
-    } else {
-        return 0;
-    }
+    return color(lookupOrBlack(colorname)).b;
+}
+
+unsigned int ColorInfo::getRGB( std::string colorname ) {
+    return color(lookupOrBlack(colorname)).rgb();
 }
 
-// FIXME
 std::string ColorInfo::getHexCode( std::string colorname ) {
-    if (colorMap.find( colorname ) != colorMap.end() ) {
-        return colorMap[colorname].hexcode;
-    } else {
-        return "#000000";
-    }
+    return color(lookupOrBlack(colorname)).hexcode;
 }
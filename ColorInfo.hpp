@@ -3,11 +3,16 @@
  *
  * \brief Object for storing SVG color names with rgb values.
  *
- * Upon construction, reads in the specified file.  File needs to
- * be in the following format;
+ * The 147 SVG color names are compiled in, see ColorInfo.cpp, and are
+ * found with a perfect hash that is built at compile time, so a name
+ * is resolved with one hash and one string compare.  lookup() returns
+ * an index and color(index) is an array access, so code that draws
+ * many points should resolve its color names once and keep indices.
+ *
+ * An optional file can override or add colors.  It needs to be in the
+ * following format;
  *      	aliceblue	#f0f8ff	240,248,255
  *          ...
- * After that rgb values can be queried by color name.
  *
  * RGB values for colors, found here
  * http://webdesign.about.com/od/colorcharts/l/bl_namedcolors.htm
@@ -22,10 +27,7 @@
 #ifndef COLORINFO_HPP_
 #define COLORINFO_HPP_
 
-#include <fstream>
 #include <string>
-#include <sstream>
-#include <iostream>
 #include <vector>
 #include <map>
 
@@ -34,6 +36,9 @@ class Color {
     Color(int pR, int pG, int pB, std::string hc);
     Color();
     Color(const Color&);
+    Color& operator=(const Color&) = default;
+    // Packed as 0xRRGGBB.
+    unsigned int rgb() const { return (r << 16) | (g << 8) | b; }
     std::string name;
     std::string hexcode;
     int r;
@@ -43,17 +48,31 @@ class Color {
 
 class ColorInfo {
   public:
+    // Only the compiled in colors.
+    ColorInfo();
+    // Compiled in colors with the colors in filename replacing them.
+    // A file that can not be opened is reported and ignored.
     ColorInfo(std::string filename);
 
+    // Index of the color, or -1 if it is not known.
+    int lookup(const std::string& colorname) const;
+    // Index of the color, or of black if it is not known.
+    int lookupOrBlack(const std::string& colorname) const;
+    const Color& color(int index) const { return mColors[index]; }
+
+    // The below return black if the given color is not found.
     int getR( std::string colorname );
     int getG( std::string colorname );
     int getB( std::string colorname );
-    
+    unsigned int getRGB( std::string colorname );
     std::string getHexCode( std::string colorname );
 
   private:
-    std::map<std::string,Color> colorMap;
+    void readFile(const std::string& filename);
 
+    std::vector<Color> mColors;
+    // Colors from the file that are not compiled in.
+    std::map<std::string,int> mExtraColors;
 };
 
-#endif
\ No newline at end of file
+#endif
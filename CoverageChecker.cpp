@@ -0,0 +1,159 @@
+/*!
+ * \file CoverageChecker.cpp
+ *
+ * \brief Implements the packed counters of CoverageChecker.
+ *
+ * A counter is two bits, lo in the even bit and hi in the odd bit:
+ * 00 is not visited, 01 is visited once, and 10 is visited more than
+ * once.  Incrementing sets hi to hi|lo and lo to !hi&!lo, which is done
+ * for 32 counters at a time with masks.
+ */
+#include "CoverageChecker.hpp"
+
+static const uint64_t LO_BITS = 0x5555555555555555ULL;
+
+// Mask of the lo bits of the counters first..last within one word.
+static uint64_t counterMask(int first, int last) {
+    uint64_t mask = LO_BITS;
+    mask &= ~(uint64_t)0 << (2*first);
+    if (last < 31) { mask &= ((uint64_t)1 << (2*last+2)) - 1; }
+    return mask;
+}
+
+CoverageChecker::CoverageChecker(int T, int Li, int Ui, int Lj, int Uj,
+                                 int max_hole_rows)
+    : mT(T), mLi(Li), mUi(Ui), mLj(Lj), mUj(Uj),
+      mMaxHoleRows(max_hole_rows),
+      mRowWords((Uj-Lj+1+31)/32),
+      mCounts((size_t)T*(Ui-Li+1)*((Uj-Lj+1+31)/32)) {
+    clear();
+}
+
+void CoverageChecker::clear() {
+    for (size_t k = 0; k < mCounts.size(); k++) {
+        mCounts[k].store(0, std::memory_order_relaxed);
+    }
+    mReport.points = (long long)mT*(mUi-mLi+1)*(mUj-mLj+1);
+    mReport.visits = 0;
+    mReport.holes = 0;
+    mReport.duplicates = 0;
+    mReport.outside = 0;
+    mReport.holeRows.clear();
+    mReport.tiles.clear();
+}
+
+long long CoverageChecker::countRow(int t, int i, int jlo, int jhi) {
+    if (jlo > jhi) { return 0; }
+    long long span = jhi-jlo+1;
+    if (t < 1 || t > mT || i < mLi || i > mUi) { return span; }
+    int first = imax(jlo, mLj)-mLj, last = imin(jhi, mUj)-mLj;
+    if (first > last) { return span; }
+    std::atomic<uint64_t>* words = rowWords(t, i);
+    for (int w = first/32; w <= last/32; w++) {
+        uint64_t mask = counterMask((w == first/32) ? first%32 : 0,
+                                    (w == last/32) ? last%32 : 31);
+        uint64_t old = words[w].load(std::memory_order_relaxed);
+        uint64_t word;
+        do {
+            uint64_t lo = old & mask;
+            uint64_t hi = (old >> 1) & mask;
+            word = (old & ~(mask | mask<<1)) | ((hi | lo) << 1)
+                 | (~hi & ~lo & mask);
+        } while (!words[w].compare_exchange_weak(old, word,
+                                                 std::memory_order_relaxed));
+    }
+    return span - (last-first+1);
+}
+
+void CoverageChecker::blameRow(CoverageTile& tc, int t, int i, int jlo,
+                               int jhi) const {
+    if (jlo > jhi) { return; }
+    long long span = jhi-jlo+1;
+    if (t < 1 || t > mT || i < mLi || i > mUi) {
+        tc.outside += span;
+        return;
+    }
+    int first = imax(jlo, mLj)-mLj, last = imin(jhi, mUj)-mLj;
+    if (first > last) {
+        tc.outside += span;
+        return;
+    }
+    tc.outside += span - (last-first+1);
+    const std::atomic<uint64_t>* words = rowWords(t, i);
+    for (int w = first/32; w <= last/32; w++) {
+        uint64_t mask = counterMask((w == first/32) ? first%32 : 0,
+                                    (w == last/32) ? last%32 : 31);
+        uint64_t hi = (words[w].load(std::memory_order_relaxed) >> 1) & mask;
+        tc.duplicates += __builtin_popcountll(hi);
+    }
+}
+
+void CoverageChecker::scan() {
+    int width = mUj-mLj+1;
+    for (int t = 1; t <= mT; t++) {
+        for (int i = mLi; i <= mUi; i++) {
+            const std::atomic<uint64_t>* words = rowWords(t, i);
+            int hole_start = -1;
+            for (int w = 0; w < mRowWords; w++) {
+                uint64_t word = words[w].load(std::memory_order_relaxed);
+                uint64_t valid = counterMask(0, imin(31, width-1-32*w));
+                uint64_t lo = word & valid;
+                uint64_t hi = (word >> 1) & valid;
+                mReport.duplicates += __builtin_popcountll(hi);
+                uint64_t empty = ~(lo | hi) & valid;
+                mReport.holes += __builtin_popcountll(empty);
+                if (empty == 0 && hole_start < 0) { continue; }
+                // Walk the counters to find the hole spans.
+                int n = imin(32, width-32*w);
+                for (int k = 0; k < n; k++) {
+                    bool is_hole = (empty >> (2*k)) & 1;
+                    int j = 32*w + k;
+                    if (is_hole && hole_start < 0) { hole_start = j; }
+                    if (!is_hole && hole_start >= 0) {
+                        if ((int)mReport.holeRows.size() < mMaxHoleRows) {
+                            CoverageHole hole = {t, i, mLj+hole_start,
+                                                 mLj+j-1};
+                            mReport.holeRows.push_back(hole);
+                        }
+                        hole_start = -1;
+                    }
+                }
+            }
+            if (hole_start >= 0
+                && (int)mReport.holeRows.size() < mMaxHoleRows) {
+                CoverageHole hole = {t, i, mLj+hole_start, mUj};
+                mReport.holeRows.push_back(hole);
+            }
+        }
+    }
+}
+
+void printCoverageReport(std::ostream& out, const CoverageReport& report,
+                         int max_tiles) {
+    out << "points = " << report.points << ", visits = " << report.visits
+        << ", holes = " << report.holes
+        << ", duplicated points = " << report.duplicates
+        << ", visits outside = " << report.outside << std::endl;
+    for (size_t k = 0; k < report.holeRows.size(); k++) {
+        const CoverageHole& hole = report.holeRows[k];
+        out << "hole: t = " << hole.t << ", i = " << hole.i << ", j = "
+            << hole.jlo << ".." << hole.jhi << std::endl;
+    }
+    if (report.holes > 0 && report.holeRows.size() > 0) {
+        out << "(holes are listed for the first " << report.holeRows.size()
+            << " rows with holes)" << std::endl;
+    }
+    for (size_t k = 0; k < report.tiles.size() && (int)k < max_tiles; k++) {
+        const CoverageTile& tc = report.tiles[k];
+        out << "tile (" << tc.tile.c0 << "," << tc.tile.c1 << ","
+            << tc.tile.c2 << "): " << tc.duplicates
+            << " visits to duplicated points, " << tc.outside
+            << " visits outside" << std::endl;
+    }
+    if ((int)report.tiles.size() > max_tiles) {
+        out << "... and " << report.tiles.size()-max_tiles << " more tiles"
+            << std::endl;
+    }
+    out << (report.exactlyOnce() ? "exactly once" : "not exactly once")
+        << std::endl;
+}
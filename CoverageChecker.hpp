@@ -0,0 +1,185 @@
+/*!
+ * \file CoverageChecker.hpp
+ *
+ * \brief Checks that a traversal visits every point of the Jacobi 2D
+ *        iteration space exactly once.
+ *
+ * Each point 1<=t<=T, Li<=i<=Ui, Lj<=j<=Uj has a two bit counter that
+ * saturates at 2 (visited more than once), 32 to a 64 bit word, and
+ * each (t,i) row of counters starts on a word so that a row span of a
+ * tile is counted with one compare and swap per word.
+ *
+ * The first pass counts.  Then the counters are scanned for holes
+ * (never visited) and duplicates, and if there are duplicates or visits
+ * outside the space a second pass finds the tiles responsible, so the
+ * report is the same however the tiles were scheduled.  A tiling
+ * should pass this check before its traversal replaces a generated one.
+ */
+#ifndef COVERAGECHECKER_HPP_
+#define COVERAGECHECKER_HPP_
+
+#include "Tiling.hpp"
+
+#include <vector>
+#include <atomic>
+#include <unordered_map>
+#include <iostream>
+#include <stdint.h>
+
+// A tile that visits points more than once or outside of the space.
+struct CoverageTile {
+    TileCoord tile;
+    long long duplicates;   // visits to points visited more than once
+    long long outside;      // visits outside of the iteration space
+};
+
+// Consecutive points in row (t,i) that were never visited.
+struct CoverageHole {
+    int t, i, jlo, jhi;
+};
+
+struct CoverageReport {
+    long long points;       // points in the iteration space
+    long long visits;       // including duplicates and outside
+    long long holes;        // points never visited
+    long long duplicates;   // points visited more than once
+    long long outside;      // visits outside of the iteration space
+    std::vector<CoverageHole> holeRows;     // at most maxHoleRows
+    std::vector<CoverageTile> tiles;        // in traversal order
+
+    bool exactlyOnce() const {
+        return holes == 0 && duplicates == 0 && outside == 0;
+    }
+};
+
+// Prints the totals, the hole rows, and the first max_tiles tiles.
+void printCoverageReport(std::ostream& out, const CoverageReport& report,
+                         int max_tiles = 20);
+
+class CoverageChecker {
+  public:
+    // Iteration space is 1<=t<=T, Li<=i<=Ui, Lj<=j<=Uj.  Only the
+    // first max_hole_rows rows with holes are listed in the report.
+    CoverageChecker(int T, int Li, int Ui, int Lj, int Uj,
+                    int max_hole_rows = 20);
+
+    // Visits the tiles of each wavefront in parallel with OpenMP.
+    template <typename Tiling>
+    const CoverageReport& checkTiling(const Tiling& tiling) {
+        clear();
+        std::vector<TileCoord> tiles;
+        std::vector<CoverageTile> found;
+        long long outside = 0, visits = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int w = tiling.firstWavefront();
+                 w <= tiling.lastWavefront(); w++) {
+                tiles.clear();
+                tiling.forEachTile(w, [&](const TileCoord& tile) {
+                    tiles.push_back(tile);
+                });
+                int num_tiles = (int)tiles.size();
+                found.resize(num_tiles);
+#ifdef _OPENMP
+                #pragma omp parallel for schedule(dynamic) \
+                    reduction(+:outside,visits)
+#endif
+                for (int k = 0; k < num_tiles; k++) {
+                    CoverageTile& tc = found[k];
+                    tc.tile = tiles[k];
+                    tc.duplicates = 0;
+                    tc.outside = 0;
+                    tiling.forEachRow(tiles[k],
+                        [&](int t, int i, int jlo, int jhi) {
+                            if (pass == 0) {
+                                long long n = countRow(t, i, jlo, jhi);
+                                visits += (jhi >= jlo) ? jhi-jlo+1 : 0;
+                                outside += n;
+                            } else {
+                                blameRow(tc, t, i, jlo, jhi);
+                            }
+                        });
+                }
+                if (pass == 1) {
+                    for (int k = 0; k < num_tiles; k++) {
+                        if (found[k].duplicates > 0 || found[k].outside > 0) {
+                            mReport.tiles.push_back(found[k]);
+                        }
+                    }
+                }
+            }
+            if (pass == 0) {
+                mReport.visits = visits;
+                mReport.outside = outside;
+                scan();
+                if (mReport.duplicates == 0 && mReport.outside == 0) { break; }
+            }
+        }
+        return mReport;
+    }
+
+    // For traversals that are not tilings.  traverse(f) has to call
+    // f(tile,t,i,j) for every point it visits, and is called twice if
+    // there are duplicates or points outside.
+    template <typename Traverse>
+    const CoverageReport& checkTraversal(Traverse traverse) {
+        clear();
+        long long outside = 0, visits = 0;
+        traverse([&](const TileCoord&, int t, int i, int j) {
+            outside += countRow(t, i, j, j);
+            visits++;
+        });
+        mReport.visits = visits;
+        mReport.outside = outside;
+        scan();
+        if (mReport.duplicates == 0 && mReport.outside == 0) {
+            return mReport;
+        }
+        // Tiles in the order they are first visited.
+        std::unordered_map<long long,size_t> index;
+        traverse([&](const TileCoord& tile, int t, int i, int j) {
+            CoverageTile tc = {tile, 0, 0};
+            blameRow(tc, t, i, j, j);
+            if (tc.duplicates == 0 && tc.outside == 0) { return; }
+            long long key = ((long long)(tile.c0 & 0x1fffff) << 42)
+                          | ((long long)(tile.c1 & 0x1fffff) << 21)
+                          | (tile.c2 & 0x1fffff);
+            std::unordered_map<long long,size_t>::iterator iter
+                = index.find(key);
+            if (iter == index.end()) {
+                index[key] = mReport.tiles.size();
+                mReport.tiles.push_back(tc);
+            } else {
+                mReport.tiles[iter->second].duplicates += tc.duplicates;
+                mReport.tiles[iter->second].outside += tc.outside;
+            }
+        });
+        return mReport;
+    }
+
+    const CoverageReport& report() const { return mReport; }
+
+  private:
+    void clear();
+    // Counts a visit to each point of the row span in the space and
+    // returns the number of points outside.
+    long long countRow(int t, int i, int jlo, int jhi);
+    // Adds the duplicate and outside visits of the row span to tc.
+    void blameRow(CoverageTile& tc, int t, int i, int jlo, int jhi) const;
+    // Fills in holes, holeRows, and duplicates from the counters.
+    void scan();
+
+    std::atomic<uint64_t>* rowWords(int t, int i) {
+        return &mCounts[((long long)(t-1)*(mUi-mLi+1) + (i-mLi))*mRowWords];
+    }
+    const std::atomic<uint64_t>* rowWords(int t, int i) const {
+        return &mCounts[((long long)(t-1)*(mUi-mLi+1) + (i-mLi))*mRowWords];
+    }
+
+    int mT, mLi, mUi, mLj, mUj;
+    int mMaxHoleRows;
+    long long mRowWords;
+    std::vector< std::atomic<uint64_t> > mCounts;
+    CoverageReport mReport;
+};
+
+#endif
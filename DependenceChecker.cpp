@@ -0,0 +1,129 @@
+/*!
+ * \file DependenceChecker.cpp
+ *
+ * \brief Implements the bitmap operations of DependenceChecker.
+ */
+#include "DependenceChecker.hpp"
+
+DependenceChecker::DependenceChecker(int T, int Li, int Ui, int Lj, int Uj)
+    : mT(T), mLi(Li), mUi(Ui), mLj(Lj), mUj(Uj),
+      mRowWords((Uj-Lj+1+63)/64),
+      mBits((size_t)T*(Ui-Li+1)*((Uj-Lj+1+63)/64)),
+      mHasViolation(false), mNumPoints(0) {}
+
+int DependenceChecker::firstMissing(int t, int i, int jlo, int jhi) const {
+    // Inputs are always done.
+    if (t == 0 || i < mLi || i > mUi) { return jhi+1; }
+    int first = imax(jlo, mLj)-mLj, last = imin(jhi, mUj)-mLj;
+    if (first > last) { return jhi+1; }
+    const std::atomic<uint64_t>* bits
+        = &mBits[((long long)(t-1)*(mUi-mLi+1) + (i-mLi))*mRowWords];
+    for (int word = first/64; word <= last/64; word++) {
+        uint64_t mask = ~(uint64_t)0;
+        if (word == first/64) { mask &= ~(uint64_t)0 << (first%64); }
+        if (word == last/64 && last%64 < 63) {
+            mask &= ((uint64_t)1 << (last%64+1)) - 1;
+        }
+        uint64_t missing = ~bits[word].load(std::memory_order_relaxed) & mask;
+        if (missing) { return mLj + word*64 + __builtin_ctzll(missing); }
+    }
+    return jhi+1;
+}
+
+void DependenceChecker::markRow(int t, int i, int jlo, int jhi) {
+    std::atomic<uint64_t>* bits
+        = &mBits[((long long)(t-1)*(mUi-mLi+1) + (i-mLi))*mRowWords];
+    int first = jlo-mLj, last = jhi-mLj;
+    for (int word = first/64; word <= last/64; word++) {
+        uint64_t mask = ~(uint64_t)0;
+        if (word == first/64) { mask &= ~(uint64_t)0 << (first%64); }
+        if (word == last/64 && last%64 < 63) {
+            mask &= ((uint64_t)1 << (last%64+1)) - 1;
+        }
+        // Tiles in the same wavefront can share a word.
+        bits[word].fetch_or(mask, std::memory_order_relaxed);
+    }
+}
+
+bool DependenceChecker::checkRow(const RowSpan& row, const OwnRows& own,
+                                 DependenceViolation& v) const {
+    v.outside = false;
+    v.t = row.t;
+    v.i = row.i;
+    if (!inside(row.t, row.i, row.jlo) || !inside(row.t, row.i, row.jhi)) {
+        v.outside = true;
+        v.j = inside(row.t, row.i, row.jlo) ? row.jhi : row.jlo;
+        v.predT = row.t;
+        v.predI = row.i;
+        v.predJ = v.j;
+        return false;
+    }
+
+    // Predecessor spans in the rows i-1, i+1, and i at time t-1.
+    int pred_i[3] = {row.i-1, row.i+1, row.i};
+    int pred_lo[3] = {row.jlo, row.jlo, row.jlo-1};
+    int pred_hi[3] = {row.jhi, row.jhi, row.jhi+1};
+    int best = row.jhi+1;
+    for (int p = 0; p < 3; p++) {
+        // Skip the part the tile computed itself.
+        int lo[2] = {pred_lo[p], 0}, hi[2] = {pred_hi[p], -1};
+        const RowSpan* mine = own.find(row.t-1, pred_i[p]);
+        if (mine) {
+            lo[1] = imax(mine->jhi+1, pred_lo[p]);
+            hi[1] = pred_hi[p];
+            hi[0] = imin(mine->jlo-1, pred_hi[p]);
+        }
+        for (int s = 0; s < 2; s++) {
+            int missing = firstMissing(row.t-1, pred_i[p], lo[s], hi[s]);
+            if (missing > hi[s]) { continue; }
+            // Earliest point in the row that reads the missing value.
+            int j = (p == 2) ? imax(row.jlo, missing-1) : missing;
+            if (j < best) {
+                best = j;
+                v.predT = row.t-1;
+                v.predI = pred_i[p];
+                v.predJ = missing;
+            }
+            break;
+        }
+    }
+    if (best <= row.jhi) {
+        v.j = best;
+        return false;
+    }
+    return true;
+}
+
+bool DependenceChecker::visitPoint(const TileCoord& tile, int t, int i,
+                                   int j) {
+    DependenceViolation v;
+    v.outside = !inside(t, i, j);
+    v.tile = tile;
+    v.wavefront = -1;
+    v.t = t;
+    v.i = i;
+    v.j = j;
+    v.predT = t;
+    v.predI = i;
+    v.predJ = j;
+    bool ok = !v.outside;
+    if (ok) {
+        int di[5] = {0, -1, 1, 0, 0};
+        int dj[5] = {0, 0, 0, -1, 1};
+        for (int p = 0; p < 5 && ok; p++) {
+            if (firstMissing(t-1, i+di[p], j+dj[p], j+dj[p]) == j+dj[p]) {
+                v.predT = t-1;
+                v.predI = i+di[p];
+                v.predJ = j+dj[p];
+                ok = false;
+            }
+        }
+        markRow(t, i, j, j);
+        mNumPoints++;
+    }
+    if (!ok && !mHasViolation) {
+        mViolation = v;
+        mHasViolation = true;
+    }
+    return ok;
+}
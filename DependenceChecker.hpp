@@ -0,0 +1,198 @@
+/*!
+ * \file DependenceChecker.hpp
+ *
+ * \brief Checks that a traversal of the Jacobi 2D iteration space
+ *        respects the stencil dependences.
+ *
+ * Point (t,i,j) reads (t-1,i,j), (t-1,i-1,j), (t-1,i+1,j), (t-1,i,j-1),
+ * and (t-1,i,j+1), so all of those have to be done before it runs.
+ * Values at t=0 and outside of Li<=i<=Ui, Lj<=j<=Uj are inputs and are
+ * always done.  One bit per point records whether it is done, and each
+ * (t,i) row of bits starts on a 64 bit word so that whole row spans are
+ * checked and marked a word at a time.
+ *
+ * checkTiling runs the tiles of each wavefront in parallel with OpenMP,
+ * the same as Jacobi2D::runWavefront.  A tile may only read points
+ * from earlier wavefronts and points it already computed itself, and
+ * the points of a wavefront are marked done after all of its tiles are
+ * checked, so the answer does not depend on the thread interleaving.
+ * The violation reported is the first one in schedule order.
+ *
+ * visitPoint checks traversals that are not tilings, such as the
+ * generated .is files, one point at a time in execution order.
+ */
+#ifndef DEPENDENCECHECKER_HPP_
+#define DEPENDENCECHECKER_HPP_
+
+#include "Tiling.hpp"
+
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+
+struct DependenceViolation {
+    bool outside;           // the point is outside of the iteration space
+    TileCoord tile;
+    int wavefront;          // -1 for visitPoint
+    int t, i, j;            // point that ran too early
+    int predT, predI, predJ;  // predecessor that was not done yet
+};
+
+class DependenceChecker {
+  public:
+    // Iteration space is 1<=t<=T, Li<=i<=Ui, Lj<=j<=Uj.
+    DependenceChecker(int T, int Li, int Ui, int Lj, int Uj);
+
+    // Checks every tile of the tiling.  Returns false at the end of the
+    // first wavefront with a violation.
+    template <typename Tiling>
+    bool checkTiling(const Tiling& tiling) {
+        std::vector<TileCoord> tiles;
+        std::vector< std::vector<RowSpan> > rows;
+        std::vector<DependenceViolation> found;
+        std::vector<char> bad;
+        for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront();
+             w++) {
+            tiles.clear();
+            tiling.forEachTile(w, [&](const TileCoord& tile) {
+                tiles.push_back(tile);
+            });
+            int num_tiles = (int)tiles.size();
+            if ((int)rows.size() < num_tiles) { rows.resize(num_tiles); }
+            found.resize(num_tiles);
+            bad.assign(num_tiles, 0);
+
+            #pragma omp parallel
+            {
+                OwnRows own;
+                #pragma omp for schedule(dynamic)
+                for (int k = 0; k < num_tiles; k++) {
+                    bad[k] = !checkTile(tiling, tiles[k], w, own, rows[k],
+                                        found[k]);
+                }
+            }
+            for (int k = 0; k < num_tiles; k++) {
+                if (bad[k]) {
+                    mViolation = found[k];
+                    mHasViolation = true;
+                    return false;
+                }
+            }
+
+            long long points = 0;
+            #pragma omp parallel for schedule(dynamic) reduction(+:points)
+            for (int k = 0; k < num_tiles; k++) {
+                for (size_t r = 0; r < rows[k].size(); r++) {
+                    const RowSpan& row = rows[k][r];
+                    markRow(row.t, row.i, row.jlo, row.jhi);
+                    points += row.jhi-row.jlo+1;
+                }
+            }
+            mNumPoints += points;
+        }
+        return true;
+    }
+
+    // Checks and marks one point.  Only the first violation is kept,
+    // and false is returned for it and every later one.
+    bool visitPoint(const TileCoord& tile, int t, int i, int j);
+
+    bool hasViolation() const { return mHasViolation; }
+    const DependenceViolation& violation() const { return mViolation; }
+    // Points that were checked and marked done.
+    long long numPoints() const { return mNumPoints; }
+
+  private:
+    struct RowSpan {
+        int t, i, jlo, jhi;
+    };
+    // Rows a tile already computed, keyed by (t,i).  An open addressing
+    // table that clear() empties by starting a new generation, since it
+    // is cleared for every tile.
+    class OwnRows {
+      public:
+        OwnRows() : mGeneration(1), mSize(0), mSlots(64) {}
+        void clear() { mGeneration++; mSize = 0; }
+        void insert(const RowSpan& row) {
+            if (2*(mSize+1) > mSlots.size()) { grow(); }
+            size_t k = slot(row.t, row.i);
+            if (mSlots[k].generation != mGeneration) { mSize++; }
+            mSlots[k].generation = mGeneration;
+            mSlots[k].row = row;
+        }
+        // Returns NULL if the tile has no row (t,i).
+        const RowSpan* find(int t, int i) const {
+            const Slot& s = mSlots[slot(t,i)];
+            return (s.generation == mGeneration) ? &s.row : NULL;
+        }
+      private:
+        struct Slot {
+            unsigned int generation;
+            RowSpan row;
+        };
+        // Slot holding (t,i) or the empty slot where it would go.
+        size_t slot(int t, int i) const {
+            size_t mask = mSlots.size()-1;
+            size_t k = ((unsigned int)t*2654435761u ^ (unsigned int)i
+                        *40503u) & mask;
+            while (mSlots[k].generation == mGeneration
+                   && (mSlots[k].row.t != t || mSlots[k].row.i != i)) {
+                k = (k+1) & mask;
+            }
+            return k;
+        }
+        void grow() {
+            std::vector<Slot> old(2*mSlots.size());
+            old.swap(mSlots);
+            mSize = 0;
+            for (size_t k = 0; k < old.size(); k++) {
+                if (old[k].generation == mGeneration) { insert(old[k].row); }
+            }
+        }
+        unsigned int mGeneration;
+        size_t mSize;
+        std::vector<Slot> mSlots;
+    };
+
+    template <typename Tiling>
+    bool checkTile(const Tiling& tiling, const TileCoord& tile, int w,
+                   OwnRows& own, std::vector<RowSpan>& rows,
+                   DependenceViolation& v) const {
+        own.clear();
+        rows.clear();
+        bool ok = true;
+        tiling.forEachRow(tile, [&](int t, int i, int jlo, int jhi) {
+            if (!ok || jlo > jhi) { return; }
+            RowSpan row = {t, i, jlo, jhi};
+            if (!checkRow(row, own, v)) {
+                v.tile = tile;
+                v.wavefront = w;
+                ok = false;
+                return;
+            }
+            own.insert(row);
+            rows.push_back(row);
+        });
+        return ok;
+    }
+
+    bool inside(int t, int i, int j) const {
+        return t>=1 && t<=mT && i>=mLi && i<=mUi && j>=mLj && j<=mUj;
+    }
+    // Checks the predecessors of a row span against the done bits and
+    // the rows the tile already computed.
+    bool checkRow(const RowSpan& row, const OwnRows& own,
+                  DependenceViolation& v) const;
+    // First j in jlo..jhi of row (t,i) that is not done, or jhi+1.
+    int firstMissing(int t, int i, int jlo, int jhi) const;
+    void markRow(int t, int i, int jlo, int jhi);
+
+    int mT, mLi, mUi, mLj, mUj;
+    long long mRowWords;
+    std::vector< std::atomic<uint64_t> > mBits;
+    bool mHasViolation;
+    DependenceViolation mViolation;
+    long long mNumPoints;
+};
+
+#endif
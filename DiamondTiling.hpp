@@ -0,0 +1,179 @@
+/*!
+ * \file DiamondTiling.hpp
+ *
+ * \brief Runtime traversal of the 3D diamond tiling for any tau.
+ *
+ * Tiles are defined by the hyperplanes t+i, t+j, and t-i-j, each
+ * tau wide.  With k0, k1, k2 being the tile indices along the three
+ * hyperplanes, the wavefront is kt=k0+k1+k2 and all tiles with the
+ * same kt can execute in parallel.  The bounds are the ones from the
+ * ICS 2014 paper that used to be inlined in the diamonds case of
+ * slice-viz.cpp.
+ */
+#ifndef DIAMONDTILING_HPP_
+#define DIAMONDTILING_HPP_
+
+#include "Tiling.hpp"
+
+class DiamondTiling {
+  public:
+    // Iteration space is 1<=t<=T, Li<=i<=Ui, Lj<=j<=Uj.
+    DiamondTiling(int T, int Li, int Ui, int Lj, int Uj, int tau)
+        : mT(T), mLi(Li), mUi(Ui), mLj(Lj), mUj(Uj), mTau(tau) {}
+
+    int firstWavefront() const { return ceilDiv(3,mTau)-3; }
+    int lastWavefront() const { return floorDiv(3*mT,mTau); }
+
+    // Loops over tile coordinates within a parallel tile wavefront.
+    template <typename F>
+    void forEachTile(int kt, F f) const {
+        int k1_lb = ceilDiv(3*mLj+2+(kt-2)*mTau, mTau*3);
+        int k1_ub = floorDiv(3*mUj+(kt+2)*mTau, mTau*3);
+        for (int k1 = k1_lb; k1 <= k1_ub; k1++) {
+            int k2_lb = floorDiv((2*kt-2)*mTau-3*mUi+2, mTau*3)-k1;
+            int k2_ub = floorDiv((2+2*kt)*mTau-3*mLi-2, mTau*3)-k1;
+            for (int k2 = k2_lb; k2 <= k2_ub; k2++) {
+                TileCoord tile = {kt, k1, k2};
+                f(tile);
+            }
+        }
+    }
+
+    // Loop over time within a tile and then the spatial dimensions.
+    template <typename F>
+    void forEachRow(const TileCoord& tile, F f) const {
+        int kt = tile.c0, k1 = tile.c1, k2 = tile.c2;
+        int tau = mTau;
+        int t_lb = imax(1, floorDiv(kt*tau-1, 3));
+        int t_ub = imin(mT, tau + floorDiv(kt*tau, 3) - 1);
+        for (int t = t_lb; t <= t_ub; t++) {
+            int i_lb = imax(mLi, imax((kt-k1-k2)*tau-t,
+                                      2*t-(2+k1+k2)*tau+2));
+            int i_ub = imin(mUi, imin((1+kt-k1-k2)*tau-t-1,
+                                      2*t-(k1+k2)*tau));
+            for (int i = i_lb; i <= i_ub; i++) {
+                int j_lb = imax(mLj, imax(tau*k1-t, t-i-(1+k2)*tau+1));
+                int j_ub = imin(mUj, imin((1+k1)*tau-t-1, t-i-k2*tau));
+                if (j_lb <= j_ub) {
+                    f(t, i, j_lb, j_ub);
+                }
+            }
+        }
+    }
+
+    // A stencil dependence moves each of t+i, t+j, and t-i-j back by
+    // at most 2, so with tau>=2 each of k0, k1, and k2 drops by at most
+    // one.  That gives up to 7 predecessor tiles.
+    template <typename F>
+    void forEachPredecessor(const TileCoord& tile, F f) const {
+        for (int d0 = 0; d0 <= 1; d0++) {
+            for (int d1 = 0; d1 <= 1; d1++) {
+                for (int d2 = 0; d2 <= 1; d2++) {
+                    if (d0+d1+d2 == 0) { continue; }
+                    TileCoord pred = {tile.c0-d0-d1-d2, tile.c1-d1,
+                                      tile.c2-d2};
+                    f(pred);
+                }
+            }
+        }
+    }
+
+    // Full tiles are (u,v,w)=(t+i,t+j,t-i-j) in a tau^3 cube with
+    // u+v+w divisible by 3, which only depends on tau and kt mod 3.
+    // Tiles clipped by the iteration space are summed per time step.
+    long long numPoints(const TileCoord& tile) const {
+        int kt = tile.c0, k1 = tile.c1, k2 = tile.c2;
+        int k0 = kt-k1-k2;
+        int tau = mTau;
+        int t_lb = imax(1, floorDiv(kt*tau-1, 3));
+        int t_ub = imin(mT, tau + floorDiv(kt*tau, 3) - 1);
+        if (t_lb > t_ub) { return 0; }
+
+        // Bounds on i=(2u-v-w)/3 and j=(2v-u-w)/3 over the cube.
+        int i_lo = ceilDiv((2*k0-k1-k2)*tau - 2*(tau-1), 3);
+        int i_hi = floorDiv((2*k0-k1-k2)*tau + 2*(tau-1), 3);
+        int j_lo = ceilDiv((2*k1-k0-k2)*tau - 2*(tau-1), 3);
+        int j_hi = floorDiv((2*k1-k0-k2)*tau + 2*(tau-1), 3);
+        if (t_lb > 1 && t_ub < mT && i_lo >= mLi && i_hi <= mUi
+                && j_lo >= mLj && j_hi <= mUj) {
+            return fullTilePoints(kt);
+        }
+
+        // Count per time step, see countAtTime, and the functions of t
+        // it compares.
+        const int A0 = (k1+1)*tau-1, C0 = k1*tau, B0 = -k2*tau;
+        const int D0 = -(k2+1)*tau+1;
+        LinearT bounds[] = {
+            {0, mLi}, {-1, k0*tau},             // i lower bound
+            {0, mUi}, {-1, (k0+1)*tau-1},       // i upper bound
+            {1, B0-mUj}, {2, B0-A0},            // p
+            {1, D0-mLj}, {2, D0-C0},            // q
+            {1, D0-mUj}, {2, D0-A0},            // D-A
+            {1, B0-mLj}, {2, B0-C0}             // B-C
+        };
+        LinearT A[] = {{0, mUj}, {-1, A0}};
+        LinearT C[] = {{0, mLj}, {-1, C0}};
+        LinearT zero = {0, 0};
+        TimeBreaks breaks;
+        breaks.addAllPairs(bounds, 12);
+        breaks.addCrossing(A[0], A[1]);
+        breaks.addCrossing(C[0], C[1]);
+        for (int a = 0; a < 2; a++) {
+            for (int c = 0; c < 2; c++) {
+                LinearT diff = {A[a].a-C[c].a, A[a].b-C[c].b};
+                breaks.addCrossing(diff, zero);
+            }
+        }
+        return breaks.sum(t_lb, t_ub, [&](int t) {
+            return countAtTime(k0, k1, k2, t);
+        });
+    }
+
+    int tau() const { return mTau; }
+
+  private:
+    // Number of points in the cube for tau^3 with the residue of the
+    // sum of the three offsets fixed by kt.
+    long long fullTilePoints(int kt) const {
+        int r = ((-kt*mTau) % 3 + 3) % 3;
+        long long n[3];
+        for (int s = 0; s < 3; s++) { n[s] = (mTau-s+2)/3; }
+        long long count = 0;
+        for (int a = 0; a < 3; a++) {
+            for (int b = 0; b < 3; b++) {
+                count += n[a]*n[b]*n[((r-a-b)%3+6)%3];
+            }
+        }
+        return count;
+    }
+
+    // Points of the tile at time t.  The j range of row i is
+    // [max(C,D-i), min(A,B-i)], so the row length is linear in i on
+    // each side of p=B-A and q=D-C.
+    long long countAtTime(int k0, int k1, int k2, int t) const {
+        int tau = mTau;
+        int I0 = imax(mLi, k0*tau-t);
+        int I1 = imin(mUi, (k0+1)*tau-1-t);
+        if (I0 > I1) { return 0; }
+        int A = imin(mUj, (k1+1)*tau-1-t);
+        int B = t-k2*tau;
+        int C = imax(mLj, k1*tau-t);
+        int D = t-(k2+1)*tau+1;
+        int p = B-A, q = D-C;
+        long long count = sumPositiveLinear(I0, imin(I1, imin(p,q)),
+                                            A-D+1, 1);
+        if (p < q) {
+            count += sumPositiveLinear(imax(I0,p+1), imin(I1,q), B-D+1, 0);
+        } else if (q < p) {
+            count += sumPositiveLinear(imax(I0,q+1), imin(I1,p), A-C+1, 0);
+        }
+        count += sumPositiveLinear(imax(I0, imax(p,q)+1), I1, B-C+1, -1);
+        return count;
+    }
+
+    int mT;
+    int mLi, mUi, mLj, mUj;
+    int mTau;
+};
+
+#endif
@@ -0,0 +1,126 @@
+/*!
+ * \file ExecutionSim.hpp
+ *
+ * \brief Discrete event simulation of running a tile graph on P workers.
+ *
+ * The graph is a TileGraph or a MappedTileDag, and the cost of each
+ * tile is given in ns.  Two policies are simulated:
+ *   - policy_barrier: the tiles of a wavefront are handed out in
+ *     schedule order to whichever worker is free first, and every
+ *     wavefront ends with a barrier, like Jacobi2D::runWavefront.
+ *   - policy_greedy: a tile is ready as soon as its predecessors are
+ *     done, as in TileScheduler, but there is one ready list and an
+ *     idle worker takes the ready tile that is earliest in schedule
+ *     order instead of stealing.
+ *
+ * Memory, scheduling overhead, and the barrier itself are free, so the
+ * makespan is a lower bound for a real run with the same tile costs.
+ */
+#ifndef EXECUTIONSIM_HPP_
+#define EXECUTIONSIM_HPP_
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <utility>
+#include <cstddef>
+
+typedef enum {
+    policy_barrier,
+    policy_greedy
+} policy_type;
+
+struct ExecutionStats {
+    int workers;
+    double makespan;        // ns from the first start to the last finish
+    double work;            // ns of all tiles
+    double idle;            // ns summed over the workers
+    double utilization;     // work/(workers*makespan)
+};
+
+// Simulates the graph on the given number of workers.  If start is not
+// NULL it gets the start time of every tile in ns.
+template <typename Graph>
+ExecutionStats simulateExecution(const Graph& graph,
+                                 const std::vector<double>& cost,
+                                 int workers, policy_type policy,
+                                 std::vector<double>* start = NULL) {
+    typedef std::pair<double,int> Event;
+    typedef std::priority_queue<Event, std::vector<Event>,
+                                std::greater<Event> > EventQueue;
+    int num_tiles = graph.numTiles();
+    if (start) { start->assign(num_tiles, 0.0); }
+    double work = 0.0;
+    double makespan = 0.0;
+
+    if (policy == policy_barrier) {
+        // Tiles of a wavefront are consecutive in schedule order.  Only
+        // as many workers as there are tiles need a free time.
+        int k = 0;
+        while (k < num_tiles) {
+            int w = graph.wavefront(k);
+            int end = k;
+            while (end < num_tiles && graph.wavefront(end) == w) { end++; }
+            int used = (end-k < workers) ? end-k : workers;
+            std::vector<double> init(used, makespan);
+            std::priority_queue<double, std::vector<double>,
+                                std::greater<double> >
+                available(std::greater<double>(), init);
+            double barrier = makespan;
+            for (; k < end; k++) {
+                double now = available.top();
+                available.pop();
+                if (start) { (*start)[k] = now; }
+                work += cost[k];
+                available.push(now+cost[k]);
+                if (now+cost[k] > barrier) { barrier = now+cost[k]; }
+            }
+            makespan = barrier;
+        }
+    } else {
+        std::vector<int> waiting(num_tiles);
+        std::priority_queue<int, std::vector<int>, std::greater<int> > ready;
+        for (int k = 0; k < num_tiles; k++) {
+            waiting[k] = graph.numPreds(k);
+            if (waiting[k] == 0) { ready.push(k); }
+        }
+        EventQueue running;
+        int idle = workers;
+        int done = 0;
+        double now = 0.0;
+        while (done < num_tiles) {
+            while (idle > 0 && !ready.empty()) {
+                int k = ready.top();
+                ready.pop();
+                if (start) { (*start)[k] = now; }
+                work += cost[k];
+                running.push(Event(now+cost[k], k));
+                idle--;
+            }
+            // Finish every tile that ends at the next event time before
+            // handing out more tiles.
+            now = running.top().first;
+            while (!running.empty() && running.top().first == now) {
+                int k = running.top().second;
+                running.pop();
+                idle++;
+                done++;
+                for (int s = 0; s < graph.numSuccs(k); s++) {
+                    int succ = graph.succs(k)[s];
+                    if (--waiting[succ] == 0) { ready.push(succ); }
+                }
+            }
+        }
+        makespan = now;
+    }
+
+    ExecutionStats stats;
+    stats.workers = workers;
+    stats.makespan = makespan;
+    stats.work = work;
+    stats.idle = (workers*makespan > work) ? workers*makespan - work : 0.0;
+    stats.utilization = (makespan > 0.0) ? work/(workers*makespan) : 1.0;
+    return stats;
+}
+
+#endif
@@ -0,0 +1,159 @@
+/*!
+ * \file HwCounters.cpp
+ *
+ * \brief Opens and reads the perf_event_open counters of HwCounters.
+ *
+ * glibc has no wrapper for perf_event_open so it is called with
+ * syscall.  The counters in the group are opened with PERF_FORMAT_GROUP,
+ * so one read of the leader returns all of their values after the
+ * enabled and running times of the group; a counter opened alone is read
+ * on its own.  On systems other than Linux no counter opens.
+ */
+#include "HwCounters.hpp"
+
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#endif
+
+static const char* hwCounterNames[num_hw_counters] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+const char* hwCounterName(int counter) {
+    return hwCounterNames[counter];
+}
+
+#ifdef __linux__
+
+// Type and config of each counter.
+static void counterEvent(int counter, __u32& type, __u64& config) {
+    static const __u64 read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    switch (counter) {
+        case hw_cycles:
+            type = PERF_TYPE_HARDWARE;
+            config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case hw_instructions:
+            type = PERF_TYPE_HARDWARE;
+            config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case hw_l1d_misses:
+            type = PERF_TYPE_HW_CACHE;
+            config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+            break;
+        case hw_llc_misses:
+            type = PERF_TYPE_HW_CACHE;
+            config = PERF_COUNT_HW_CACHE_LL | read_miss;
+            break;
+        default:
+            type = PERF_TYPE_HARDWARE;
+            config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+    }
+}
+
+// Opens the counter in the group of group_fd, or as the leader of a new
+// group when group_fd is -1 and group is true, or alone.
+static int openCounter(int counter, int group_fd, bool group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    counterEvent(counter, attr.type, attr.config);
+    attr.disabled = (group_fd < 0) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                       | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    if (group) { attr.read_format |= PERF_FORMAT_GROUP; }
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+// Scales a count by the time it was enabled over the time it ran.
+static long long scaleCount(uint64_t count, uint64_t enabled,
+                            uint64_t running) {
+    if (running > 0 && running < enabled) {
+        return (long long)((double)count*enabled/running);
+    }
+    return (long long)count;
+}
+
+HwCounters::HwCounters() : mLeader(-1), mNumOpen(0), mGroupSize(0) {
+    for (int c = 0; c < num_hw_counters; c++) {
+        mGroupIndex[c] = -1;
+        mFd[c] = openCounter(c, mLeader, true);
+        if (mFd[c] >= 0) {
+            mGroupIndex[c] = mGroupSize++;
+        } else if (mLeader >= 0) {
+            // The group may not fit in the PMU, try it alone.
+            mFd[c] = openCounter(c, -1, false);
+            if (mFd[c] >= 0) { ioctl(mFd[c], PERF_EVENT_IOC_ENABLE, 0); }
+        }
+        if (mFd[c] < 0) {
+            if (mError.empty()) {
+                mError = std::string(hwCounterNames[c]) + ": "
+                         + strerror(errno);
+            }
+            continue;
+        }
+        if (mLeader < 0) { mLeader = mFd[c]; }
+        mNumOpen++;
+    }
+    if (mLeader >= 0) {
+        ioctl(mLeader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+HwCounters::~HwCounters() {
+    for (int c = 0; c < num_hw_counters; c++) {
+        if (mFd[c] >= 0) { close(mFd[c]); }
+    }
+}
+
+void HwCounters::read(HwSample& sample) const {
+    sample.clear();
+    // Number of counters, time enabled, time running, then the values
+    // in the order the counters joined the group.
+    uint64_t group[3+num_hw_counters];
+    ssize_t group_bytes = (3+mGroupSize)*sizeof(uint64_t);
+    bool group_ok = mLeader >= 0
+        && ::read(mLeader, group, group_bytes) == group_bytes
+        && group[0] == (uint64_t)mGroupSize;
+    for (int c = 0; c < num_hw_counters; c++) {
+        if (mFd[c] < 0) { continue; }
+        if (mGroupIndex[c] >= 0) {
+            if (group_ok) {
+                sample.value[c] = scaleCount(group[3+mGroupIndex[c]],
+                                             group[1], group[2]);
+            }
+            continue;
+        }
+        uint64_t data[3];   // value, time enabled, time running
+        if (::read(mFd[c], data, sizeof(data)) == (ssize_t)sizeof(data)) {
+            sample.value[c] = scaleCount(data[0], data[1], data[2]);
+        }
+    }
+}
+
+#else
+
+HwCounters::HwCounters()
+    : mLeader(-1), mNumOpen(0), mGroupSize(0), mError("not supported") {
+    for (int c = 0; c < num_hw_counters; c++) {
+        mFd[c] = -1;
+        mGroupIndex[c] = -1;
+    }
+}
+
+HwCounters::~HwCounters() {}
+
+void HwCounters::read(HwSample& sample) const {
+    sample.clear();
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*!
+ * \file HwCounters.hpp
+ *
+ * \brief Hardware performance counters of one thread from Linux
+ *        perf_event_open.
+ *
+ * An HwCounters counts cycles, instructions, L1 data cache read misses,
+ * last level cache read misses, and branch misses of the thread that
+ * constructs it, in user space only.  Counters are opened as one group
+ * so they are scheduled together, and a counter that does not fit in
+ * the group is opened on its own.  When the kernel multiplexes the
+ * counters the values are scaled by the time each was enabled over the
+ * time it was running.
+ *
+ * Any thread can read the counters, so a driver can give each worker
+ * thread its own and sum them after a barrier.  Counters that can not
+ * be opened, such as in a virtual machine without a PMU or when
+ * perf_event_paranoid forbids it, read as zero and ok() is false when
+ * none could be opened, so the drivers fall back to their timers.
+ */
+#ifndef HWCOUNTERS_HPP_
+#define HWCOUNTERS_HPP_
+
+#include <string>
+
+typedef enum {
+    hw_cycles,
+    hw_instructions,
+    hw_l1d_misses,
+    hw_llc_misses,
+    hw_branch_misses,
+    num_hw_counters
+} hw_counter_type;
+
+// Name of the counter for reports, such as "l1d_misses".
+const char* hwCounterName(int counter);
+
+struct HwSample {
+    long long value[num_hw_counters];
+
+    void clear() {
+        for (int c = 0; c < num_hw_counters; c++) { value[c] = 0; }
+    }
+    void add(const HwSample& after, const HwSample& before) {
+        for (int c = 0; c < num_hw_counters; c++) {
+            value[c] += after.value[c] - before.value[c];
+        }
+    }
+};
+
+class HwCounters {
+  public:
+    // Opens the counters for the calling thread and starts them.
+    HwCounters();
+    ~HwCounters();
+
+    // Whether any counter could be opened.
+    bool ok() const { return mNumOpen > 0; }
+    bool has(int counter) const { return mFd[counter] >= 0; }
+    // Why the first counter could not be opened, if one could not.
+    const std::string& error() const { return mError; }
+
+    // Current counts since construction, zero for unavailable counters.
+    // The group is read with one system call.
+    void read(HwSample& sample) const;
+
+  private:
+    HwCounters(const HwCounters&);
+    HwCounters& operator=(const HwCounters&);
+
+    int mFd[num_hw_counters];
+    // Position of the counter in the group read, -1 if opened alone.
+    int mGroupIndex[num_hw_counters];
+    int mLeader;
+    int mNumOpen;
+    int mGroupSize;
+    std::string mError;
+};
+
+#endif
@@ -0,0 +1,51 @@
+/*!
+ * \file IsTraversal.cpp
+ *
+ * \brief Includes the generated .is files with calc_ping, calc_pong,
+ *        and calc calling a function.
+ */
+#include "IsTraversal.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Definitions and declarations needed by the .is files.
+#include "eassert.h"
+#include "intops.h"
+#define do_edge_pong(i,j) // nothing
+#define do_edge_ping(i,j) // nothing
+#define do_init_pong(i,j) // nothing
+#define startclock() // nothing
+
+#define calc_ping(t,i,j) { \
+    TileCoord tile = {c1, c2, c3}; \
+    f(tile, t, i, j); }
+#define calc_pong(t,i,j) calc_ping(t,i,j)
+#define calc(t,i,j) calc_ping(t,i,j)
+
+void forEachIsPoint(is_traversal_type traversal, int T, int N,
+        const std::function<void(const TileCoord&,int,int,int)>& f) {
+    int c1 = 0, c2 = 0, c3 = 0, c4, c5, c6, c7;
+    switch (traversal) {
+        case is_none:
+            break;
+        case is_pipelined_4x4x4:
+            #include "pipelined-4x4x4.is"
+            break;
+        case is_diamonds_tij_skew:
+            #include "diamonds-tij-skew.is"
+            break;
+        case is_diamond_prizms_6x6:
+            #include "diamond-prizms-skew-6x6.is"
+            break;
+        case is_diamond_prizms_8x8:
+            #include "diamond-prizms-skew-8x8.is"
+            break;
+        case is_diamond_prizms_12x12:
+            #include "diamond-prizms-skew-12x12.is"
+            break;
+        case is_diamond_prizms_6x6_noping:
+            #include "diamond-prizms-skew-noping-6x6.is"
+            break;
+    }
+}
@@ -0,0 +1,33 @@
+/*!
+ * \file IsTraversal.hpp
+ *
+ * \brief Runs the traversals that the isl code generator wrote to the
+ *        .is files (see slice-viz-codegen.sh) outside of slice-viz.
+ *
+ * Each .is file visits the interior 1<=i,j<=N-2 of an NxN grid for
+ * 1<=t<=T with calc_ping, calc_pong, or calc.  Here each of those calls
+ * f(tile,t,i,j) with the tile coordinates (c1,c2,c3) of the generated
+ * loops.  The .is files need the macros in intops.h, which clash with
+ * the standard library, so they are only included in IsTraversal.cpp.
+ */
+#ifndef ISTRAVERSAL_HPP_
+#define ISTRAVERSAL_HPP_
+
+#include "Tiling.hpp"
+
+#include <functional>
+
+typedef enum {
+    is_none,
+    is_pipelined_4x4x4,
+    is_diamonds_tij_skew,
+    is_diamond_prizms_6x6,
+    is_diamond_prizms_8x8,
+    is_diamond_prizms_12x12,
+    is_diamond_prizms_6x6_noping
+} is_traversal_type;
+
+void forEachIsPoint(is_traversal_type traversal, int T, int N,
+        const std::function<void(const TileCoord&,int,int,int)>& f);
+
+#endif
@@ -0,0 +1,49 @@
+/*!
+ * \file Jacobi2D.cpp
+ *
+ * \brief Implements the non-template parts of Jacobi2D.
+ */
+#include "Jacobi2D.hpp"
+
+#include <cmath>
+
+Jacobi2D::Jacobi2D(int N)
+    : mN(N), mKernel(rowKernelScalar), mTrace(NULL) {
+    mBuf[0].assign((size_t)N*N, 0.0);
+    mBuf[1].assign((size_t)N*N, 0.0);
+}
+
+void Jacobi2D::init(unsigned int seed) {
+    // Small LCG so runs are repeatable across platforms.
+    unsigned int state = seed;
+    for (int i = 0; i < mN; i++) {
+        for (int j = 0; j < mN; j++) {
+            double val = 0.0;
+            if (i>=lower() && i<=upper() && j>=lower() && j<=upper()) {
+                state = state*1103515245u + 12345u;
+                val = (double)((state>>16) & 0x7fff) / 32768.0;
+            }
+            mBuf[0][(size_t)i*mN+j] = val;
+            mBuf[1][(size_t)i*mN+j] = 0.0;
+        }
+    }
+}
+
+void Jacobi2D::runNaive(int T) {
+    for (int t = 1; t <= T; t++) {
+        for (int i = lower(); i <= upper(); i++) {
+            computeRow(t, i, lower(), upper());
+        }
+    }
+}
+
+double Jacobi2D::maxDiff(const Jacobi2D& other, int T) const {
+    const double* a = buffer(T);
+    const double* b = other.buffer(T);
+    double diff = 0.0;
+    for (size_t k = 0; k < (size_t)mN*mN; k++) {
+        double d = fabs(a[k]-b[k]);
+        if (d > diff) { diff = d; }
+    }
+    return diff;
+}
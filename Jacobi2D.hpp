@@ -0,0 +1,178 @@
+/*!
+ * \file Jacobi2D.hpp
+ *
+ * \brief Executable version of the Jacobi 2D stencil in facts.piscc.
+ *
+ * The data is an NxN grid with two copies (ping and pong), so A(t,i,j)
+ * lives in buffer t%2.  The edges i=0, i=N-1, j=0, and j=N-1 are fixed
+ * at zero and the interior 1<=i,j<=N-2 is computed with
+ *
+ *   A(t,i,j) = (A(t-1,i-1,j)+A(t-1,i,j-1)+A(t-1,i+1,j)+A(t-1,i,j+1)
+ *               +2*A(t-1,i,j))*.167;
+ *
+ * The tiled versions take any tiling object described in Tiling.hpp,
+ * so the same traversal that colors circles in slice-viz can be timed.
+ * Each (t,i) row span of a tile is computed by one of the row kernels
+ * in StencilKernels.hpp.  When a TileTrace is set, runTile records the
+ * begin and end of each tile for the worker that runs it.
+ */
+#ifndef JACOBI2D_HPP_
+#define JACOBI2D_HPP_
+
+#include "Tiling.hpp"
+#include "StencilKernels.hpp"
+#include "TileTrace.hpp"
+
+#include <vector>
+#include <cstddef>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class Jacobi2D {
+  public:
+    Jacobi2D(int N);
+
+    // Records the tiles runTile runs into trace, or nothing if NULL.
+    void setTrace(TileTrace* trace) { mTrace = trace; }
+
+    // Chooses the row kernel, see selectRowKernel().
+    void setKernel(kernel_type& choice) { mKernel = selectRowKernel(choice); }
+
+    // Puts pseudo-random values in the interior of A(0,*,*) and
+    // zeros on the edges of both buffers.
+    void init(unsigned int seed);
+
+    int N() const { return mN; }
+    // Lower and upper bound for i and j that are computed.
+    int lower() const { return 1; }
+    int upper() const { return mN-2; }
+
+    // Buffer holding A(t,*,*).
+    double* buffer(int t) { return &mBuf[t&1][0]; }
+    const double* buffer(int t) const { return &mBuf[t&1][0]; }
+
+    // Computes A(t,i,jlo..jhi).
+    void computeRow(int t, int i, int jlo, int jhi) {
+        const double* prev = buffer(t-1);
+        double* cur = buffer(t);
+        const double* mid = prev + (size_t)i*mN;
+        mKernel(mid-mN, mid, mid+mN, cur + (size_t)i*mN, jlo, jhi);
+    }
+
+    // Untiled sweep over t, i, and j.
+    void runNaive(int T);
+
+    // Executes the tiling one tile at a time in schedule order.
+    // Time step t of the tiling computes A(t+toff,*,*).
+    template <typename Tiling>
+    void runSerial(const Tiling& tiling, int toff = 0) {
+        for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront();
+             w++) {
+            tiling.forEachTile(w, [&](const TileCoord& tile) {
+                runTile(tiling, tile, toff, 0);
+            });
+        }
+    }
+
+    // Executes the tiles within each wavefront in parallel with OpenMP.
+    // There is a barrier between wavefronts.
+    template <typename Tiling>
+    void runWavefront(const Tiling& tiling, int toff = 0) {
+        std::vector<TileCoord> tiles;
+        for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront();
+             w++) {
+            tiles.clear();
+            tiling.forEachTile(w, [&](const TileCoord& tile) {
+                tiles.push_back(tile);
+            });
+            int num_tiles = (int)tiles.size();
+            #pragma omp parallel
+            {
+                int worker = threadNum();
+                #pragma omp for schedule(dynamic)
+                for (int k = 0; k < num_tiles; k++) {
+                    runTile(tiling, tiles[k], toff, worker);
+                }
+            }
+        }
+    }
+
+    // Same as runWavefront for a TileSpace, whose wavefronts are flat
+    // ranges of non-empty tiles that are split evenly among the
+    // threads.
+    template <typename Space>
+    void runStatic(const Space& space, int toff = 0) {
+        for (int w = space.firstWavefront(); w <= space.lastWavefront();
+             w++) {
+            int begin = space.wavefrontBegin(w), end = space.wavefrontEnd(w);
+            #pragma omp parallel
+            {
+                int worker = threadNum();
+                #pragma omp for schedule(static)
+                for (int k = begin; k < end; k++) {
+                    runTile(space, space.tile(k), toff, worker);
+                }
+            }
+        }
+    }
+
+    // Executes T time steps as slabs of at most slab time steps.
+    // make_tiling(Ts) returns the tiling for a slab of Ts time steps,
+    // which is run with runWavefront if parallel is true and with
+    // runSerial otherwise.
+    template <typename MakeTiling>
+    void runSlabs(int T, int slab, bool parallel, MakeTiling make_tiling) {
+        for (int toff = 0; toff < T; toff += slab) {
+            if (parallel) {
+                runWavefront(make_tiling(imin(slab, T-toff)), toff);
+            } else {
+                runSerial(make_tiling(imin(slab, T-toff)), toff);
+            }
+        }
+    }
+
+    // Executes one tile.  With a trace, a tile with points is recorded
+    // as run by worker, and an empty one is skipped.  Its points are
+    // counted after the run, as numPoints takes about as long as
+    // enumerating the rows.
+    template <typename Tiling>
+    void runTile(const Tiling& tiling, const TileCoord& tile, int toff,
+                 int worker) {
+        if (!mTrace) {
+            tiling.forEachRow(tile, [&](int t, int i, int jlo, int jhi) {
+                computeRow(t+toff, i, jlo, jhi);
+            });
+            return;
+        }
+        bool empty = true;
+        int64_t begin = mTrace->now();
+        tiling.forEachRow(tile, [&](int t, int i, int jlo, int jhi) {
+            computeRow(t+toff, i, jlo, jhi);
+            empty = false;
+        });
+        if (!empty) {
+            mTrace->record(worker, tile, toff, begin, mTrace->now());
+        }
+    }
+
+    // The OpenMP thread, or 0 without OpenMP.
+    static int threadNum() {
+#ifdef _OPENMP
+        return omp_get_thread_num();
+#else
+        return 0;
+#endif
+    }
+
+    // Largest absolute difference between A(T,*,*) of the two grids.
+    double maxDiff(const Jacobi2D& other, int T) const;
+
+  private:
+    int mN;
+    RowKernel mKernel;
+    TileTrace* mTrace;
+    std::vector<double> mBuf[2];
+};
+
+#endif
@@ -0,0 +1,86 @@
+/*!
+ * \file LRUCache.hpp
+ *
+ * \brief Least recently used cache with a budget in bytes.
+ *
+ * Values are held by shared_ptr so that a value that is evicted while
+ * a caller still uses it stays alive until the caller is done.  The
+ * byte size of each value is given by the caller when it is put.  A
+ * value bigger than the whole budget is not cached.
+ */
+#ifndef LRUCACHE_HPP_
+#define LRUCACHE_HPP_
+
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+#include <cstddef>
+
+template <typename Key, typename Value>
+class LRUCache {
+  public:
+    LRUCache(size_t max_bytes)
+        : mMaxBytes(max_bytes), mBytes(0), mHits(0), mMisses(0),
+          mEvictions(0) {}
+
+    // Returns the value and makes it the most recently used, or NULL.
+    std::shared_ptr<const Value> get(const Key& key) {
+        typename Index::iterator iter = mIndex.find(key);
+        if (iter == mIndex.end()) {
+            mMisses++;
+            return std::shared_ptr<const Value>();
+        }
+        mHits++;
+        mEntries.splice(mEntries.begin(), mEntries, iter->second);
+        return iter->second->value;
+    }
+
+    // Adds or replaces the value, then evicts the least recently used
+    // values until the cache fits in its budget.
+    void put(const Key& key, std::shared_ptr<const Value> value,
+             size_t bytes) {
+        typename Index::iterator iter = mIndex.find(key);
+        if (iter != mIndex.end()) {
+            mBytes -= iter->second->bytes;
+            mEntries.erase(iter->second);
+            mIndex.erase(iter);
+        }
+        if (bytes > mMaxBytes) { return; }
+        Entry entry = {key, value, bytes};
+        mEntries.push_front(entry);
+        mIndex[key] = mEntries.begin();
+        mBytes += bytes;
+        while (mBytes > mMaxBytes) {
+            const Entry& last = mEntries.back();
+            mBytes -= last.bytes;
+            mIndex.erase(last.key);
+            mEntries.pop_back();
+            mEvictions++;
+        }
+    }
+
+    size_t size() const { return mEntries.size(); }
+    size_t bytes() const { return mBytes; }
+    size_t maxBytes() const { return mMaxBytes; }
+    long long hits() const { return mHits; }
+    long long misses() const { return mMisses; }
+    long long evictions() const { return mEvictions; }
+
+  private:
+    struct Entry {
+        Key key;
+        std::shared_ptr<const Value> value;
+        size_t bytes;
+    };
+    typedef std::list<Entry> Entries;
+    typedef std::map<Key, typename Entries::iterator> Index;
+
+    size_t mMaxBytes;
+    size_t mBytes;
+    long long mHits, mMisses, mEvictions;
+    Entries mEntries;           // most recently used first
+    Index mIndex;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/*!
+ * \file NaiveTiling.hpp
+ *
+ * \brief The untiled sweep written as a tiling so that analyses of
+ *        tilings can use it as the baseline.
+ *
+ * Each time step is one tile and is its own wavefront, and within the
+ * time step the rows are visited in order, which is the same order as
+ * Jacobi2D::runNaive.
+ *
+ * Tile coordinates are (t,0,0).
+ */
+#ifndef NAIVETILING_HPP_
+#define NAIVETILING_HPP_
+
+#include "Tiling.hpp"
+
+class NaiveTiling {
+  public:
+    // Iteration space is 1<=t<=T, Li<=i<=Ui, Lj<=j<=Uj.
+    NaiveTiling(int T, int Li, int Ui, int Lj, int Uj)
+        : mT(T), mLi(Li), mUi(Ui), mLj(Lj), mUj(Uj) {}
+
+    int firstWavefront() const { return 1; }
+    int lastWavefront() const { return mT; }
+
+    template <typename F>
+    void forEachTile(int t, F f) const {
+        TileCoord tile = {t, 0, 0};
+        f(tile);
+    }
+
+    template <typename F>
+    void forEachRow(const TileCoord& tile, F f) const {
+        for (int i = mLi; i <= mUi; i++) {
+            f(tile.c0, i, mLj, mUj);
+        }
+    }
+
+    template <typename F>
+    void forEachPredecessor(const TileCoord& tile, F f) const {
+        TileCoord pred = {tile.c0-1, 0, 0};
+        f(pred);
+    }
+
+    long long numPoints(const TileCoord& tile) const {
+        return (long long)(mUi-mLi+1)*(mUj-mLj+1);
+    }
+
+  private:
+    int mT;
+    int mLi, mUi, mLj, mUj;
+};
+
+#endif
@@ -0,0 +1,159 @@
+/*!
+ * \file ParallelismProfile.cpp
+ *
+ * \brief Implements the non-template parts of ParallelismProfile.
+ */
+#include "ParallelismProfile.hpp"
+
+void ParallelismProfile::analyze() {
+    mTotalPoints = 0;
+    mNumTiles = 0;
+    int num_tiles = mGraph.numTiles();
+
+    // Tiles are numbered in schedule order, so each wavefront is a run
+    // of consecutive tiles.
+    for (int k = 0; k < num_tiles; k++) {
+        if (mWavefronts.empty()
+            || mWavefronts.back().wavefront != mGraph.wavefront(k)) {
+            WavefrontProfile wave = {mGraph.wavefront(k), 0, 0, 0, 0};
+            mWavefronts.push_back(wave);
+        }
+        WavefrontProfile& wave = mWavefronts.back();
+        if (mPoints[k] == 0) {
+            wave.emptyTiles++;
+            continue;
+        }
+        wave.tiles++;
+        wave.points += mPoints[k];
+        if (mPoints[k] > wave.maxPoints) { wave.maxPoints = mPoints[k]; }
+        mTotalPoints += mPoints[k];
+        mNumTiles++;
+    }
+
+    // Predecessors come earlier in schedule order, so one pass finds
+    // the heaviest chain ending at each tile.
+    std::vector<long long> finish(num_tiles, 0);
+    std::vector<int> chain(num_tiles, 0);
+    mCriticalPoints = 0;
+    mCriticalTiles = 0;
+    for (int k = 0; k < num_tiles; k++) {
+        long long start = 0;
+        int tiles = 0;
+        const int* preds = mGraph.preds(k);
+        for (int p = 0; p < mGraph.numPreds(k); p++) {
+            if (finish[preds[p]] > start
+                || (finish[preds[p]] == start && chain[preds[p]] > tiles)) {
+                start = finish[preds[p]];
+                tiles = chain[preds[p]];
+            }
+        }
+        finish[k] = start + mPoints[k];
+        chain[k] = tiles + (mPoints[k] > 0 ? 1 : 0);
+        if (finish[k] > mCriticalPoints
+            || (finish[k] == mCriticalPoints && chain[k] > mCriticalTiles)) {
+            mCriticalPoints = finish[k];
+            mCriticalTiles = chain[k];
+        }
+    }
+}
+
+double ParallelismProfile::wavefrontSpeedup(int P) const {
+    double time = 0.0;
+    for (size_t w = 0; w < mWavefronts.size(); w++) {
+        double share = (double)mWavefronts[w].points / P;
+        double biggest = (double)mWavefronts[w].maxPoints;
+        time += (share > biggest) ? share : biggest;
+    }
+    return (time > 0.0) ? mTotalPoints / time : 1.0;
+}
+
+double ParallelismProfile::dagSpeedup(int P) const {
+    double share = (double)mTotalPoints / P;
+    double time = (share > mCriticalPoints) ? share : mCriticalPoints;
+    return (time > 0.0) ? mTotalPoints / time : 1.0;
+}
+
+void ParallelismProfile::writeCSV(std::ostream& out, int max_workers) const {
+    out << "tiles,empty_tiles,points,wavefronts,critical_path_points,"
+        << "critical_path_tiles,average_parallelism" << std::endl;
+    out << mNumTiles << "," << numEmptyTiles() << "," << mTotalPoints << ","
+        << mWavefronts.size() << "," << mCriticalPoints << ","
+        << mCriticalTiles << ","
+        << (double)mTotalPoints/(mCriticalPoints > 0 ? mCriticalPoints : 1)
+        << std::endl << std::endl;
+
+    out << "wavefront,tiles,empty_tiles,points,max_tile_points,imbalance"
+        << std::endl;
+    for (size_t w = 0; w < mWavefronts.size(); w++) {
+        const WavefrontProfile& wave = mWavefronts[w];
+        // Biggest tile over the average tile.
+        double imbalance = (wave.tiles > 0)
+            ? (double)wave.maxPoints*wave.tiles/wave.points : 0.0;
+        out << wave.wavefront << "," << wave.tiles << "," << wave.emptyTiles
+            << "," << wave.points << "," << wave.maxPoints << ","
+            << imbalance << std::endl;
+    }
+    out << std::endl;
+
+    out << "workers,wavefront_speedup,dag_speedup" << std::endl;
+    for (int P = 1; P <= max_workers; P++) {
+        out << P << "," << wavefrontSpeedup(P) << "," << dagSpeedup(P)
+            << std::endl;
+    }
+    out << std::endl;
+
+    out << "c0,c1,c2,wavefront,points" << std::endl;
+    for (int k = 0; k < mGraph.numTiles(); k++) {
+        if (mPoints[k] == 0) { continue; }
+        const TileCoord& tile = mGraph.tile(k);
+        out << tile.c0 << "," << tile.c1 << "," << tile.c2 << ","
+            << mGraph.wavefront(k) << "," << mPoints[k] << std::endl;
+    }
+}
+
+void ParallelismProfile::writeJSON(std::ostream& out, int max_workers) const {
+    out << "{" << std::endl;
+    out << "  \"tiles\": " << mNumTiles << "," << std::endl;
+    out << "  \"empty_tiles\": " << numEmptyTiles() << "," << std::endl;
+    out << "  \"points\": " << mTotalPoints << "," << std::endl;
+    out << "  \"critical_path_points\": " << mCriticalPoints << ","
+        << std::endl;
+    out << "  \"critical_path_tiles\": " << mCriticalTiles << "," << std::endl;
+    out << "  \"average_parallelism\": "
+        << (double)mTotalPoints/(mCriticalPoints > 0 ? mCriticalPoints : 1)
+        << "," << std::endl;
+
+    out << "  \"wavefronts\": [" << std::endl;
+    for (size_t w = 0; w < mWavefronts.size(); w++) {
+        const WavefrontProfile& wave = mWavefronts[w];
+        out << "    {\"wavefront\": " << wave.wavefront
+            << ", \"tiles\": " << wave.tiles
+            << ", \"empty_tiles\": " << wave.emptyTiles
+            << ", \"points\": " << wave.points
+            << ", \"max_tile_points\": " << wave.maxPoints << "}"
+            << (w+1 < mWavefronts.size() ? "," : "") << std::endl;
+    }
+    out << "  ]," << std::endl;
+
+    out << "  \"speedup\": [" << std::endl;
+    for (int P = 1; P <= max_workers; P++) {
+        out << "    {\"workers\": " << P
+            << ", \"wavefront\": " << wavefrontSpeedup(P)
+            << ", \"dag\": " << dagSpeedup(P) << "}"
+            << (P < max_workers ? "," : "") << std::endl;
+    }
+    out << "  ]," << std::endl;
+
+    out << "  \"tile_points\": [" << std::endl;
+    bool first = true;
+    for (int k = 0; k < mGraph.numTiles(); k++) {
+        if (mPoints[k] == 0) { continue; }
+        const TileCoord& tile = mGraph.tile(k);
+        if (!first) { out << "," << std::endl; }
+        out << "    [" << tile.c0 << ", " << tile.c1 << ", " << tile.c2
+            << ", " << mPoints[k] << "]";
+        first = false;
+    }
+    out << std::endl << "  ]" << std::endl;
+    out << "}" << std::endl;
+}
@@ -0,0 +1,78 @@
+/*!
+ * \file ParallelismProfile.hpp
+ *
+ * \brief How much parallelism a tiling exposes, without running it.
+ *
+ * The number of tiles and points in each wavefront is what the kt loop
+ * in slice-viz.cpp and the c0 phases in diamond-slice-viz.cpp show with
+ * colors.  Every tile is weighted by its numPoints, and the critical
+ * path is the heaviest chain of tiles in the TileGraph.
+ *
+ * Two ideal speedups are reported for P workers, both upper bounds
+ * that ignore memory:
+ *   - wavefront: every wavefront ends with a barrier, so it takes at
+ *     least max(its biggest tile, its points/P).
+ *   - dag: tiles only wait on their predecessors, so the run takes at
+ *     least max(points/P, critical path).
+ */
+#ifndef PARALLELISMPROFILE_HPP_
+#define PARALLELISMPROFILE_HPP_
+
+#include "TileGraph.hpp"
+
+#include <vector>
+#include <iostream>
+
+struct WavefrontProfile {
+    int wavefront;
+    long long tiles;        // tiles with at least one point
+    long long emptyTiles;   // tiles the tiling enumerates without points
+    long long points;
+    long long maxPoints;    // points in the biggest tile
+};
+
+class ParallelismProfile {
+  public:
+    template <typename Tiling>
+    ParallelismProfile(const Tiling& tiling) : mGraph(tiling) {
+        mPoints.resize(mGraph.numTiles());
+        for (int k = 0; k < mGraph.numTiles(); k++) {
+            mPoints[k] = tiling.numPoints(mGraph.tile(k));
+        }
+        analyze();
+    }
+
+    const TileGraph& graph() const { return mGraph; }
+    long long tilePoints(int k) const { return mPoints[k]; }
+    const std::vector<WavefrontProfile>& wavefronts() const {
+        return mWavefronts;
+    }
+
+    long long totalPoints() const { return mTotalPoints; }
+    long long numTiles() const { return mNumTiles; }
+    long long numEmptyTiles() const { return mGraph.numTiles()-mNumTiles; }
+    // Points and non-empty tiles on the heaviest chain of tiles.
+    long long criticalPathPoints() const { return mCriticalPoints; }
+    long long criticalPathTiles() const { return mCriticalTiles; }
+
+    double wavefrontSpeedup(int P) const;
+    double dagSpeedup(int P) const;
+
+    // Writes the summary, the wavefronts, the speedups for P=1 to
+    // max_workers, and every non-empty tile.
+    void writeCSV(std::ostream& out, int max_workers) const;
+    void writeJSON(std::ostream& out, int max_workers) const;
+
+  private:
+    void analyze();
+
+    TileGraph mGraph;
+    std::vector<long long> mPoints;
+    std::vector<WavefrontProfile> mWavefronts;
+    long long mTotalPoints;
+    long long mNumTiles;
+    long long mCriticalPoints;
+    long long mCriticalTiles;
+};
+
+#endif
@@ -0,0 +1,156 @@
+/*!
+ * \file PhaseStats.cpp
+ *
+ * \brief Implements the --stats report of PhaseStats.
+ *
+ * The peak resident set size is from getrusage, which Linux reports in
+ * kilobytes.  The hardware counters of each thread live until the
+ * thread exits.
+ */
+#include "PhaseStats.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <memory>
+#include <sys/resource.h>
+
+PhaseStats phaseStats;
+thread_local PhaseTimer* PhaseTimer::sCurrent = NULL;
+
+static const char* phaseNames[num_phases] = {
+    "parse", "allocate", "traverse", "color", "emit"
+};
+
+HwCounters* threadHwCounters() {
+    if (!phaseStats.hwEnabled()) { return NULL; }
+    static thread_local std::unique_ptr<HwCounters> counters;
+    if (!counters) { counters.reset(new HwCounters()); }
+    return counters->ok() ? counters.get() : NULL;
+}
+
+PhaseStats::PhaseStats()
+    : mEnabled(false), mHwEnabled(false), mPoints(0), mTiles(0),
+      mEmptyTiles(0), mBytes(0), mStartCycles(0) {
+    for (int p = 0; p < num_phases; p++) {
+        mCycles[p] = 0;
+        mCalls[p] = 0;
+        for (int c = 0; c < num_hw_counters; c++) { mCounters[p][c] = 0; }
+    }
+    for (int c = 0; c < num_hw_counters; c++) { mHwHas[c] = false; }
+}
+
+void PhaseStats::enable() {
+    mEnabled = true;
+    {
+        HwCounters probe;
+        mHwEnabled = probe.ok();
+        mHwError = probe.error();
+        for (int c = 0; c < num_hw_counters; c++) {
+            mHwHas[c] = probe.has(c);
+        }
+    }
+    mStartTime = std::chrono::steady_clock::now();
+    mStartCycles = readCycles();
+}
+
+// Prints the counters that could be opened as "name": count pairs.
+void PhaseStats::printHwCounters(std::ostream& out,
+        const std::atomic<long long> counts[num_hw_counters]) const {
+    bool first = true;
+    for (int c = 0; c < num_hw_counters; c++) {
+        if (!mHwHas[c]) { continue; }
+        out << (first ? "" : ", ") << "\"" << hwCounterName(c) << "\": "
+            << counts[c];
+        first = false;
+    }
+}
+
+void PhaseStats::printJSON(std::ostream& out,
+                           const std::string& driver) const {
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - mStartTime).count();
+    double cycles = (double)(readCycles() - mStartCycles);
+    double rate = (seconds > 0.0) ? cycles/seconds : 0.0;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    out << "{" << std::endl
+        << "  \"driver\": \"" << driver << "\"," << std::endl
+        << "  \"wall_seconds\": " << seconds << "," << std::endl
+        << "  \"cycles_per_second\": " << rate << "," << std::endl
+        << "  \"phases\": {" << std::endl;
+    for (int p = 0; p < num_phases; p++) {
+        int64_t c = mCycles[p];
+        out << "    \"" << phaseNames[p] << "\": {\"cycles\": " << c
+            << ", \"seconds\": " << ((rate > 0.0) ? c/rate : 0.0)
+            << ", \"calls\": " << mCalls[p];
+        if (mHwEnabled) {
+            out << ", \"hw\": {";
+            printHwCounters(out, mCounters[p]);
+            out << "}";
+        }
+        out << "}" << ((p+1 < num_phases) ? "," : "") << std::endl;
+    }
+    out << "  }," << std::endl;
+    // Without the hardware counters the phases only have timer cycles.
+    out << "  \"hw_counters\": ";
+    if (mHwEnabled) {
+        long long total[num_hw_counters];
+        for (int c = 0; c < num_hw_counters; c++) {
+            total[c] = 0;
+            for (int p = 0; p < num_phases; p++) {
+                total[c] += mCounters[p][c];
+            }
+        }
+        out << "{\"available\": true";
+        for (int c = 0; c < num_hw_counters; c++) {
+            if (!mHwHas[c]) { continue; }
+            out << ", \"" << hwCounterName(c) << "_per_point\": "
+                << ((mPoints > 0) ? (double)total[c]/mPoints : 0.0);
+        }
+        out << "}," << std::endl;
+    } else {
+        out << "{\"available\": false, \"error\": \"" << mHwError
+            << "\"}," << std::endl;
+    }
+    out
+        << "  \"counters\": {\"points\": " << mPoints
+        << ", \"tiles\": " << mTiles
+        << ", \"empty_tiles\": " << mEmptyTiles
+        << ", \"bytes_written\": " << mBytes << "}," << std::endl
+        << "  \"peak_rss_kb\": " << usage.ru_maxrss << std::endl
+        << "}" << std::endl;
+}
+
+StatsReport::StatsReport(int& argc, char** argv, const std::string& driver)
+    : mDriver(driver) {
+    int kept = 1;
+    bool found = false;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--stats") == 0) {
+            found = true;
+        } else if (strncmp(argv[a], "--stats=", 8) == 0) {
+            found = true;
+            mFilename = argv[a]+8;
+        } else {
+            argv[kept++] = argv[a];
+        }
+    }
+    argc = kept;
+    argv[argc] = NULL;
+    if (found) { phaseStats.enable(); }
+}
+
+StatsReport::~StatsReport() {
+    if (!phaseStats.enabled()) { return; }
+    if (mFilename.empty()) {
+        phaseStats.printJSON(std::cout, mDriver);
+        return;
+    }
+    std::ofstream out(mFilename.c_str());
+    phaseStats.printJSON(out, mDriver);
+    if (!out) {
+        std::cerr << "Error: can not write stats to " << mFilename
+                  << std::endl;
+    }
+}
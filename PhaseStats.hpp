@@ -0,0 +1,196 @@
+/*!
+ * \file PhaseStats.hpp
+ *
+ * \brief Cycle counts of the phases of a driver and counters of its
+ *        work, reported as JSON with --stats.
+ *
+ * A PhaseTimer adds the cycles from its construction to its destruction
+ * to one phase.  Timers nest: the cycles of an inner timer are taken
+ * out of the phase of the outer timer on the same thread, so the phases
+ * add up to the timed time even when, for example, coloring happens
+ * inside the traversal.  A timer is meant for a whole loop or a batch
+ * of work; work done once per point or tile inside a timer is summed by
+ * a PhaseAccumulator instead.  The counts are atomic, so the threads of
+ * a slice-viz batch can share them.
+ *
+ * The cycles come from the time stamp counter where there is one, and
+ * are converted to seconds with the rate measured between the start of
+ * the run and the report.  With --stats each thread also opens the
+ * hardware counters in HwCounters.hpp.  Reading them is a system call,
+ * so only a timer with no timer around it on its thread reads them, and
+ * the counts of a phase include those of the phases timed inside it; if
+ * they can not be opened the report only has the cycles.  When --stats
+ * is not given a timer only tests a flag.
+ */
+#ifndef PHASESTATS_HPP_
+#define PHASESTATS_HPP_
+
+#include <atomic>
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <stdint.h>
+#include "HwCounters.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef enum {
+    phase_parse,        // command line parsing
+    phase_allocate,     // allocating the CellFieldArray
+    phase_traverse,     // visiting the points of the tiling
+    phase_color,        // picking the color of the points
+    phase_emit,         // writing the svg, pov, or image
+    num_phases
+} phase_type;
+
+static inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+class PhaseStats {
+  public:
+    PhaseStats();
+
+    bool enabled() const { return mEnabled; }
+    // Starts the clock for the report.
+    void enable();
+
+    void addCycles(phase_type phase, int64_t cycles) {
+        mCycles[phase] += cycles;
+    }
+    void addCall(phase_type phase) { mCalls[phase]++; }
+    void addCalls(phase_type phase, long long n) { mCalls[phase] += n; }
+
+    // Whether the hardware counters could be opened by enable().
+    bool hwEnabled() const { return mHwEnabled; }
+    void addCounters(phase_type phase, const HwSample& delta, int sign) {
+        for (int c = 0; c < num_hw_counters; c++) {
+            mCounters[phase][c] += sign*delta.value[c];
+        }
+    }
+
+    void countPoints(long long n) { mPoints += n; }
+    void countTiles(long long n) { mTiles += n; }
+    void countEmptyTiles(long long n) { mEmptyTiles += n; }
+    void countBytes(long long n) { mBytes += n; }
+
+    void printJSON(std::ostream& out, const std::string& driver) const;
+
+  private:
+    void printHwCounters(std::ostream& out,
+            const std::atomic<long long> counts[num_hw_counters]) const;
+
+    bool mEnabled;
+    bool mHwEnabled;
+    std::string mHwError;
+    bool mHwHas[num_hw_counters];
+    std::atomic<int64_t> mCycles[num_phases];
+    std::atomic<long long> mCounters[num_phases][num_hw_counters];
+    std::atomic<long long> mCalls[num_phases];
+    std::atomic<long long> mPoints, mTiles, mEmptyTiles, mBytes;
+    uint64_t mStartCycles;
+    std::chrono::steady_clock::time_point mStartTime;
+};
+
+// The stats of the running driver.
+extern PhaseStats phaseStats;
+
+// Hardware counters of the calling thread, opened on first use, or NULL
+// when phaseStats has no hardware counters.
+HwCounters* threadHwCounters();
+
+class PhaseTimer {
+  public:
+    explicit PhaseTimer(phase_type phase) : mPhase(phase), mActive(false) {
+        if (!phaseStats.enabled()) { return; }
+        mActive = true;
+        mParent = sCurrent;
+        sCurrent = this;
+        mCounters = mParent ? NULL : threadHwCounters();
+        if (mCounters) { mCounters->read(mStartCounts); }
+        mStart = readCycles();
+    }
+    ~PhaseTimer() {
+        if (!mActive) { return; }
+        int64_t cycles = (int64_t)(readCycles() - mStart);
+        if (mCounters) {
+            HwSample end, delta;
+            mCounters->read(end);
+            delta.clear();
+            delta.add(end, mStartCounts);
+            phaseStats.addCounters(mPhase, delta, 1);
+        }
+        phaseStats.addCycles(mPhase, cycles);
+        phaseStats.addCall(mPhase);
+        if (mParent) { phaseStats.addCycles(mParent->mPhase, -cycles); }
+        sCurrent = mParent;
+    }
+
+    // The innermost running timer of the calling thread, or NULL.
+    static PhaseTimer* current() { return sCurrent; }
+    phase_type phase() const { return mPhase; }
+
+  private:
+    phase_type mPhase;
+    bool mActive;
+    uint64_t mStart;
+    HwCounters* mCounters;      // NULL when nested or not available
+    HwSample mStartCounts;
+    PhaseTimer* mParent;
+    static thread_local PhaseTimer* sCurrent;
+};
+
+// Sums the cycles of many short spans of one phase inside a PhaseTimer,
+// such as coloring each tile while traversing, with one readCycles()
+// pair per span and no counter reads.  When it goes out of scope the sum
+// and the number of spans are added to the phase once, and the sum is
+// taken out of the phase of the enclosing timer.
+class PhaseAccumulator {
+  public:
+    explicit PhaseAccumulator(phase_type phase)
+        : mPhase(phase), mActive(phaseStats.enabled()), mStart(0),
+          mCycles(0), mSpans(0) {}
+    ~PhaseAccumulator() {
+        if (!mActive || mSpans == 0) { return; }
+        phaseStats.addCycles(mPhase, mCycles);
+        phaseStats.addCalls(mPhase, mSpans);
+        PhaseTimer* outer = PhaseTimer::current();
+        if (outer) { phaseStats.addCycles(outer->phase(), -mCycles); }
+    }
+
+    void start() {
+        if (mActive) { mStart = readCycles(); }
+    }
+    void stop() {
+        if (!mActive) { return; }
+        mCycles += (int64_t)(readCycles() - mStart);
+        mSpans++;
+    }
+
+  private:
+    phase_type mPhase;
+    bool mActive;
+    uint64_t mStart;
+    int64_t mCycles;
+    long long mSpans;
+};
+
+// Takes --stats or --stats=file out of argv before CmdParams sees it,
+// and when it goes out of scope writes the JSON to the file or stdout.
+class StatsReport {
+  public:
+    StatsReport(int& argc, char** argv, const std::string& driver);
+    ~StatsReport();
+
+  private:
+    std::string mDriver;
+    std::string mFilename;
+};
+
+#endif
@@ -0,0 +1,126 @@
+/*!
+ * \file PipelinedTiling.hpp
+ *
+ * \brief Runtime traversal of the pipelined (parallelogram) tiling for
+ *        any tau, sigma, and gamma.
+ *
+ * This is the tiling in pipelined.piscc, which used to only exist for
+ * one tile size as pipelined-4x4x4.is.  Tiles are defined by the
+ * hyperplanes t (tau wide), t+i (sigma wide), and t+j (gamma wide).
+ * With k0, k1, k2 being the tile indices along the three hyperplanes,
+ * all tiles with the same k0+k1+k2 can execute in parallel, which is
+ * the pipelined wavefront.  Unlike diamonds, the tiles at the start of
+ * the pipeline have to wait for the tiles before them to finish.
+ *
+ * Tile coordinates are (k0,k1,k2).
+ */
+#ifndef PIPELINEDTILING_HPP_
+#define PIPELINEDTILING_HPP_
+
+#include "Tiling.hpp"
+
+class PipelinedTiling {
+  public:
+    // Iteration space is 1<=t<=T, Li<=i<=Ui, Lj<=j<=Uj.
+    // Both sigma and gamma must be at least 2.
+    PipelinedTiling(int T, int Li, int Ui, int Lj, int Uj,
+                    int tau, int sigma, int gamma)
+        : mT(T), mLi(Li), mUi(Ui), mLj(Lj), mUj(Uj),
+          mTau(tau), mSigma(sigma), mGamma(gamma)
+    {
+        mK0Min = floorDiv(1, tau);
+        mK0Max = floorDiv(T, tau);
+    }
+
+    int firstWavefront() const {
+        return mK0Min + k1Min(mK0Min) + k2Min(mK0Min);
+    }
+    int lastWavefront() const {
+        return mK0Max + k1Max(mK0Max) + k2Max(mK0Max);
+    }
+
+    template <typename F>
+    void forEachTile(int w, F f) const {
+        for (int k0 = mK0Min; k0 <= mK0Max; k0++) {
+            int k1_lb = imax(k1Min(k0), w-k0-k2Max(k0));
+            int k1_ub = imin(k1Max(k0), w-k0-k2Min(k0));
+            for (int k1 = k1_lb; k1 <= k1_ub; k1++) {
+                TileCoord tile = {k0, k1, w-k0-k1};
+                f(tile);
+            }
+        }
+    }
+
+    // tau*k0 <= t < tau*(k0+1), sigma*k1 <= t+i < sigma*(k1+1),
+    // and gamma*k2 <= t+j < gamma*(k2+1).
+    template <typename F>
+    void forEachRow(const TileCoord& tile, F f) const {
+        int k0 = tile.c0, k1 = tile.c1, k2 = tile.c2;
+        for (int t = tLower(k0); t <= tUpper(k0); t++) {
+            int i_lb = imax(mLi, mSigma*k1-t);
+            int i_ub = imin(mUi, mSigma*k1+mSigma-1-t);
+            int j_lb = imax(mLj, mGamma*k2-t);
+            int j_ub = imin(mUj, mGamma*k2+mGamma-1-t);
+            if (j_lb > j_ub) { continue; }
+            for (int i = i_lb; i <= i_ub; i++) {
+                f(t, i, j_lb, j_ub);
+            }
+        }
+    }
+
+    // A stencil dependence moves t back by one and t+i and t+j back by
+    // at most 2, so each tile index drops by at most one.
+    template <typename F>
+    void forEachPredecessor(const TileCoord& tile, F f) const {
+        for (int d0 = 0; d0 <= 1; d0++) {
+            for (int d1 = 0; d1 <= 1; d1++) {
+                for (int d2 = 0; d2 <= 1; d2++) {
+                    if (d0+d1+d2 == 0) { continue; }
+                    TileCoord pred = {tile.c0-d0, tile.c1-d1, tile.c2-d2};
+                    f(pred);
+                }
+            }
+        }
+    }
+
+    // The count per time step is the length of the i range times the
+    // length of the j range.
+    long long numPoints(const TileCoord& tile) const {
+        int k0 = tile.c0, k1 = tile.c1, k2 = tile.c2;
+        int s1 = mSigma*k1, s2 = mGamma*k2;
+        LinearT i_bounds[] = {
+            {0, mLi}, {-1, s1}, {0, mUi}, {-1, s1+mSigma-1}
+        };
+        LinearT j_bounds[] = {
+            {0, mLj}, {-1, s2}, {0, mUj}, {-1, s2+mGamma-1}
+        };
+        TimeBreaks breaks;
+        breaks.addAllPairs(i_bounds, 4);
+        breaks.addAllPairs(j_bounds, 4);
+        return breaks.sum(tLower(k0), tUpper(k0), [&](int t) {
+            long long i_len = imin(mUi, s1+mSigma-1-t)-imax(mLi, s1-t)+1;
+            long long j_len = imin(mUj, s2+mGamma-1-t)-imax(mLj, s2-t)+1;
+            return (i_len > 0 && j_len > 0) ? i_len*j_len : 0;
+        });
+    }
+
+    int tau() const { return mTau; }
+    int sigma() const { return mSigma; }
+    int gamma() const { return mGamma; }
+
+  private:
+    // Time range and tile index ranges for the time tile k0.
+    int tLower(int k0) const { return imax(1, mTau*k0); }
+    int tUpper(int k0) const { return imin(mT, mTau*k0+mTau-1); }
+    int k1Min(int k0) const { return floorDiv(tLower(k0)+mLi, mSigma); }
+    int k1Max(int k0) const { return floorDiv(tUpper(k0)+mUi, mSigma); }
+    int k2Min(int k0) const { return floorDiv(tLower(k0)+mLj, mGamma); }
+    int k2Max(int k0) const { return floorDiv(tUpper(k0)+mUj, mGamma); }
+
+    int mT;
+    int mLi, mUi, mLj, mUj;
+    int mTau, mSigma, mGamma;
+    int mK0Min, mK0Max;
+};
+
+#endif
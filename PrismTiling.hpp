@@ -0,0 +1,159 @@
+/*!
+ * \file PrismTiling.hpp
+ *
+ * \brief Runtime traversal of the diamond prism tiling for any tau
+ *        and sigma.
+ *
+ * This is the tiling in diamond-prizms-skew.piscc, which used to only
+ * exist as the generated diamond-prizms-skew-*.is files.  Diamonds are
+ * formed in the t and i dimensions by the hyperplanes t+i (tau wide)
+ * and t-i (sigma wide), and the j dimension is not tiled.  With k0 and
+ * k1 being the tile indices along the two hyperplanes, the wavefront is
+ * thyme=k0+k1 and all prisms with the same thyme can execute in
+ * parallel.  When tau and sigma differ the diamonds are stretched along
+ * one of the diagonals.
+ *
+ * The prism spans (tau+sigma)/2 in i and by default as many time steps.
+ * A smaller height flattens it by using the hyperplanes a*t+b*i and
+ * a*t-b*i with a/b = (tau+sigma)/(2*height) and widths tau*b and
+ * sigma*b, so the i extent stays the same.  A stencil dependence moves
+ * a*t+-b*i back by a+b to a-b, which is legal as long as a >= b, so the
+ * height can not exceed the i extent.  With a = b = 1 these are the
+ * tiles of the generated files.
+ *
+ * Tile coordinates are (thyme,k1,0).
+ */
+#ifndef PRISMTILING_HPP_
+#define PRISMTILING_HPP_
+
+#include "Tiling.hpp"
+
+class PrismTiling {
+  public:
+    // Iteration space is 1<=t<=T, Li<=i<=Ui, Lj<=j<=Uj.
+    // Both tau and sigma must be at least 2.  A height of 0 is
+    // (tau+sigma)/2, otherwise it is at least 1 and at most that.
+    PrismTiling(int T, int Li, int Ui, int Lj, int Uj, int tau, int sigma,
+                int height = 0)
+        : mT(T), mLi(Li), mUi(Ui), mLj(Lj), mUj(Uj),
+          mTau(tau), mSigma(sigma), mA(1), mB(1)
+    {
+        mHeight = (height > 0) ? height : (tau+sigma)/2;
+        assert(2*mHeight <= tau+sigma);
+        if (2*mHeight < tau+sigma) {
+            int g = gcd(tau+sigma, 2*mHeight);
+            mA = (tau+sigma)/g;
+            mB = 2*mHeight/g;
+        }
+        mU = tau*mB;
+        mV = sigma*mB;
+        mK0Min = floorDiv(mA+mB*Li, mU);
+        mK0Max = floorDiv(mA*T+mB*Ui, mU);
+        mK1Min = floorDiv(mA-mB*Ui, mV);
+        mK1Max = floorDiv(mA*T-mB*Li, mV);
+    }
+
+    int firstWavefront() const { return mK0Min+mK1Min; }
+    int lastWavefront() const { return mK0Max+mK1Max; }
+
+    template <typename F>
+    void forEachTile(int thyme, F f) const {
+        int k1_lb = imax(mK1Min, thyme-mK0Max);
+        int k1_ub = imin(mK1Max, thyme-mK0Min);
+        for (int k1 = k1_lb; k1 <= k1_ub; k1++) {
+            TileCoord tile = {thyme, k1, 0};
+            f(tile);
+        }
+    }
+
+    // U*k0 <= a*t+b*i < U*(k0+1) and V*k1 <= a*t-b*i < V*(k1+1).
+    template <typename F>
+    void forEachRow(const TileCoord& tile, F f) const {
+        int k1 = tile.c1;
+        int k0 = tile.c0 - k1;
+        int u0 = mU*k0;
+        int v0 = mV*k1;
+        int t_lb = imax(1, ceilDiv(u0+v0, 2*mA));
+        int t_ub = imin(mT, floorDiv(u0+mU-1+v0+mV-1, 2*mA));
+        for (int t = t_lb; t <= t_ub; t++) {
+            int i_lb = iLower(u0, v0, t);
+            int i_ub = iUpper(u0, v0, t);
+            for (int i = i_lb; i <= i_ub; i++) {
+                f(t, i, mLj, mUj);
+            }
+        }
+    }
+
+    // A stencil dependence moves a*t+b*i and a*t-b*i back by at most
+    // a+b, so k0 drops by at most D0 = ceil((a+b)/U) and k1 by at most
+    // D1 = ceil((a+b)/V).  Both are one unless the prism is very flat.
+    template <typename F>
+    void forEachPredecessor(const TileCoord& tile, F f) const {
+        int d0_max = ceilDiv(mA+mB, mU);
+        int d1_max = ceilDiv(mA+mB, mV);
+        for (int d1 = 0; d1 <= d1_max; d1++) {
+            for (int d0 = 0; d0 <= d0_max; d0++) {
+                if (d0 == 0 && d1 == 0) { continue; }
+                TileCoord pred = {tile.c0-d0-d1, tile.c1-d1, 0};
+                f(pred);
+            }
+        }
+    }
+
+    // Every row spans all of j, so the count per time step is the
+    // length of the i range times the j extent.  When b > 1 the i bounds
+    // round, so the time steps are summed one at a time, which takes
+    // the height of the prism instead of its points.
+    long long numPoints(const TileCoord& tile) const {
+        int k1 = tile.c1;
+        int k0 = tile.c0 - k1;
+        int u0 = mU*k0;
+        int v0 = mV*k1;
+        int t_lb = imax(1, ceilDiv(u0+v0, 2*mA));
+        int t_ub = imin(mT, floorDiv(u0+mU-1+v0+mV-1, 2*mA));
+        long long width = mUj-mLj+1;
+        auto count = [&](int t) {
+            int i_lb = iLower(u0, v0, t);
+            int i_ub = iUpper(u0, v0, t);
+            return (i_lb <= i_ub) ? (i_ub-i_lb+1)*width : 0;
+        };
+        if (mB > 1) {
+            long long total = 0;
+            for (int t = t_lb; t <= t_ub; t++) { total += count(t); }
+            return total;
+        }
+        LinearT bounds[] = {
+            {0, mLi}, {-mA, u0}, {mA, -v0-mV+1},        // i lower bound
+            {0, mUi}, {-mA, u0+mU-1}, {mA, -v0}         // i upper bound
+        };
+        TimeBreaks breaks;
+        breaks.addAllPairs(bounds, 6);
+        return breaks.sum(t_lb, t_ub, count);
+    }
+
+    int tau() const { return mTau; }
+    int sigma() const { return mSigma; }
+    int height() const { return mHeight; }
+
+  private:
+    static int gcd(int x, int y) { return (y == 0) ? x : gcd(y, x%y); }
+
+    // The i range of the tile at time step t.
+    int iLower(int u0, int v0, int t) const {
+        return imax(mLi, imax(ceilDiv(u0-mA*t, mB),
+                              ceilDiv(mA*t-v0-mV+1, mB)));
+    }
+    int iUpper(int u0, int v0, int t) const {
+        return imin(mUi, imin(floorDiv(u0+mU-1-mA*t, mB),
+                              floorDiv(mA*t-v0, mB)));
+    }
+
+    int mT;
+    int mLi, mUi, mLj, mUj;
+    int mTau, mSigma, mHeight;
+    int mA, mB;         // the hyperplanes are a*t+b*i and a*t-b*i
+    int mU, mV;         // their widths, tau*b and sigma*b
+    int mK0Min, mK0Max, mK1Min, mK1Max;
+};
+
+#endif
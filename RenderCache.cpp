@@ -0,0 +1,159 @@
+/*!
+ * \file RenderCache.cpp
+ *
+ * \brief Implements the on-disk RenderCache.
+ *
+ * The file name of an artifact is the 64 bit FNV-1a hash of its key in
+ * hex, and the first line of the file is the key itself, so that two
+ * keys with the same hash never return each other's artifact.
+ * Temporary files start with a dot and are never evicted or
+ * fetched, and ones left over by a run that was killed are removed by
+ * evict() once they are an hour old.
+ */
+#include "RenderCache.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static uint64_t hashKey(const std::string& key) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t k = 0; k < key.size(); k++) {
+        h = (h ^ (unsigned char)key[k]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// Unique name for a temporary file in dir.
+static std::string tempName(const std::string& dir, long long count) {
+    std::stringstream ss;
+    ss << dir << "/.tmp." << getpid() << "." << count;
+    return ss.str();
+}
+
+static bool writeFile(const std::string& filename, const std::string& data) {
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    out.write(data.data(), data.size());
+    out.close();
+    return !out.fail();
+}
+
+bool writeFileAtomic(const std::string& filename, const std::string& data) {
+    static std::atomic<long long> count(0);
+    size_t slash = filename.rfind('/');
+    std::string dir = (slash == std::string::npos) ? "."
+                      : filename.substr(0, slash);
+    std::string temp = tempName(dir, count++);
+    if (!writeFile(temp, data) || rename(temp.c_str(), filename.c_str())) {
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+RenderCache::RenderCache(const std::string& dir, size_t max_bytes)
+    : mDir(dir), mMaxBytes(max_bytes), mOk(true), mHits(0), mMisses(0),
+      mStores(0), mEvictions(0) {
+    struct stat st;
+    if (mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST) {
+        mOk = false;
+    } else if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        mOk = false;
+    }
+    if (!mOk) {
+        std::cerr << "Error: can not use " << dir << " as the render cache"
+                  << std::endl;
+    }
+}
+
+std::string RenderCache::path(const std::string& key,
+                              const std::string& kind) const {
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hashKey(key));
+    return mDir + "/" + hex + "." + kind;
+}
+
+bool RenderCache::fetch(const std::string& key, const std::string& kind,
+                        std::string& data) {
+    std::string filename = path(key, kind);
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in) {
+        mMisses++;
+        return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    data = ss.str();
+    // The artifact of another key with the same hash.
+    size_t eol = data.find('\n');
+    if (eol != key.size() || data.compare(0, eol, key) != 0) {
+        data.clear();
+        mMisses++;
+        return false;
+    }
+    data.erase(0, eol+1);
+    // Mark it as recently used for evict().
+    utimensat(AT_FDCWD, filename.c_str(), NULL, 0);
+    mHits++;
+    return true;
+}
+
+bool RenderCache::store(const std::string& key, const std::string& kind,
+                        const std::string& data) {
+    if (!writeFileAtomic(path(key, kind), key + "\n" + data)) {
+        return false;
+    }
+    mStores++;
+    return true;
+}
+
+void RenderCache::evict() {
+    struct Artifact {
+        long long mtime;        // in ns
+        off_t size;
+        std::string filename;
+        bool operator<(const Artifact& other) const {
+            return mtime < other.mtime;
+        }
+    };
+    std::vector<Artifact> artifacts;
+    size_t total = 0;
+    DIR* dir = opendir(mDir.c_str());
+    if (!dir) { return; }
+    time_t now = time(NULL);
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        std::string filename = mDir + "/" + name;
+        struct stat st;
+        if (stat(filename.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (name.compare(0, 5, ".tmp.") == 0) {
+            if (now-st.st_mtime > 3600) { unlink(filename.c_str()); }
+            continue;
+        }
+        Artifact artifact = {st.st_mtim.tv_sec*1000000000LL
+                             + st.st_mtim.tv_nsec, st.st_size, filename};
+        artifacts.push_back(artifact);
+        total += st.st_size;
+    }
+    closedir(dir);
+
+    std::sort(artifacts.begin(), artifacts.end());
+    for (size_t k = 0; k < artifacts.size() && total > mMaxBytes; k++) {
+        // Another run may have evicted it already.
+        if (unlink(artifacts[k].filename.c_str()) == 0) { mEvictions++; }
+        total -= artifacts[k].size;
+    }
+}
@@ -0,0 +1,65 @@
+/*!
+ * \file RenderCache.hpp
+ *
+ * \brief Cache of rendered files in a directory, shared between runs.
+ *
+ * Each artifact is stored as <hash>.<kind> where the hash is of a key
+ * string that has to name every parameter the artifact depends on,
+ * including TILING_ENGINE_VERSION.  The key is written as the first
+ * line of the artifact and fetch() counts an artifact with a different
+ * key as a miss, so a hash collision is never served (and a key with a
+ * newline is never found).  slice-viz stores the recorded traversal
+ * (the tile of every point) as "trace" and each svg file as "svg", so
+ * a run whose svg is cached neither traverses nor renders.
+ *
+ * Artifacts are written to a temporary file in the directory and then
+ * renamed, so concurrent runs never see a partial file, and the last
+ * writer of the same artifact wins with identical contents.  Reading an
+ * artifact updates its modification time, and evict() removes the
+ * artifacts least recently read or written until the directory holds at
+ * most max_bytes.
+ */
+#ifndef RENDERCACHE_HPP_
+#define RENDERCACHE_HPP_
+
+#include <string>
+#include <atomic>
+#include <cstddef>
+
+class RenderCache {
+  public:
+    // Creates dir if it does not exist.  Check ok() afterwards.
+    RenderCache(const std::string& dir, size_t max_bytes);
+
+    bool ok() const { return mOk; }
+    const std::string& dir() const { return mDir; }
+
+    // Reads the artifact into data, returns false if it is not cached.
+    bool fetch(const std::string& key, const std::string& kind,
+               std::string& data);
+    // Atomically replaces the artifact, returns false on a write error.
+    // Can be called from several threads.
+    bool store(const std::string& key, const std::string& kind,
+               const std::string& data);
+    // Removes the least recently used artifacts until the cache fits.
+    void evict();
+
+    long long hits() const { return mHits; }
+    long long misses() const { return mMisses; }
+    long long stores() const { return mStores; }
+    long long evictions() const { return mEvictions; }
+
+  private:
+    std::string path(const std::string& key, const std::string& kind) const;
+
+    std::string mDir;
+    size_t mMaxBytes;
+    bool mOk;
+    std::atomic<long long> mHits, mMisses, mStores;
+    long long mEvictions;
+};
+
+// Writes data to filename through a temporary file and a rename.
+bool writeFileAtomic(const std::string& filename, const std::string& data);
+
+#endif
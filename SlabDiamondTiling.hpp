@@ -0,0 +1,231 @@
+/*!
+ * \file SlabDiamondTiling.hpp
+ *
+ * \brief The hand edited slab tile bounds of tile-space-viz.cpp written
+ *        as a tiling so that they can be checked.
+ *
+ * diamond-slice-viz and tile-space-viz.cpp tile one slab of
+ * 1<=t<=tau/3-2 with the 3D diamonds of T_diamond_with_skew, where
+ * tau*k0 <= t+i, tau*k1 <= t+j, and tau*k2 <= t-i-j.  The tile
+ * coordinates are the phase c0=k0+k1+k2, which is -2, -1, or 0 within
+ * the slab and is the wavefront, c1=k1, and c2=k2.  The c1_lb/c1_ub
+ * and c2_lb_min_expr/c2_ub_max_expr bounds in tile-space-viz.cpp were
+ * edited by hand from the iscc output so the c2 loop can be hoisted
+ * for OpenMP, and come in three versions:
+ *
+ *   - slab_bounds_param: the bounds from
+ *     Jacobi2D-DiamondSlabISCCParam-OMP.test.c, which depend on T.
+ *   - slab_bounds_fixed: the same with T replaced by tau/3-2.
+ *   - slab_bounds_unskew: the fixed bounds with c1 added in, so that
+ *     they enumerate c2+c1 instead of c2.
+ *
+ * and two loose versions that loop over x=c2+c1 in a range that does
+ * not depend on c1 and skew it back with c2=x-c1:
+ *
+ *   - slab_bounds_simple: the "SIMPLER LOOPS", with 0 <= c1 <=
+ *     (Uj+tau-3)/(tau-3) and (-Ui-tau+2)/(tau-3) <= x <= 0 in C integer
+ *     division as they are written.
+ *   - slab_bounds_projected: the "Unskewed c2 in iscc and then got
+ *     projection" loops, with the c1 bounds of slab_bounds_param for
+ *     T=tau/3-2 and floord(-Ui+4,tau)-1 <= x <= floord(-Li-(tau+4),tau)+1.
+ *
+ * The bounds are copied here as they are written in tile-space-viz.cpp,
+ * with the upper bounds Ui and Uj exclusive as they are there.  The
+ * points of each tile come from the c3, c4, and c5 loops of
+ * forEachSlabPoint in diamond-slice-viz.cpp.  Tile coordinates are
+ * (c0,c1,c2) as the bounds enumerate them, so c2+c1 for
+ * slab_bounds_unskew.
+ */
+#ifndef SLABDIAMONDTILING_HPP_
+#define SLABDIAMONDTILING_HPP_
+
+#include "Tiling.hpp"
+
+typedef enum {
+    slab_bounds_param,
+    slab_bounds_fixed,
+    slab_bounds_unskew,
+    slab_bounds_simple,
+    slab_bounds_projected
+} slab_bounds_type;
+
+class SlabDiamondTiling {
+  public:
+    // Iteration space is 1<=t<=T, Li<=i<=Ui, Lj<=j<=Uj.  tau must be a
+    // multiple of 3 and at least 9.
+    SlabDiamondTiling(int T, int Li, int Ui, int Lj, int Uj, int tau,
+                      slab_bounds_type bounds)
+        : mT(T), mLi(Li), mUi(Ui+1), mLj(Lj), mUj(Uj+1), mTau(tau),
+          mBounds(bounds) {}
+
+    int firstWavefront() const { return -2; }
+    int lastWavefront() const { return 0; }
+
+    template <typename F>
+    void forEachTile(int c0, F f) const {
+        int c1_lb, c1_ub;
+        c1Bounds(c0, c1_lb, c1_ub);
+        for (int c1 = c1_lb; c1 <= c1_ub; c1++) {
+            int c2_lb, c2_ub;
+            c2Bounds(c0, c1, c2_lb, c2_ub);
+            for (int c2 = c2_lb; c2 <= c2_ub; c2++) {
+                TileCoord tile = {c0, c1, c2};
+                f(tile);
+            }
+        }
+    }
+
+    // The c3 (t), c4 (i), and c5 (j) loops of diamond-slice-viz.
+    template <typename F>
+    void forEachRow(const TileCoord& tile, F f) const {
+        int c0 = tile.c0, c1 = tile.c1, c2 = skewedC2(tile);
+        int tau = mTau;
+        for (int t = 1; t <= mT; t++) {
+            int i_lb = imax(imax(imax(-tau*c1 - tau*c2 + 2*t - (2*tau-2),
+                                      -mUj - tau*c2 + t - (tau-2)),
+                                 tau*c0 - tau*c1 - tau*c2 - t), mLi);
+            int i_ub = imin(imin(imin(tau*c0 - tau*c1 - tau*c2 - t + (tau-1),
+                                      -tau*c1 - tau*c2 + 2*t),
+                                 -mLj - tau*c2 + t), mUi-1);
+            for (int i = i_lb; i <= i_ub; i++) {
+                int j_lb = imax(imax(tau*c1 - t, mLj),
+                                -tau*c2 + t - i - (tau-1));
+                int j_ub = imin(imin(mUj-1, -tau*c2 + t - i),
+                                tau*c1 - t + (tau-1));
+                if (j_lb <= j_ub) { f(t, i, j_lb, j_ub); }
+            }
+        }
+    }
+
+    // A stencil dependence moves t+i, t+j, and t-i-j back by 0 to 2, so
+    // each of k0, k1, and k2 drops by at most one.
+    template <typename F>
+    void forEachPredecessor(const TileCoord& tile, F f) const {
+        for (int a = 0; a <= 1; a++) {
+            for (int b = 0; b <= 1; b++) {
+                for (int c = 0; c <= 1; c++) {
+                    if (a+b+c == 0) { continue; }
+                    int c2 = skewedC2(tile) - c;
+                    if (mBounds == slab_bounds_unskew) { c2 += tile.c1-b; }
+                    TileCoord pred = {tile.c0-a-b-c, tile.c1-b, c2};
+                    f(pred);
+                }
+            }
+        }
+    }
+
+    // Counted a row at a time, so this takes time proportional to the
+    // rows of the tile rather than its points.
+    long long numPoints(const TileCoord& tile) const {
+        long long points = 0;
+        forEachRow(tile, [&](int, int, int j_lb, int j_ub) {
+            points += j_ub-j_lb+1;
+        });
+        return points;
+    }
+
+    int tau() const { return mTau; }
+
+  private:
+    int skewedC2(const TileCoord& tile) const {
+        return (mBounds == slab_bounds_unskew) ? tile.c2-tile.c1 : tile.c2;
+    }
+
+    // T in the param bounds and tau/3-2 in the others.
+    int slabT() const {
+        return (mBounds == slab_bounds_param) ? mT : mTau/3-2;
+    }
+
+    void c1Bounds(int c0, int& c1_lb, int& c1_ub) const {
+        int tau = mTau, Lj = mLj, Uj = mUj, T = slabT();
+        if (mBounds == slab_bounds_simple) {
+            c1_lb = 0;
+            c1_ub = (Uj+tau-3)/(tau-3);
+            return;
+        }
+        c1_lb = imax(imax(floorDiv(Lj + (tau/3)*c0 + (tau/3), tau),
+                          c0 + floorDiv(-2*T + Lj - 1, tau) + 1),
+                     floorDiv(Lj + 1, tau));
+        if (mBounds == slab_bounds_param
+                || mBounds == slab_bounds_projected) {
+            c1_ub = imin(imin(floorDiv(Uj + (tau/3)*c0 - ((tau/3)+2), tau)
+                              + 1,
+                              floorDiv(T + Uj - 1, tau)),
+                         c0 + floorDiv(Uj - 5, tau) + 2);
+        } else {
+            c1_ub = imin(floorDiv(Uj - ((tau/3)-3), tau),
+                         c0 + floorDiv(Uj - 5, tau) + 2);
+        }
+    }
+
+    void c2Bounds(int c0, int c1, int& c2_lb, int& c2_ub) const {
+        int tau = mTau, Li = mLi, Ui = mUi;
+        if (mBounds == slab_bounds_simple) {
+            c2_lb = (-Ui-tau+2)/(tau-3) - c1;
+            c2_ub = -c1;
+        } else if (mBounds == slab_bounds_projected) {
+            c2_lb = floorDiv(-Ui + 4, tau) - 1 - c1;
+            c2_ub = floorDiv(-Li - (tau+4), tau) + 1 - c1;
+        } else {
+            c2_lb = c2LbMin(c0, c1, c1);
+            c2_ub = c2UbMax(c0, c1, c1);
+        }
+    }
+
+    int c2LbMin(int c0, int c1_min, int c1_max) const {
+        int tau = mTau, Ui = mUi, Lj = mLj, Uj = mUj, T = slabT();
+        int lb = floorDiv(-Ui - Uj + 3, tau);
+        if (mBounds == slab_bounds_unskew) {
+            lb = imax(lb, c0 - c1_max + floorDiv(-Ui + Lj + 1, tau));
+            lb = imax(lb, floorDiv(-2*Ui - Uj + tau*c0 + (tau+1)*c1_min
+                                   - tau-3, tau*2) + 1);
+            lb = imax(lb, 2*c1_min + floorDiv(-Ui - 2*Uj + 3, tau));
+            lb = imax(lb, c0 + floorDiv(-T - Ui, tau) + 1);
+            lb = imax(lb, floorDiv(-Ui + 4, tau) - 1);
+            return lb;
+        }
+        lb = imax(lb, c0 - 2*c1_max + floorDiv(-Ui + Lj + 1, tau));
+        lb = imax(lb, -c1_max + floorDiv(-2*Ui - Uj + tau*c0 + tau*c1_min
+                                         - tau-3, tau*2) + 1);
+        lb = imax(lb, c1_min + floorDiv(-Ui - 2*Uj + 3, tau));
+        if (mBounds == slab_bounds_param) {
+            lb = imax(lb, c0 - c1_max + floorDiv(-Ui - (tau/3)*c0
+                                                 + ((tau/3)+1), tau));
+        }
+        lb = imax(lb, c0 - c1_max + floorDiv(-T - Ui, tau) + 1);
+        lb = imax(lb, -c1_max + floorDiv(-Ui + 4, tau) - 1);
+        return lb;
+    }
+
+    int c2UbMax(int c0, int c1_min, int c1_max) const {
+        int tau = mTau, Li = mLi, Lj = mLj, Uj = mUj, T = slabT();
+        int ub = floorDiv(T - Li - Lj, tau);
+        if (mBounds == slab_bounds_unskew) {
+            ub = imin(ub, c0 - c1_min + floorDiv(-Li + Uj - 2, tau) + 1);
+            ub = imin(ub, c0 + floorDiv(-Li - 2, tau) + 1);
+            ub = imin(ub, c0 + floorDiv(-Li - (tau/3)*c0 - ((tau/3)+1), tau)
+                          + 1);
+            ub = imin(ub, floorDiv(2*T - Li, tau));
+            ub = imin(ub, 2*c1_max + floorDiv(-Li - 2*Lj - 1, tau) + 1);
+            ub = imin(ub, floorDiv(-2*Li - Lj + tau*c0 + tau*c1_max
+                                   + (tau-1), tau*2));
+            return ub;
+        }
+        ub = imin(ub, c0 - 2*c1_min + floorDiv(-Li + Uj - 2, tau) + 1);
+        ub = imin(ub, c0 - c1_min + floorDiv(-Li - 2, tau) + 1);
+        ub = imin(ub, c0 - c1_min + floorDiv(-Li - (tau/3)*c0
+                                             - ((tau/3)+1), tau) + 1);
+        ub = imin(ub, -c1_min + floorDiv(2*T - Li, tau));
+        ub = imin(ub, c1_max + floorDiv(-Li - 2*Lj - 1, tau) + 1);
+        ub = imin(ub, -c1_min + floorDiv(-2*Li - Lj + tau*c0 + tau*c1_max
+                                         + (tau-1), tau*2));
+        return ub;
+    }
+
+    int mT;
+    int mLi, mUi, mLj, mUj;     // mUi and mUj are exclusive
+    int mTau;
+    slab_bounds_type mBounds;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/*!
+ * \file SliceRender.hpp
+ *
+ * \brief Recording the points of a traversal and drawing them as the
+ *        svg of slice-viz.
+ *
+ * A traversal is recorded once as the points in traversal order with
+ * the coordinates of their tiles, and each svg is drawn from it by
+ * coloring the points with a TileColorer into a CellFieldArray of the
+ * slices and printing that.  Kept out of slice-viz.cpp so that bench.cpp
+ * times the same code.
+ */
+#ifndef SLICERENDER_HPP_
+#define SLICERENDER_HPP_
+
+#include "Tiling.hpp"
+#include "TileColorer.hpp"
+#include "CellFieldArray.hpp"
+#include "svgprinter.hpp"
+#include "PhaseStats.hpp"
+#include <string>
+#include <sstream>
+#include <vector>
+#include <memory>
+#include <ostream>
+
+// One iteration point of the traversal with the coordinates of its tile.
+struct TracePoint {
+    int t, i, j;
+    int c1, c2, c3;
+    bool matchC3;   // whether one_tile has to match c3 too
+};
+
+// The points of a tiling in traversal order, and the start times of its
+// tiles when sim_workers > 0.
+struct Traversal {
+    std::vector<TracePoint> points;
+    StartFractionMap startFraction;
+
+    // Roughly, counting a map node as three pointers and the tuple.
+    size_t bytes() const {
+        return points.size()*sizeof(TracePoint) + startFraction.size()
+               *(3*sizeof(void*) + sizeof(StartFractionMap::value_type));
+    }
+};
+
+// Parameters of one svg file that do not change the traversal.
+struct RenderJob {
+    int Tstart, Tend;
+    int grid_spacing;
+    int cell_spacing, cell_radius;
+    bool label;
+    int color_incr;
+    bool one_tile;
+    int one_tile_c1, one_tile_c2, one_tile_c3;
+    bool footprint;
+    std::string filename;
+    std::string log;        // what the job prints, in job order
+};
+
+// Label of a tile.  Diamond prizms only have 2 dimensions of tiling, so
+// with two_dims the label leaves out c3.
+static inline std::string tileLabel(int c1, int c2, int c3, bool two_dims) {
+    std::stringstream ss;
+    if (two_dims) {
+        ss << c1 << "," << c2;
+    } else {
+        ss << c1 << "," << c2 << "," << c3;
+    }
+    return ss.str();
+}
+
+// Appends the points of a runtime tiling in traversal order.
+template <typename Tiling>
+void recordPoints(const Tiling& tiling, std::vector<TracePoint>& points) {
+    forEachPoint(tiling, [&](const TileCoord& tile, int t, int i, int j) {
+        TracePoint p = {t, i, j, tile.c0, tile.c1, tile.c2, true};
+        points.push_back(p);
+    });
+}
+
+// Colors the recorded traversal of the T time steps over the NxN grid
+// for the job and writes its svg to out.  mark(slices) is called after
+// coloring, such as to outline the footprint of the one tile.
+template <typename F>
+void renderSVG(const RenderJob& job, const Traversal& traversal, int T,
+               int N, bool two_dims, std::ostream& out, F mark) {
+    // Specify file and height and width.
+    SVGPrinter svg(out, job.cell_spacing*(N+1)
+                         + ((job.Tend-job.Tstart+1)-1)*job.grid_spacing,
+                   (N+1)*job.cell_spacing);
+    {
+        PhaseTimer timer(phase_emit);
+        svg.printHeader();
+    }
+
+    // Declare the array of iteration spaces.
+    // FIXME: the N+1 is so we can start our spatial dimensions at 1.
+    // The CellFieldArray handles the fact that T starts at 1, but not
+    // that N starts at 1.
+    std::unique_ptr<CellFieldArray> slices;
+    {
+        PhaseTimer timer(phase_allocate);
+        slices.reset(new CellFieldArray(T,N+1,N+1,job.grid_spacing,
+                                        job.Tstart,job.Tend,
+                                        job.cell_spacing,job.cell_radius));
+    }
+
+    {
+        PhaseTimer timer(phase_color);
+        TileColorer colorer(job.color_incr, traversal.startFraction,
+                            two_dims);
+        for (size_t k = 0; k < traversal.points.size(); k++) {
+            const TracePoint& p = traversal.points[k];
+            if (job.label) {
+                slices->setLabel(p.t,p.i,p.j,
+                                 tileLabel(p.c1,p.c2,p.c3,two_dims));
+            }
+            if (!job.one_tile
+                    || (p.c1==job.one_tile_c1 && p.c2==job.one_tile_c2
+                        && (!p.matchC3 || p.c3==job.one_tile_c3))) {
+                slices->setFill(p.t,p.i,p.j,colorer.color(p.c1,p.c2,p.c3));
+            }
+        }
+        mark(*slices);
+    }
+
+    {
+        PhaseTimer timer(phase_emit);
+        // Print the array of iteration slices out to the file.
+        slices->printToSVG(svg,job.Tstart,job.Tend);
+
+        // End of the file.
+        svg.printFooter();
+    }
+
+    PhaseTimer timer(phase_allocate);
+    slices.reset();
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*!
+ * \file StencilKernels.cpp
+ *
+ * \brief Implements the scalar, AVX2, and AVX-512 row kernels.
+ */
+#include "StencilKernels.hpp"
+
+#include <immintrin.h>
+
+void rowKernelScalar(const double* __restrict up,
+                     const double* __restrict mid,
+                     const double* __restrict down,
+                     double* __restrict out, int jlo, int jhi) {
+    for (int j = jlo; j <= jhi; j++) {
+        out[j] = (up[j] + mid[j-1] + down[j] + mid[j+1] + 2*mid[j])*.167;
+    }
+}
+
+__attribute__((target("avx2")))
+void rowKernelAVX2(const double* __restrict up,
+                   const double* __restrict mid,
+                   const double* __restrict down,
+                   double* __restrict out, int jlo, int jhi) {
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d coef = _mm256_set1_pd(.167);
+    int j = jlo;
+    for (; j+3 <= jhi; j += 4) {
+        __m256d sum = _mm256_add_pd(_mm256_loadu_pd(up+j),
+                                    _mm256_loadu_pd(mid+j-1));
+        sum = _mm256_add_pd(sum, _mm256_loadu_pd(down+j));
+        sum = _mm256_add_pd(sum, _mm256_loadu_pd(mid+j+1));
+        sum = _mm256_add_pd(sum,
+                  _mm256_mul_pd(two, _mm256_loadu_pd(mid+j)));
+        _mm256_storeu_pd(out+j, _mm256_mul_pd(sum, coef));
+    }
+
+    // Remaining 1 to 3 elements, also the whole row for short rows.
+    int rest = jhi-j+1;
+    if (rest > 0) {
+        __m256i mask = _mm256_cmpgt_epi64(_mm256_set1_epi64x(rest),
+                                          _mm256_set_epi64x(3,2,1,0));
+        __m256d sum = _mm256_add_pd(_mm256_maskload_pd(up+j, mask),
+                                    _mm256_maskload_pd(mid+j-1, mask));
+        sum = _mm256_add_pd(sum, _mm256_maskload_pd(down+j, mask));
+        sum = _mm256_add_pd(sum, _mm256_maskload_pd(mid+j+1, mask));
+        sum = _mm256_add_pd(sum,
+                  _mm256_mul_pd(two, _mm256_maskload_pd(mid+j, mask)));
+        _mm256_maskstore_pd(out+j, mask, _mm256_mul_pd(sum, coef));
+    }
+}
+
+__attribute__((target("avx512f")))
+void rowKernelAVX512(const double* __restrict up,
+                     const double* __restrict mid,
+                     const double* __restrict down,
+                     double* __restrict out, int jlo, int jhi) {
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d coef = _mm512_set1_pd(.167);
+    int j = jlo;
+    for (; j+7 <= jhi; j += 8) {
+        __m512d sum = _mm512_add_pd(_mm512_loadu_pd(up+j),
+                                    _mm512_loadu_pd(mid+j-1));
+        sum = _mm512_add_pd(sum, _mm512_loadu_pd(down+j));
+        sum = _mm512_add_pd(sum, _mm512_loadu_pd(mid+j+1));
+        sum = _mm512_add_pd(sum,
+                  _mm512_mul_pd(two, _mm512_loadu_pd(mid+j)));
+        _mm512_storeu_pd(out+j, _mm512_mul_pd(sum, coef));
+    }
+
+    // Remaining 1 to 7 elements, also the whole row for short rows.
+    int rest = jhi-j+1;
+    if (rest > 0) {
+        __mmask8 mask = (__mmask8)((1u<<rest)-1);
+        __m512d sum = _mm512_add_pd(_mm512_maskz_loadu_pd(mask, up+j),
+                                    _mm512_maskz_loadu_pd(mask, mid+j-1));
+        sum = _mm512_add_pd(sum, _mm512_maskz_loadu_pd(mask, down+j));
+        sum = _mm512_add_pd(sum, _mm512_maskz_loadu_pd(mask, mid+j+1));
+        sum = _mm512_add_pd(sum,
+                  _mm512_mul_pd(two, _mm512_maskz_loadu_pd(mask, mid+j)));
+        _mm512_mask_storeu_pd(out+j, mask, _mm512_mul_pd(sum, coef));
+    }
+}
+
+RowKernel selectRowKernel(kernel_type& choice) {
+    __builtin_cpu_init();
+    bool has_avx512 = __builtin_cpu_supports("avx512f");
+    bool has_avx2 = __builtin_cpu_supports("avx2");
+
+    if (choice==kernel_auto) {
+        choice = has_avx512 ? kernel_avx512
+               : (has_avx2 ? kernel_avx2 : kernel_scalar);
+    }
+    if (choice==kernel_avx512 && !has_avx512) {
+        choice = has_avx2 ? kernel_avx2 : kernel_scalar;
+    }
+    if (choice==kernel_avx2 && !has_avx2) {
+        choice = kernel_scalar;
+    }
+
+    switch (choice) {
+        case kernel_avx512: return rowKernelAVX512;
+        case kernel_avx2:   return rowKernelAVX2;
+        default:            return rowKernelScalar;
+    }
+}
+
+const char* kernelName(kernel_type choice) {
+    switch (choice) {
+        case kernel_auto:   return "auto";
+        case kernel_scalar: return "scalar";
+        case kernel_avx2:   return "avx2";
+        case kernel_avx512: return "avx512";
+    }
+    return "unknown";
+}
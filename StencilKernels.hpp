@@ -0,0 +1,43 @@
+/*!
+ * \file StencilKernels.hpp
+ *
+ * \brief Row kernels for the Jacobi 2D stencil.
+ *
+ * A row kernel computes A(t,i,jlo..jhi) from the three rows i-1, i, and
+ * i+1 of A(t-1,*,*).  The tile traversals hand out one contiguous j
+ * span per (t,i), so all of the vectorization happens here.  The AVX2
+ * and AVX-512 versions are compiled with target attributes and picked
+ * at runtime, and use masked loads and stores for the ends of rows that
+ * are narrower than a vector.  All versions add the terms in the same
+ * order as the scalar version so the results are identical.
+ */
+#ifndef STENCILKERNELS_HPP_
+#define STENCILKERNELS_HPP_
+
+typedef void (*RowKernel)(const double* up, const double* mid,
+                          const double* down, double* out,
+                          int jlo, int jhi);
+
+typedef enum {
+    kernel_auto,
+    kernel_scalar,
+    kernel_avx2,
+    kernel_avx512
+} kernel_type;
+
+void rowKernelScalar(const double* up, const double* mid,
+                     const double* down, double* out, int jlo, int jhi);
+void rowKernelAVX2(const double* up, const double* mid,
+                   const double* down, double* out, int jlo, int jhi);
+void rowKernelAVX512(const double* up, const double* mid,
+                     const double* down, double* out, int jlo, int jhi);
+
+// Returns the kernel for the given choice.  kernel_auto picks the
+// widest one the processor supports.  If the requested kernel is not
+// supported then choice is changed to the kernel that will be used.
+RowKernel selectRowKernel(kernel_type& choice);
+
+// Name of the kernel for printing.
+const char* kernelName(kernel_type choice);
+
+#endif
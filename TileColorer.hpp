@@ -0,0 +1,85 @@
+/*!
+ * \file TileColorer.hpp
+ *
+ * \brief Fill colors of the points of a traversal in slice-viz.
+ *
+ * The color of a point depends on its tile and on the order the tiles
+ * are traversed, or on the start time of its tile in a simulated run.
+ * Kept out of slice-viz.cpp so that bench.cpp times the same code.
+ */
+#ifndef TILECOLORER_HPP_
+#define TILECOLORER_HPP_
+
+#include <string>
+#include <sstream>
+#include <map>
+#include <tuple>
+
+// Array of colors.
+static const std::string svgColors[] = 
+//{"bisque","red","aqua","yellow","blue","green","fuchsia","lime","silver","coral","lavender","pink","powderblue","plum","palegreen"};
+{"red","yellow","green","lime","aqua","blue","fuchsia","silver","bisque","coral","lavender","pink","powderblue","plum","palegreen","teal","navy"};
+//{"maroon","red","olive","yellow","green","lime","teal","aqua","navy","blue","purple","fuchsia","black","grey","silver","white"};
+//{"yellow","green","aqua","navy","red","teal","fuchsia","lime","maroon","silver","olive","blue","black","purple","gray","white"};
+static const int num_colors = 17;
+
+// Start time of each tile in the simulated run as a fraction of the
+// makespan.
+typedef std::map< std::tuple<int,int,int>, double > StartFractionMap;
+
+// Blue for the tiles that start first through green to red for the
+// tiles that start last.
+static inline std::string startTimeToColor(double fraction) {
+    int r = 0, g = 0, b = 0;
+    if (fraction < 0.5) {
+        g = (int)(510*fraction);
+        b = 255-g;
+    } else {
+        r = (int)(510*(fraction-0.5));
+        g = 255-r;
+    }
+    std::stringstream ss;
+    ss << "rgb(" << r << "," << g << "," << b << ")";
+    return ss.str();
+}
+
+// Picks the fill of each point from its tile coordinates.  The color
+// changes by incr every time the tile changes, so the points have to be
+// colored in traversal order.  With two_dims only c1 and c2 count.
+// If there are start times the color is the start time instead.
+class TileColorer {
+  public:
+    TileColorer(int incr, const StartFractionMap& start_fraction,
+                bool two_dims)
+        : mIncr(incr), mCount(-1), mLastC1(-99), mLastC2(-99), mLastC3(-99),
+          mTwoDims(two_dims), mStartFraction(start_fraction) {}
+
+    std::string color(int c1, int c2, int c3) {
+        if (!mStartFraction.empty()) {
+            StartFractionMap::const_iterator iter
+                = mStartFraction.find(std::make_tuple(c1,c2,c3));
+            return startTimeToColor(
+                (iter != mStartFraction.end()) ? iter->second : 0.0);
+        }
+
+        // We want to change the tile color if the tile coordinate
+        // has changed.
+        if (c1!=mLastC1 || c2!=mLastC2 || (!mTwoDims && c3!=mLastC3)) {
+            mLastC1 = c1;
+            mLastC2 = c2;
+            mLastC3 = c3;
+            mCount += mIncr;
+        }
+
+        return svgColors[ mCount % num_colors ];
+    }
+
+  private:
+    int mIncr;
+    int mCount;
+    int mLastC1, mLastC2, mLastC3;
+    bool mTwoDims;
+    const StartFractionMap& mStartFraction;
+};
+
+#endif
@@ -0,0 +1,226 @@
+/*!
+ * \file TileDag.cpp
+ *
+ * \brief Implements the tile graph file writers and MappedTileDag.
+ */
+#include "TileDag.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <limits.h>
+#include <fstream>
+
+// Rounds a byte offset up to a multiple of 8.
+static int64_t align8(int64_t offset) {
+    return (offset+7) & ~(int64_t)7;
+}
+
+// Writes count elements converted to type T, a block at a time, then
+// pads to a multiple of 8 bytes.
+template <typename T, typename Iter>
+static void writeArray(std::ofstream& out, Iter begin, int64_t count) {
+    const int64_t block = 1<<16;
+    std::vector<T> buffer(count < block ? count : block);
+    for (int64_t k = 0; k < count; k += block) {
+        int64_t n = (count-k < block) ? count-k : block;
+        for (int64_t m = 0; m < n; m++, ++begin) { buffer[m] = (T)*begin; }
+        out.write((const char*)buffer.data(), n*sizeof(T));
+    }
+    int64_t bytes = count*(int64_t)sizeof(T);
+    static const char zeros[8] = {0};
+    out.write(zeros, align8(bytes)-bytes);
+}
+
+bool writeTileDag(const char* filename, const TileGraph& graph,
+                  const std::vector<long long>& points,
+                  const std::vector<long long>& halo_bytes) {
+    int64_t num_tiles = graph.numTiles();
+    int64_t num_edges = graph.numEdges();
+
+    TileDagHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, TILEDAG_MAGIC, sizeof(header.magic));
+    header.version = TILEDAG_VERSION;
+    header.headerSize = sizeof(TileDagHeader);
+    header.numTiles = num_tiles;
+    header.numEdges = num_edges;
+    int64_t offset = align8(sizeof(TileDagHeader));
+    header.coordsOffset = offset;
+    offset += align8(3*num_tiles*sizeof(int32_t));
+    header.wavefrontOffset = offset;
+    offset += align8(num_tiles*sizeof(int32_t));
+    header.pointsOffset = offset;
+    offset += num_tiles*sizeof(int64_t);
+    header.haloBytesOffset = offset;
+    offset += num_tiles*sizeof(int64_t);
+    header.predStartOffset = offset;
+    offset += align8((num_tiles+1)*sizeof(int32_t));
+    header.predOffset = offset;
+    offset += align8(num_edges*sizeof(int32_t));
+    header.succStartOffset = offset;
+    offset += align8((num_tiles+1)*sizeof(int32_t));
+    header.succOffset = offset;
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) { return false; }
+    out.write((const char*)&header, sizeof(header));
+    static const char zeros[8] = {0};
+    out.write(zeros, header.coordsOffset-sizeof(header));
+
+    std::vector<int32_t> ints(3*num_tiles);
+    for (int k = 0; k < num_tiles; k++) {
+        ints[3*k] = graph.tile(k).c0;
+        ints[3*k+1] = graph.tile(k).c1;
+        ints[3*k+2] = graph.tile(k).c2;
+    }
+    writeArray<int32_t>(out, ints.begin(), 3*num_tiles);
+    ints.resize(num_tiles);
+    for (int k = 0; k < num_tiles; k++) { ints[k] = graph.wavefront(k); }
+    writeArray<int32_t>(out, ints.begin(), num_tiles);
+    writeArray<int64_t>(out, points.begin(), num_tiles);
+    writeArray<int64_t>(out, halo_bytes.begin(), num_tiles);
+
+    // CSR arrays, rebuilt from the per tile accessors.
+    std::vector<int32_t> start(num_tiles+1), edges;
+    edges.reserve(num_edges);
+    start[0] = 0;
+    for (int k = 0; k < num_tiles; k++) {
+        edges.insert(edges.end(), graph.preds(k),
+                     graph.preds(k)+graph.numPreds(k));
+        start[k+1] = (int32_t)edges.size();
+    }
+    writeArray<int32_t>(out, start.begin(), num_tiles+1);
+    writeArray<int32_t>(out, edges.begin(), num_edges);
+    edges.clear();
+    for (int k = 0; k < num_tiles; k++) {
+        edges.insert(edges.end(), graph.succs(k),
+                     graph.succs(k)+graph.numSuccs(k));
+        start[k+1] = (int32_t)edges.size();
+    }
+    writeArray<int32_t>(out, start.begin(), num_tiles+1);
+    writeArray<int32_t>(out, edges.begin(), num_edges);
+    return (bool)out;
+}
+
+bool writeTileDot(const char* filename, const TileGraph& graph,
+                  const std::vector<long long>& points,
+                  const std::vector<long long>& halo_bytes) {
+    std::ofstream out(filename);
+    if (!out) { return false; }
+    out << "digraph tiles {" << std::endl;
+    out << "  rankdir=LR;" << std::endl;
+    // One rank per wavefront.
+    int k = 0;
+    while (k < graph.numTiles()) {
+        out << "  { rank=same;";
+        int w = graph.wavefront(k);
+        for (; k < graph.numTiles() && graph.wavefront(k) == w; k++) {
+            const TileCoord& tile = graph.tile(k);
+            out << " t" << k << " [label=\"(" << tile.c0 << "," << tile.c1
+                << "," << tile.c2 << ")\\n" << points[k] << " points\\n"
+                << halo_bytes[k] << " halo bytes\"];";
+        }
+        out << " }" << std::endl;
+    }
+    for (int k = 0; k < graph.numTiles(); k++) {
+        for (int p = 0; p < graph.numPreds(k); p++) {
+            out << "  t" << graph.preds(k)[p] << " -> t" << k << ";"
+                << std::endl;
+        }
+    }
+    out << "}" << std::endl;
+    return (bool)out;
+}
+
+MappedTileDag::MappedTileDag() : mData(NULL), mSize(0), mHeader(NULL) {}
+
+MappedTileDag::~MappedTileDag() {
+    close();
+}
+
+// Whether count elements of elem_size bytes at offset lie after the
+// header and inside a file of size bytes, starting at a multiple of 8.
+static bool arrayFits(int64_t offset, int64_t count, int64_t elem_size,
+                      int64_t size) {
+    return offset >= (int64_t)sizeof(TileDagHeader) && offset%8 == 0
+           && offset <= size && count >= 0
+           && count <= (size-offset)/elem_size;
+}
+
+// Whether the CSR start array never decreases, runs from 0 to
+// num_edges, and the entries it points at are tile numbers.
+static bool csrValid(const int32_t* start, const int32_t* entries,
+                     int64_t num_tiles, int64_t num_edges) {
+    if (start[0] != 0 || start[num_tiles] != num_edges) { return false; }
+    for (int64_t k = 0; k < num_tiles; k++) {
+        if (start[k+1] < start[k]) { return false; }
+    }
+    for (int64_t e = 0; e < num_edges; e++) {
+        if (entries[e] < 0 || entries[e] >= num_tiles) { return false; }
+    }
+    return true;
+}
+
+bool MappedTileDag::open(const char* filename) {
+    close();
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) { return false; }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(TileDagHeader)) {
+        ::close(fd);
+        return false;
+    }
+    mSize = info.st_size;
+    mData = mmap(NULL, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mData == MAP_FAILED) {
+        mData = NULL;
+        return false;
+    }
+
+    // Every array has to be inside the file, so that a truncated or
+    // corrupt file is rejected here instead of being read out of bounds.
+    mHeader = (const TileDagHeader*)mData;
+    int64_t size = (int64_t)mSize;
+    int64_t tiles = mHeader->numTiles, edges = mHeader->numEdges;
+    if (strncmp(mHeader->magic, TILEDAG_MAGIC, sizeof(mHeader->magic)) != 0
+        || mHeader->version != TILEDAG_VERSION
+        || mHeader->headerSize != (int32_t)sizeof(TileDagHeader)
+        || tiles < 0 || tiles >= INT_MAX || edges < 0 || edges > INT_MAX
+        || !arrayFits(mHeader->coordsOffset, 3*tiles, 4, size)
+        || !arrayFits(mHeader->wavefrontOffset, tiles, 4, size)
+        || !arrayFits(mHeader->pointsOffset, tiles, 8, size)
+        || !arrayFits(mHeader->haloBytesOffset, tiles, 8, size)
+        || !arrayFits(mHeader->predStartOffset, tiles+1, 4, size)
+        || !arrayFits(mHeader->predOffset, edges, 4, size)
+        || !arrayFits(mHeader->succStartOffset, tiles+1, 4, size)
+        || !arrayFits(mHeader->succOffset, edges, 4, size)) {
+        close();
+        return false;
+    }
+    const char* base = (const char*)mData;
+    mCoords = (const int32_t*)(base + mHeader->coordsOffset);
+    mWavefront = (const int32_t*)(base + mHeader->wavefrontOffset);
+    mPoints = (const int64_t*)(base + mHeader->pointsOffset);
+    mHaloBytes = (const int64_t*)(base + mHeader->haloBytesOffset);
+    mPredStart = (const int32_t*)(base + mHeader->predStartOffset);
+    mPred = (const int32_t*)(base + mHeader->predOffset);
+    mSuccStart = (const int32_t*)(base + mHeader->succStartOffset);
+    mSucc = (const int32_t*)(base + mHeader->succOffset);
+    if (!csrValid(mPredStart, mPred, tiles, edges)
+        || !csrValid(mSuccStart, mSucc, tiles, edges)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedTileDag::close() {
+    if (mData) { munmap(mData, mSize); }
+    mData = NULL;
+    mSize = 0;
+    mHeader = NULL;
+}
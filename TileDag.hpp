@@ -0,0 +1,101 @@
+/*!
+ * \file TileDag.hpp
+ *
+ * \brief Binary and DOT files for a TileGraph with per tile annotations.
+ *
+ * The binary file is meant to be mapped into memory by an external
+ * scheduler or simulator and used in place.  It starts with a
+ * TileDagHeader followed by arrays that each start at a multiple of 8
+ * bytes, in the byte order of the machine that wrote it:
+ *
+ *      int32 coords[3*numTiles]        (c0,c1,c2) in schedule order
+ *      int32 wavefront[numTiles]
+ *      int64 points[numTiles]          iteration points in the tile
+ *      int64 haloBytes[numTiles]       bytes read from outside the tile
+ *      int32 predStart[numTiles+1]     CSR predecessors as in TileGraph
+ *      int32 pred[numEdges]
+ *      int32 succStart[numTiles+1]     CSR successors
+ *      int32 succ[numEdges]
+ *
+ * The header holds the byte offset of each array from the start of the
+ * file.
+ */
+#ifndef TILEDAG_HPP_
+#define TILEDAG_HPP_
+
+#include "TileGraph.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+#define TILEDAG_MAGIC "TILEDAG"
+#define TILEDAG_VERSION 1
+
+struct TileDagHeader {
+    char magic[8];
+    int32_t version;
+    int32_t headerSize;
+    int64_t numTiles;
+    int64_t numEdges;
+    int64_t coordsOffset;
+    int64_t wavefrontOffset;
+    int64_t pointsOffset;
+    int64_t haloBytesOffset;
+    int64_t predStartOffset;
+    int64_t predOffset;
+    int64_t succStartOffset;
+    int64_t succOffset;
+};
+
+// points and halo_bytes are indexed by the tile numbers of graph.
+// Both writers return false if the file can not be written.
+bool writeTileDag(const char* filename, const TileGraph& graph,
+                  const std::vector<long long>& points,
+                  const std::vector<long long>& halo_bytes);
+
+bool writeTileDot(const char* filename, const TileGraph& graph,
+                  const std::vector<long long>& points,
+                  const std::vector<long long>& halo_bytes);
+
+// Read only view of a tile graph file mapped into memory.
+class MappedTileDag {
+  public:
+    MappedTileDag();
+    ~MappedTileDag();
+
+    // Returns false if the file can not be mapped, is not a tile graph
+    // file of this version, or has arrays outside the file or edges to
+    // tiles that do not exist.
+    bool open(const char* filename);
+    void close();
+
+    int numTiles() const { return (int)mHeader->numTiles; }
+    int numEdges() const { return (int)mHeader->numEdges; }
+    TileCoord tile(int k) const {
+        TileCoord tile = {mCoords[3*k], mCoords[3*k+1], mCoords[3*k+2]};
+        return tile;
+    }
+    int wavefront(int k) const { return mWavefront[k]; }
+    long long points(int k) const { return mPoints[k]; }
+    long long haloBytes(int k) const { return mHaloBytes[k]; }
+
+    int numPreds(int k) const { return mPredStart[k+1]-mPredStart[k]; }
+    const int32_t* preds(int k) const { return mPred + mPredStart[k]; }
+    int numSuccs(int k) const { return mSuccStart[k+1]-mSuccStart[k]; }
+    const int32_t* succs(int k) const { return mSucc + mSuccStart[k]; }
+
+  private:
+    void* mData;
+    size_t mSize;
+    const TileDagHeader* mHeader;
+    const int32_t* mCoords;
+    const int32_t* mWavefront;
+    const int64_t* mPoints;
+    const int64_t* mHaloBytes;
+    const int32_t* mPredStart;
+    const int32_t* mPred;
+    const int32_t* mSuccStart;
+    const int32_t* mSucc;
+};
+
+#endif
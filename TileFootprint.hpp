@@ -0,0 +1,370 @@
+/*!
+ * \file TileFootprint.hpp
+ *
+ * \brief Data footprint of a single tile of any tiling in Tiling.hpp.
+ *
+ * This computes at runtime what diamond-footprint-Heat1d.iscc and
+ * bound-computations.iscc compute offline with iscc and barvinok, but
+ * for the Jacobi 2D stencil.  A(t,i,j) is stored in buffer t%num_buffers,
+ * so num_buffers=2 is the ping/pong storage and num_buffers=T+1 is no
+ * storage reuse at all.  The footprint counts distinct memory locations,
+ * so with fewer buffers than time steps in the tile, locations that are
+ * reused count once.
+ *
+ * Rows of the tile are kept as j intervals and merged per row of each
+ * buffer, so the cost is proportional to the number of rows in the tile
+ * instead of the number of points and tau can get large enough to
+ * overflow an L3 cache.
+ */
+#ifndef TILEFOOTPRINT_HPP_
+#define TILEFOOTPRINT_HPP_
+
+#include "Tiling.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+struct Footprint {
+    long long points;       // iteration points in the tile
+    long long readBytes;    // distinct locations read
+    long long writeBytes;   // distinct locations written
+    long long totalBytes;   // distinct locations read or written
+    long long haloBytes;    // values read that the tile does not compute
+};
+
+// Inclusive range of j values.
+struct Interval {
+    int lo, hi;
+    bool operator<(const Interval& other) const { return lo < other.lo; }
+};
+
+// Sorts and merges overlapping or adjacent intervals in place and
+// returns the number of j values covered.
+inline long long mergeIntervals(std::vector<Interval>& v) {
+    if (v.empty()) { return 0; }
+    std::sort(v.begin(), v.end());
+    size_t last = 0;
+    for (size_t k = 1; k < v.size(); k++) {
+        if (v[k].lo <= v[last].hi+1) {
+            v[last].hi = imax(v[last].hi, v[k].hi);
+        } else {
+            v[++last] = v[k];
+        }
+    }
+    v.resize(last+1);
+    long long count = 0;
+    for (size_t k = 0; k < v.size(); k++) { count += v[k].hi-v[k].lo+1; }
+    return count;
+}
+
+// Calls f(lo,hi) for each interval of j values that is in the merged
+// intervals a but not in the merged intervals b.
+template <typename F>
+void forEachDifference(const std::vector<Interval>& a,
+                       const std::vector<Interval>& b, F f) {
+    size_t kb = 0;
+    for (size_t ka = 0; ka < a.size(); ka++) {
+        int lo = a[ka].lo;
+        while (kb < b.size() && b[kb].hi < lo) { kb++; }
+        size_t k = kb;
+        while (k < b.size() && b[k].lo <= a[ka].hi) {
+            if (b[k].lo > lo) { f(lo, b[k].lo-1); }
+            lo = imax(lo, b[k].hi+1);
+            k++;
+        }
+        if (lo <= a[ka].hi) { f(lo, a[ka].hi); }
+    }
+}
+
+// Per row intervals of what a tile reads and writes, indexed by
+// (slot, i) where the slot is either a buffer or a time step.
+class TileRows {
+  public:
+    // Finds the t and i extent of the tile.
+    template <typename Tiling>
+    TileRows(const Tiling& tiling, const TileCoord& tile)
+        : mTlo(1), mThi(0), mIlo(0), mIhi(-1)
+    {
+        bool first = true;
+        tiling.forEachRow(tile, [&](int t, int i, int, int) {
+            if (first) {
+                mTlo = mThi = t; mIlo = mIhi = i;
+                first = false;
+            }
+            mTlo = imin(mTlo,t); mThi = imax(mThi,t);
+            mIlo = imin(mIlo,i); mIhi = imax(mIhi,i);
+        });
+        // Reads reach one row further in each direction.
+        if (!first) { mIlo--; mIhi++; }
+    }
+
+    bool empty() const { return mThi < mTlo; }
+    int tlo() const { return mTlo; }
+    int thi() const { return mThi; }
+    int ilo() const { return mIlo; }
+    int ihi() const { return mIhi; }
+    int height() const { return mIhi-mIlo+1; }
+
+    // Calls f(t-1,i',lo,hi) for each row of values at time t-1 that
+    // the stencil reads to compute the row (t,i,j_lb..j_ub).
+    template <typename F>
+    static void forEachRead(int t, int i, int j_lb, int j_ub, F f) {
+        f(t-1, i-1, j_lb, j_ub);
+        f(t-1, i, j_lb-1, j_ub+1);
+        f(t-1, i+1, j_lb, j_ub);
+    }
+
+  private:
+    int mTlo, mThi, mIlo, mIhi;
+};
+
+// Calls f(t,i,j) once for each A(t,i,j) with t>=1 that is read by the
+// tile but computed by some other tile.
+template <typename Tiling, typename F>
+void forEachHaloPoint(const Tiling& tiling, const TileCoord& tile, F f) {
+    TileRows rows(tiling, tile);
+    if (rows.empty()) { return; }
+    // Slot 0 is time tlo-1.
+    int h = rows.height();
+    size_t num_slots = (size_t)(rows.thi()-rows.tlo()+2)*h;
+    std::vector< std::vector<Interval> > read(num_slots), written(num_slots);
+    tiling.forEachRow(tile, [&](int t, int i, int j_lb, int j_ub) {
+        Interval w = {j_lb, j_ub};
+        written[(size_t)(t-rows.tlo()+1)*h + (i-rows.ilo())].push_back(w);
+        TileRows::forEachRead(t, i, j_lb, j_ub,
+                              [&](int rt, int ri, int lo, int hi) {
+            Interval r = {lo, hi};
+            read[(size_t)(rt-rows.tlo()+1)*h + (ri-rows.ilo())].push_back(r);
+        });
+    });
+    for (size_t k = 0; k < num_slots; k++) {
+        int t = rows.tlo()-1 + (int)(k/h);
+        int i = rows.ilo() + (int)(k%h);
+        if (t < 1 || read[k].empty()) { continue; }
+        mergeIntervals(read[k]);
+        mergeIntervals(written[k]);
+        forEachDifference(read[k], written[k], [&](int lo, int hi) {
+            for (int j = lo; j <= hi; j++) { f(t, i, j); }
+        });
+    }
+}
+
+// Counts the values that forEachHaloPoint visits, but fast enough for
+// millions of tiles.  Rows arrive in (t,i) order with one interval per
+// row, so each row of the reads at time t-1 is the union of at most 3
+// intervals from the rows i-1, i, and i+1 at time t, minus the one row
+// i of the tile at time t-1.  Most tiles are translations of a few
+// full tile shapes, so halos are remembered per shape.
+class HaloCounter {
+  public:
+    HaloCounter() {}
+
+    template <typename Tiling>
+    long long count(const Tiling& tiling, const TileCoord& tile) {
+        // Rows relative to the first row, which are the same for tiles
+        // that are translations of each other.  The key only needs to
+        // be cheap since shapes are compared row by row.
+        mRows.clear();
+        unsigned long long hash = 0;
+        int t0 = 0, i0 = 0, j0 = 0;
+        tiling.forEachRow(tile, [&](int t, int i, int j_lb, int j_ub) {
+            if (mRows.empty()) { t0 = t; i0 = i; j0 = j_lb; }
+            Row row = {t, i, j_lb, j_ub};
+            mRows.push_back(row);
+            hash += (unsigned long long)((t-t0)*1031 + (i-i0)*131
+                                         + (j_lb-j0)*7 + (j_ub-j0))
+                    * 2654435761ULL;
+        });
+        if (mRows.empty()) { return 0; }
+        hash ^= mRows.size();
+
+        // Time 1 reads the initial values, which are not a halo, so
+        // tiles that include time 1 are not remembered.
+        bool memo = (t0 > 1);
+        if (memo) {
+            std::unordered_map<unsigned long long,size_t>::const_iterator
+                iter = mShapeIndex.find(hash);
+            if (iter != mShapeIndex.end()
+                && sameShape(mShapes[iter->second].rows, t0, i0, j0)) {
+                return mShapes[iter->second].halo;
+            }
+        }
+
+        long long halo = countRows();
+        if (memo && mShapes.size() < sMaxShapes
+            && mShapeIndex.find(hash) == mShapeIndex.end()) {
+            mShapeIndex[hash] = mShapes.size();
+            Shape shape;
+            shape.halo = halo;
+            for (size_t k = 0; k < mRows.size(); k++) {
+                Row rel = {mRows[k].t-t0, mRows[k].i-i0,
+                           mRows[k].lo-j0, mRows[k].hi-j0};
+                shape.rows.push_back(rel);
+            }
+            mShapes.push_back(shape);
+        }
+        return halo;
+    }
+
+  private:
+    struct Row {
+        int t, i, lo, hi;
+    };
+    struct Shape {
+        std::vector<Row> rows;
+        long long halo;
+    };
+
+    // Whether mRows relative to (t0,i0,j0) are the rows of the shape.
+    bool sameShape(const std::vector<Row>& shape, int t0, int i0,
+                   int j0) const {
+        if (shape.size() != mRows.size()) { return false; }
+        for (size_t k = 0; k < shape.size(); k++) {
+            if (mRows[k].t-t0 != shape[k].t || mRows[k].i-i0 != shape[k].i
+                || mRows[k].lo-j0 != shape[k].lo
+                || mRows[k].hi-j0 != shape[k].hi) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Halo of the rows mRows[cur..cur_end) at time t given the rows
+    // mRows[prev..prev_end) at time t-1.
+    long long countTimeStep(size_t cur, size_t cur_end,
+                            size_t prev, size_t prev_end) const {
+        long long count = 0;
+        size_t c = cur, p = prev;
+        for (int i = mRows[cur].i-1; i <= mRows[cur_end-1].i+1; i++) {
+            // Rows at i-1, i, and i+1.
+            while (c < cur_end && mRows[c].i < i-1) { c++; }
+            Interval reads[3];
+            int n = 0;
+            for (size_t k = c; k < cur_end && mRows[k].i <= i+1; k++) {
+                Interval r = {mRows[k].lo, mRows[k].hi};
+                if (mRows[k].i == i) { r.lo--; r.hi++; }
+                reads[n++] = r;
+            }
+            if (n == 0) { continue; }
+            for (int k = 1; k < n; k++) {
+                for (int m = k; m > 0 && reads[m].lo < reads[m-1].lo; m--) {
+                    std::swap(reads[m], reads[m-1]);
+                }
+            }
+            while (p < prev_end && mRows[p].i < i) { p++; }
+            bool has_prev = (p < prev_end && mRows[p].i == i);
+            // Merge the reads and take out the row of the tile at t-1.
+            int lo = reads[0].lo, hi = reads[0].hi;
+            for (int k = 1; k <= n; k++) {
+                if (k < n && reads[k].lo <= hi+1) {
+                    hi = imax(hi, reads[k].hi);
+                    continue;
+                }
+                count += hi-lo+1;
+                if (has_prev) {
+                    int overlap = imin(hi, mRows[p].hi)
+                                - imax(lo, mRows[p].lo) + 1;
+                    if (overlap > 0) { count -= overlap; }
+                }
+                if (k < n) { lo = reads[k].lo; hi = reads[k].hi; }
+            }
+        }
+        return count;
+    }
+
+    long long countRows() const {
+        long long count = 0;
+        size_t prev = 0, prev_end = 0;
+        size_t cur = 0;
+        while (cur < mRows.size()) {
+            size_t cur_end = cur;
+            while (cur_end < mRows.size() && mRows[cur_end].t == mRows[cur].t) {
+                cur_end++;
+            }
+            if (mRows[cur].t > 1) {
+                bool adjacent = (prev_end > prev
+                                 && mRows[prev].t == mRows[cur].t-1);
+                count += countTimeStep(cur, cur_end, adjacent ? prev : cur,
+                                       adjacent ? prev_end : cur);
+            }
+            prev = cur;
+            prev_end = cur_end;
+            cur = cur_end;
+        }
+        return count;
+    }
+
+    static const size_t sMaxShapes = 4096;
+    std::vector<Row> mRows;
+    std::vector<Shape> mShapes;
+    std::unordered_map<unsigned long long,size_t> mShapeIndex;
+};
+
+template <typename Tiling>
+Footprint tileFootprint(const Tiling& tiling, const TileCoord& tile,
+                        int num_buffers, int elem_size) {
+    Footprint fp = {0, 0, 0, 0, 0};
+    TileRows rows(tiling, tile);
+    if (rows.empty()) { return fp; }
+
+    // Intervals per (buffer,i) for the footprint and per (t,i) for the
+    // halo, where time slot 0 is tlo-1.
+    int h = rows.height();
+    size_t num_bufs = (size_t)num_buffers*h;
+    size_t num_times = (size_t)(rows.thi()-rows.tlo()+2)*h;
+    std::vector< std::vector<Interval> > buf_read(num_bufs);
+    std::vector< std::vector<Interval> > buf_written(num_bufs);
+    std::vector< std::vector<Interval> > read(num_times), written(num_times);
+    tiling.forEachRow(tile, [&](int t, int i, int j_lb, int j_ub) {
+        fp.points += j_ub-j_lb+1;
+        Interval w = {j_lb, j_ub};
+        buf_written[(size_t)(t % num_buffers)*h + (i-rows.ilo())].push_back(w);
+        written[(size_t)(t-rows.tlo()+1)*h + (i-rows.ilo())].push_back(w);
+        TileRows::forEachRead(t, i, j_lb, j_ub,
+                              [&](int rt, int ri, int lo, int hi) {
+            Interval r = {lo, hi};
+            size_t row = ri-rows.ilo();
+            buf_read[(size_t)(rt % num_buffers)*h + row].push_back(r);
+            read[(size_t)(rt-rows.tlo()+1)*h + row].push_back(r);
+        });
+    });
+
+    for (size_t k = 0; k < num_bufs; k++) {
+        fp.readBytes += mergeIntervals(buf_read[k])*elem_size;
+        fp.writeBytes += mergeIntervals(buf_written[k])*elem_size;
+        std::vector<Interval> both(buf_read[k]);
+        both.insert(both.end(), buf_written[k].begin(), buf_written[k].end());
+        fp.totalBytes += mergeIntervals(both)*elem_size;
+    }
+    for (size_t k = 0; k < num_times; k++) {
+        int t = rows.tlo()-1 + (int)(k/h);
+        if (t < 1 || read[k].empty()) { continue; }
+        mergeIntervals(read[k]);
+        mergeIntervals(written[k]);
+        forEachDifference(read[k], written[k], [&](int lo, int hi) {
+            fp.haloBytes += (long long)(hi-lo+1)*elem_size;
+        });
+    }
+    return fp;
+}
+
+// Finds the last tile with the most points, which for a tiling over a big
+// enough domain is a full interior tile.
+template <typename Tiling>
+TileCoord largestTile(const Tiling& tiling) {
+    TileCoord best = {0, 0, 0};
+    long long best_points = -1;
+    for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront(); w++) {
+        tiling.forEachTile(w, [&](const TileCoord& tile) {
+            long long points = tiling.numPoints(tile);
+            if (points >= best_points) {
+                best_points = points;
+                best = tile;
+            }
+        });
+    }
+    return best;
+}
+
+#endif
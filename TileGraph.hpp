@@ -0,0 +1,89 @@
+/*!
+ * \file TileGraph.hpp
+ *
+ * \brief Tile level dependence graph for any tiling in Tiling.hpp.
+ *
+ * Tiles are numbered in schedule order (wavefront by wavefront).
+ * Predecessor and successor lists are stored in compressed sparse
+ * row form: the predecessors of tile k are
+ * pred[predStart[k]] through pred[predStart[k+1]-1].
+ */
+#ifndef TILEGRAPH_HPP_
+#define TILEGRAPH_HPP_
+
+#include "Tiling.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+class TileGraph {
+  public:
+    template <typename Tiling>
+    TileGraph(const Tiling& tiling) {
+        // Number the tiles in schedule order in a single pass.  The
+        // predecessors of a tile are in earlier wavefronts, so they
+        // already have numbers.
+        std::unordered_map<long long,int> index;
+        mPredStart.push_back(0);
+        for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront();
+             w++) {
+            tiling.forEachTile(w, [&](const TileCoord& tile) {
+                tiling.forEachPredecessor(tile,
+                    [&](const TileCoord& pred) {
+                        std::unordered_map<long long,int>::const_iterator
+                            iter = index.find(key(pred));
+                        if (iter != index.end()) {
+                            mPred.push_back(iter->second);
+                        }
+                    });
+                mPredStart.push_back((int)mPred.size());
+                index[key(tile)] = (int)mTiles.size();
+                mTiles.push_back(tile);
+                mWavefront.push_back(w);
+            });
+        }
+        int num_tiles = numTiles();
+
+        // Successors are the transpose of predecessors.
+        mSuccStart.assign(num_tiles+1, 0);
+        for (size_t e = 0; e < mPred.size(); e++) {
+            mSuccStart[mPred[e]+1]++;
+        }
+        for (int k = 0; k < num_tiles; k++) {
+            mSuccStart[k+1] += mSuccStart[k];
+        }
+        mSucc.resize(mPred.size());
+        std::vector<int> next(mSuccStart.begin(), mSuccStart.end()-1);
+        for (int k = 0; k < num_tiles; k++) {
+            for (int e = mPredStart[k]; e < mPredStart[k+1]; e++) {
+                mSucc[next[mPred[e]]++] = k;
+            }
+        }
+    }
+
+    int numTiles() const { return (int)mTiles.size(); }
+    int numEdges() const { return (int)mPred.size(); }
+    const TileCoord& tile(int k) const { return mTiles[k]; }
+    int wavefront(int k) const { return mWavefront[k]; }
+
+    int numPreds(int k) const { return mPredStart[k+1]-mPredStart[k]; }
+    const int* preds(int k) const { return mPred.data() + mPredStart[k]; }
+    int numSuccs(int k) const { return mSuccStart[k+1]-mSuccStart[k]; }
+    const int* succs(int k) const { return mSucc.data() + mSuccStart[k]; }
+
+  private:
+    static long long key(const TileCoord& tile) {
+        const long long bias = 1<<20;
+        return ((tile.c0+bias)<<42) | ((tile.c1+bias)<<21) | (tile.c2+bias);
+    }
+
+    std::vector<TileCoord> mTiles;
+    std::vector<int> mWavefront;
+    std::vector<int> mPredStart;
+    std::vector<int> mPred;
+    std::vector<int> mSuccStart;
+    std::vector<int> mSucc;
+};
+
+#endif
@@ -0,0 +1,95 @@
+/*!
+ * \file TileScheduler.cpp
+ *
+ * \brief Implements TileScheduler.
+ */
+#include "TileScheduler.hpp"
+
+#include <thread>
+#include <vector>
+
+TileScheduler::TileScheduler(const TileGraph& graph, int num_workers)
+    : mGraph(graph), mNumWorkers(num_workers < 1 ? 1 : num_workers),
+      mWorkers(new Worker[mNumWorkers]),
+      mCounters(new std::atomic<int>[graph.numTiles()]),
+      mRemaining(0), mSteals(0), mNumSteals(0)
+{
+}
+
+void TileScheduler::run(const std::function<void(int,int)>& body) {
+    // Reset the dependence counters and hand out the tiles without
+    // predecessors round robin.
+    int num_tiles = mGraph.numTiles();
+    int next_worker = 0;
+    for (int k = 0; k < num_tiles; k++) {
+        mCounters[k].store(mGraph.numPreds(k), std::memory_order_relaxed);
+        if (mGraph.numPreds(k) == 0) {
+            mWorkers[next_worker].ready.push_back(k);
+            next_worker = (next_worker+1) % mNumWorkers;
+        }
+    }
+    mRemaining.store(num_tiles);
+    mSteals.store(0);
+
+    // The calling thread is worker 0.
+    std::vector<std::thread> threads;
+    for (int w = 1; w < mNumWorkers; w++) {
+        threads.push_back(std::thread(&TileScheduler::workerLoop, this, w,
+                                      std::cref(body)));
+    }
+    workerLoop(0, body);
+    for (size_t w = 0; w < threads.size(); w++) {
+        threads[w].join();
+    }
+    mNumSteals = mSteals.load();
+}
+
+void TileScheduler::workerLoop(int w,
+                               const std::function<void(int,int)>& body) {
+    while (mRemaining.load(std::memory_order_acquire) > 0) {
+        int k;
+        if (!pop(w,k) && !steal(w,k)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        body(k, w);
+
+        // Release the successors whose last predecessor was k.
+        const int* succs = mGraph.succs(k);
+        for (int e = 0; e < mGraph.numSuccs(k); e++) {
+            if (mCounters[succs[e]].fetch_sub(1,
+                    std::memory_order_acq_rel) == 1) {
+                push(w, succs[e]);
+            }
+        }
+        mRemaining.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void TileScheduler::push(int w, int k) {
+    std::lock_guard<std::mutex> guard(mWorkers[w].lock);
+    mWorkers[w].ready.push_back(k);
+}
+
+bool TileScheduler::pop(int w, int& k) {
+    std::lock_guard<std::mutex> guard(mWorkers[w].lock);
+    if (mWorkers[w].ready.empty()) { return false; }
+    k = mWorkers[w].ready.back();
+    mWorkers[w].ready.pop_back();
+    return true;
+}
+
+bool TileScheduler::steal(int w, int& k) {
+    for (int v = 1; v < mNumWorkers; v++) {
+        Worker& victim = mWorkers[(w+v) % mNumWorkers];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.ready.empty()) {
+            k = victim.ready.front();
+            victim.ready.pop_front();
+            mSteals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,55 @@
+/*!
+ * \file TileScheduler.hpp
+ *
+ * \brief Dependence driven work-stealing scheduler for a TileGraph.
+ *
+ * Instead of a barrier between tile wavefronts, every tile has a
+ * counter of unfinished predecessors.  When a worker finishes a tile
+ * it decrements the counters of the successors and pushes the ones
+ * that reach zero onto its own deque.  Workers pop their own deque
+ * from the back and steal from the front of the others when idle.
+ */
+#ifndef TILESCHEDULER_HPP_
+#define TILESCHEDULER_HPP_
+
+#include "TileGraph.hpp"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+class TileScheduler {
+  public:
+    TileScheduler(const TileGraph& graph, int num_workers);
+
+    // Calls body(k,worker) for each tile k in the graph once all of the
+    // predecessors of k have finished.  Returns when all tiles are done.
+    void run(const std::function<void(int,int)>& body);
+
+    int numWorkers() const { return mNumWorkers; }
+    // Number of tiles taken from another worker's deque in the last run.
+    long long numSteals() const { return mNumSteals; }
+
+  private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<int> ready;
+    };
+
+    void workerLoop(int w, const std::function<void(int,int)>& body);
+    void push(int w, int k);
+    bool pop(int w, int& k);
+    bool steal(int w, int& k);
+
+    const TileGraph& mGraph;
+    int mNumWorkers;
+    std::unique_ptr<Worker[]> mWorkers;
+    std::unique_ptr<std::atomic<int>[]> mCounters;
+    std::atomic<int> mRemaining;
+    std::atomic<long long> mSteals;
+    long long mNumSteals;
+};
+
+#endif
@@ -0,0 +1,132 @@
+/*!
+ * \file TileSpace.hpp
+ *
+ * \brief Exact tile space of a tiling, with the empty tiles removed.
+ *
+ * The forEachTile bounds of the tilings are bounding boxes like the
+ * hoisted c1_lb/c1_ub and c2_lb_min_expr/c2_ub_max_expr bounds in
+ * tile-space-viz.cpp, so they also enumerate tiles without points.
+ * For diamond_prizms most of the tiles are empty.  TileSpace walks the
+ * loose bounds once, keeps only the tiles for which numPoints is not
+ * zero, and stores them as rows: for each (c0,c1) the runs of
+ * consecutive c2 that have points.
+ *
+ * The tiles are also numbered with one flat index in schedule order,
+ * where wavefront w is wavefrontBegin(w) <= k < wavefrontEnd(w).  So
+ * a wavefront is one loop that OpenMP can split with schedule(static)
+ * without handing out empty tiles, see Jacobi2D::runStatic.
+ *
+ * A TileSpace provides the interface in Tiling.hpp and can be used in
+ * place of the tiling it was built from.
+ */
+#ifndef TILESPACE_HPP_
+#define TILESPACE_HPP_
+
+#include "Tiling.hpp"
+
+#include <vector>
+#include <algorithm>
+
+// Tiles (c0,c1,c2lo) to (c0,c1,c2hi), which all have points.
+struct TileRow {
+    int c0, c1, c2lo, c2hi;
+};
+
+template <typename Tiling>
+class TileSpace {
+  public:
+    explicit TileSpace(const Tiling& tiling)
+        : mTiling(tiling), mEnumerated(0) {
+        int first = tiling.firstWavefront(), last = tiling.lastWavefront();
+        mRowStart.reserve(last-first+2);
+        mTileStart.push_back(0);
+        for (int w = first; w <= last; w++) {
+            mRowStart.push_back((int)mRows.size());
+            // Tiles continue the last row if they are the next c2 of it.
+            int begin = (int)mRows.size();
+            tiling.forEachTile(w, [&](const TileCoord& tile) {
+                mEnumerated++;
+                if (tiling.numPoints(tile) == 0) { return; }
+                if ((int)mRows.size() > begin) {
+                    TileRow& row = mRows.back();
+                    if (row.c0 == tile.c0 && row.c1 == tile.c1
+                            && row.c2hi+1 == tile.c2) {
+                        row.c2hi++;
+                        mTileStart.back()++;
+                        return;
+                    }
+                }
+                TileRow row = {tile.c0, tile.c1, tile.c2, tile.c2};
+                mRows.push_back(row);
+                mTileStart.push_back(mTileStart.back()+1);
+            });
+        }
+        mRowStart.push_back((int)mRows.size());
+    }
+
+    int firstWavefront() const { return mTiling.firstWavefront(); }
+    int lastWavefront() const { return mTiling.lastWavefront(); }
+
+    // Same tiles and order as the tiling, without the empty ones.
+    template <typename F>
+    void forEachTile(int w, F f) const {
+        int w0 = w-firstWavefront();
+        for (int r = mRowStart[w0]; r < mRowStart[w0+1]; r++) {
+            const TileRow& row = mRows[r];
+            for (int c2 = row.c2lo; c2 <= row.c2hi; c2++) {
+                TileCoord tile = {row.c0, row.c1, c2};
+                f(tile);
+            }
+        }
+    }
+
+    template <typename F>
+    void forEachRow(const TileCoord& tile, F f) const {
+        mTiling.forEachRow(tile, f);
+    }
+
+    template <typename F>
+    void forEachPredecessor(const TileCoord& tile, F f) const {
+        mTiling.forEachPredecessor(tile, f);
+    }
+
+    long long numPoints(const TileCoord& tile) const {
+        return mTiling.numPoints(tile);
+    }
+
+    // Flat index of the tiles, in schedule order.
+    int numTiles() const { return mTileStart.back(); }
+    int wavefrontBegin(int w) const {
+        return mTileStart[mRowStart[w-firstWavefront()]];
+    }
+    int wavefrontEnd(int w) const {
+        return mTileStart[mRowStart[w-firstWavefront()+1]];
+    }
+    // Tile with flat index k, found by binary search over the rows.
+    TileCoord tile(int k) const {
+        int r = (int)(std::upper_bound(mTileStart.begin(), mTileStart.end(),
+                                       k) - mTileStart.begin()) - 1;
+        const TileRow& row = mRows[r];
+        TileCoord tile = {row.c0, row.c1, row.c2lo + (k-mTileStart[r])};
+        return tile;
+    }
+
+    const std::vector<TileRow>& rows() const { return mRows; }
+    // Tiles the loose bounds of the tiling enumerate, including empty.
+    long long numEnumerated() const { return mEnumerated; }
+    long long numEmpty() const { return mEnumerated-numTiles(); }
+    double emptyRatio() const {
+        return (mEnumerated > 0) ? (double)numEmpty()/mEnumerated : 0.0;
+    }
+
+    const Tiling& tiling() const { return mTiling; }
+
+  private:
+    Tiling mTiling;
+    long long mEnumerated;
+    std::vector<TileRow> mRows;
+    std::vector<int> mRowStart;     // first row of each wavefront
+    std::vector<int> mTileStart;    // flat index of the first tile of a row
+};
+
+#endif
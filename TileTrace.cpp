@@ -0,0 +1,137 @@
+/*!
+ * \file TileTrace.cpp
+ *
+ * \brief Writes the Chrome trace-event JSON of TileTrace.
+ *
+ * Trace-event timestamps are in microseconds, the nanoseconds are kept
+ * as fractions.  Metadata events name the process and each worker.
+ * The reader only handles the layout the writer uses, with the fields
+ * of an event on one line, and is not a general JSON parser.
+ */
+#include "TileTrace.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+
+TileTrace::TileTrace(int num_workers, size_t tiles_per_worker)
+    : mBuffers(num_workers) {
+    for (int w = 0; w < num_workers; w++) {
+        mBuffers[w].events.reserve(tiles_per_worker);
+    }
+    clear();
+}
+
+void TileTrace::clear() {
+    for (size_t w = 0; w < mBuffers.size(); w++) {
+        mBuffers[w].events.clear();
+    }
+    mStart = std::chrono::steady_clock::now();
+    mStartTicks = ticks();
+}
+
+long long TileTrace::numEvents() const {
+    long long n = 0;
+    for (size_t w = 0; w < mBuffers.size(); w++) {
+        n += mBuffers[w].events.size();
+    }
+    return n;
+}
+
+bool TileTrace::writeChromeJSON(const std::string& filename,
+                                const std::string& name) const {
+    double ns = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - mStart).count();
+    double elapsed = (double)(ticks() - mStartTicks);
+    double us_per_tick = (elapsed > 0.0) ? ns/elapsed/1000.0 : 0.0;
+
+    std::ofstream out(filename.c_str());
+    if (!out) { return false; }
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [" << std::endl;
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, "
+        << "\"tid\": 0, \"args\": {\"name\": \"" << name << "\"}}";
+    for (size_t w = 0; w < mBuffers.size(); w++) {
+        out << "," << std::endl
+            << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+            << "\"tid\": " << w << ", \"args\": {\"name\": \"worker " << w
+            << "\"}}";
+    }
+    char line[512];
+    for (size_t w = 0; w < mBuffers.size(); w++) {
+        const std::vector<TileEvent>& events = mBuffers[w].events;
+        for (size_t k = 0; k < events.size(); k++) {
+            const TileEvent& e = events[k];
+            snprintf(line, sizeof(line),
+                     ",\n{\"name\": \"tile (%d,%d,%d)\", \"cat\": \"tile\", "
+                     "\"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                     "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"kt\": %d, "
+                     "\"k1\": %d, \"k2\": %d, \"toff\": %d, "
+                     "\"points\": %lld}}",
+                     e.tile.c0, e.tile.c1, e.tile.c2, (int)w,
+                     e.begin*us_per_tick, (e.end-e.begin)*us_per_tick,
+                     e.tile.c0, e.tile.c1, e.tile.c2, e.toff, e.points);
+            out << line;
+        }
+    }
+    out << std::endl << "]}" << std::endl;
+    return (bool)out;
+}
+
+// Finds "key": in line and reads the number after it.
+static bool findNumber(const std::string& line, const char* key,
+                       double& value) {
+    std::string quoted = std::string("\"") + key + "\": ";
+    size_t pos = line.find(quoted);
+    if (pos == std::string::npos) { return false; }
+    const char* start = line.c_str() + pos + quoted.size();
+    char* end = NULL;
+    value = strtod(start, &end);
+    return end != start;
+}
+
+bool readTileTrace(const std::string& filename, std::string& name,
+                   std::vector<TracedTile>& tiles, std::string& error) {
+    std::ifstream in(filename.c_str());
+    if (!in) {
+        error = "can not open " + filename;
+        return false;
+    }
+    name.clear();
+    tiles.clear();
+    std::string line;
+    int line_num = 0;
+    while (std::getline(in, line)) {
+        line_num++;
+        if (line.find("\"process_name\"") != std::string::npos) {
+            std::string key = "\"args\": {\"name\": \"";
+            size_t pos = line.find(key);
+            if (pos != std::string::npos) {
+                pos += key.size();
+                name = line.substr(pos, line.find('"', pos) - pos);
+            }
+            continue;
+        }
+        if (line.find("\"ph\": \"X\"") == std::string::npos) { continue; }
+        double tid, ts, dur, kt, k1, k2, toff, points;
+        if (!findNumber(line, "tid", tid) || !findNumber(line, "ts", ts)
+                || !findNumber(line, "dur", dur)
+                || !findNumber(line, "kt", kt) || !findNumber(line, "k1", k1)
+                || !findNumber(line, "k2", k2)
+                || !findNumber(line, "toff", toff)
+                || !findNumber(line, "points", points)) {
+            std::ostringstream ss;
+            ss << filename << ":" << line_num << ": not a tile event";
+            error = ss.str();
+            return false;
+        }
+        TracedTile t = {{(int)kt, (int)k1, (int)k2}, (int)toff, (int)tid,
+                        ts, dur, (long long)points};
+        tiles.push_back(t);
+    }
+    if (tiles.empty()) {
+        error = filename + " has no tile events";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,118 @@
+/*!
+ * \file TileTrace.hpp
+ *
+ * \brief Timeline of the tiles an executor runs, written as Chrome
+ *        trace-event JSON.
+ *
+ * Each worker appends the begin and end time of the tiles it runs to its
+ * own buffer, so recording takes no lock and no atomic, and the buffers
+ * are padded so workers do not share cache lines.  The buffers are only
+ * read after the run, when the workers are done.  Times are taken from
+ * the time stamp counter where there is one, which is about twice as
+ * fast to read as steady_clock, and are converted to nanoseconds with
+ * the rate measured between clear() and the write.
+ *
+ * writeChromeJSON() writes one complete ("X") event per tile with the
+ * worker as the thread, and the tile coordinates (kt,k1,k2), the first
+ * time step of its slab, and its points as args.  The file loads in
+ * about:tracing and in Perfetto.  Every event is on its own line so
+ * that readTileTrace() can read it back a line at a time, such as for
+ * the trace heatmap of slice-viz.
+ */
+#ifndef TILETRACE_HPP_
+#define TILETRACE_HPP_
+
+#include "Tiling.hpp"
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+struct TileEvent {
+    TileCoord tile;
+    int toff;               // first time step of the slab
+    long long points;
+    int64_t begin, end;     // ticks since the trace was cleared
+};
+
+class TileTrace {
+  public:
+    // Reserves room for tiles_per_worker events in each buffer.
+    TileTrace(int num_workers, size_t tiles_per_worker);
+
+    int numWorkers() const { return (int)mBuffers.size(); }
+
+    // Forgets the events and restarts the clock.
+    void clear();
+
+    // Ticks since clear().
+    int64_t now() const { return (int64_t)(ticks() - mStartTicks); }
+
+    // Only called by the worker itself.  The points are set afterwards
+    // by countPoints().
+    void record(int worker, const TileCoord& tile, int toff,
+                int64_t begin, int64_t end) {
+        TileEvent event = {tile, toff, 0, begin, end};
+        mBuffers[worker].events.push_back(event);
+    }
+
+    // Sets the points of the events of the slab starting at toff from
+    // tiling.numPoints.  Done after the run, where it is not timed.
+    template <typename Tiling>
+    void countPoints(const Tiling& tiling, int toff) {
+        for (Buffer& buffer : mBuffers) {
+            for (TileEvent& event : buffer.events) {
+                if (event.toff == toff) {
+                    event.points = tiling.numPoints(event.tile);
+                }
+            }
+        }
+    }
+
+    const std::vector<TileEvent>& events(int worker) const {
+        return mBuffers[worker].events;
+    }
+    long long numEvents() const;
+
+    // Returns false if the file can not be written.
+    bool writeChromeJSON(const std::string& filename,
+                         const std::string& name) const;
+
+  private:
+    static uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    struct alignas(64) Buffer {
+        std::vector<TileEvent> events;
+    };
+
+    std::vector<Buffer> mBuffers;
+    std::chrono::steady_clock::time_point mStart;
+    uint64_t mStartTicks;
+};
+
+// One tile event read back from a trace, with times in microseconds.
+struct TracedTile {
+    TileCoord tile;
+    int toff;
+    int worker;
+    double start, duration;
+    long long points;
+};
+
+// Reads the tile events of a file written by writeChromeJSON, and the
+// name it was given.  Returns false with the reason in error.
+bool readTileTrace(const std::string& filename, std::string& name,
+                   std::vector<TracedTile>& tiles, std::string& error);
+
+#endif
@@ -0,0 +1,173 @@
+/*!
+ * \file Tiling.hpp
+ *
+ * \brief Pieces shared by the runtime tiling traversals.
+ *
+ * A runtime tiling enumerates the same schedule as the generated .is
+ * files and the calc_diamond loops in slice-viz.cpp, but as an object
+ * that both the visualization drivers and the Jacobi2D engine can use.
+ * Every tiling class provides the following interface:
+ *
+ *      int firstWavefront() const;
+ *      int lastWavefront() const;
+ *
+ *      // Calls f(const TileCoord&) for each tile in wavefront w.
+ *      // Tiles within one wavefront can be executed in parallel.
+ *      template <typename F> void forEachTile(int w, F f) const;
+ *
+ *      // Calls f(t,i,jlo,jhi) for each (t,i) row of the tile in
+ *      // lexicographic order.  The row covers jlo<=j<=jhi.
+ *      template <typename F> void forEachRow(const TileCoord&, F f) const;
+ *
+ *      // Calls f(const TileCoord&) for each tile that may hold a
+ *      // stencil predecessor of a point in the given tile.  The
+ *      // neighbors need not be non-empty or even enumerated, but
+ *      // must be in earlier wavefronts.
+ *      template <typename F>
+ *      void forEachPredecessor(const TileCoord&, F f) const;
+ *
+ *      // Number of iteration points in the tile, without visiting
+ *      // them.  Takes the same time for any tile size.
+ *      long long numPoints(const TileCoord&) const;
+ *
+ * Time steps within a tiling start at 1, the spatial bounds are
+ * inclusive.
+ */
+#ifndef TILING_HPP_
+#define TILING_HPP_
+
+#include <algorithm>
+#include <cassert>
+
+// Changes whenever a change to the tilings or the generated .is files
+// changes a traversal, so that renders cached on disk by an older
+// version are not reused, see RenderCache.hpp.
+#define TILING_ENGINE_VERSION 1
+
+// Tile coordinates.  For diamonds these are (kt,k1,k2).
+struct TileCoord {
+    int c0;
+    int c1;
+    int c2;
+};
+
+// Versions of floord, ceild, min, and max from intops.h that are
+// functions so they can be used in headers without the macros.
+static inline int floorDiv(int n, int d) {
+    int q = n/d;
+    return (n%d<0) ? q-1 : q;
+}
+
+static inline int ceilDiv(int n, int d) {
+    return -floorDiv(-n,d);
+}
+
+static inline int imin(int a, int b) { return (a<b) ? a : b; }
+static inline int imax(int a, int b) { return (a>b) ? a : b; }
+
+// Sum of max(0, c+s*i) for lo<=i<=hi where the slope s is -1, 0, or 1.
+static inline long long sumPositiveLinear(long long lo, long long hi,
+                                          long long c, int s) {
+    if (s > 0 && lo < 1-c) { lo = 1-c; }
+    if (s < 0 && hi > c-1) { hi = c-1; }
+    if (hi < lo) { return 0; }
+    long long n = hi-lo+1;
+    if (s == 0) { return (c > 0) ? n*c : 0; }
+    return n*c + s*((lo+hi)*n/2);
+}
+
+// The linear function a*t+b of the time step t.
+struct LinearT {
+    int a;
+    int b;
+};
+
+// Counts of points per time step in a tile are built from mins, maxes,
+// and comparisons of linear functions of t, so they are a quadratic
+// polynomial in t between the time steps where two of those functions
+// cross.  TimeBreaks collects those time steps and then sums the count
+// with 3 evaluations per piece, which is the same piecewise
+// quasi-polynomial barvinok would give (see bound-computations.iscc).
+class TimeBreaks {
+  public:
+    TimeBreaks() : mNum(0) {}
+
+    // The order of x and y can only change at the steps added here.
+    // Steps on either side cover comparisons that are offset by one.
+    void addCrossing(const LinearT& x, const LinearT& y) {
+        int da = x.a - y.a;
+        if (da == 0) { return; }
+        if (da < 0) { addCrossing(y, x); return; }
+        int cross = floorDiv(y.b - x.b, da);
+        for (int d = -1; d <= 2; d++) {
+            assert(mNum < sMaxBreaks);
+            mStarts[mNum++] = cross+d;
+        }
+    }
+
+    // Adds the crossings of every pair of the n functions.
+    void addAllPairs(const LinearT* funcs, int n) {
+        for (int x = 0; x < n; x++) {
+            for (int y = x+1; y < n; y++) {
+                addCrossing(funcs[x], funcs[y]);
+            }
+        }
+    }
+
+    // Returns the sum of count(t) for lo<=t<=hi.
+    template <typename F>
+    long long sum(int lo, int hi, F count) {
+        if (hi < lo) { return 0; }
+        // Short ranges are cheaper to sum directly than to sort.
+        if (hi-lo < mNum) {
+            long long total = 0;
+            for (int t = lo; t <= hi; t++) { total += count(t); }
+            return total;
+        }
+        assert(mNum < sMaxBreaks);
+        mStarts[mNum++] = lo;
+        std::sort(mStarts, mStarts+mNum);
+        long long total = 0;
+        int k = 0;
+        while (k < mNum) {
+            int start = mStarts[k];
+            while (k < mNum && mStarts[k] == start) { k++; }
+            if (start < lo) { continue; }
+            if (start > hi) { break; }
+            int end = (k < mNum && mStarts[k] <= hi) ? mStarts[k]-1 : hi;
+            long long n = end-start+1;
+            long long p0 = count(start);
+            if (n == 1) { total += p0; continue; }
+            long long p1 = count(start+1);
+            if (n == 2) { total += p0+p1; continue; }
+            // Newton's forward differences of the quadratic.
+            long long p2 = count(start+2);
+            long long d1 = p1-p0, d2 = p2-2*p1+p0;
+            total += n*p0 + n*(n-1)/2*d1 + n*(n-1)*(n-2)/6*d2;
+        }
+        return total;
+    }
+
+  private:
+    static const int sMaxBreaks = 512;
+    int mStarts[sMaxBreaks];
+    int mNum;
+};
+
+// Visits every iteration point of the tiling in schedule order:
+// wavefronts, then tiles within a wavefront, then t, i, j within a tile.
+// Calls f(tile,t,i,j).
+template <typename Tiling, typename F>
+void forEachPoint(const Tiling& tiling, F f) {
+    for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront(); w++) {
+        tiling.forEachTile(w, [&](const TileCoord& tile) {
+            tiling.forEachRow(tile, [&](int t, int i, int jlo, int jhi) {
+                for (int j = jlo; j <= jhi; j++) {
+                    f(tile, t, i, j);
+                }
+            });
+        });
+    }
+}
+
+#endif
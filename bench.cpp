@@ -0,0 +1,575 @@
+/*!
+ * \file bench.cpp
+ *
+ * \brief Benchmarks of the traversals, coloring, and emission that the
+ *        slice-viz drivers are built from.
+ *
+ * Each case is timed over a grid of (N, T, tau).  A case is run warmup
+ * times untimed and then reps times timed, and one CSV row with the
+ * median, 95th percentile, minimum, and mean time of the reps is
+ * appended to the output file per case and grid point.  The label
+ * column tells the runs apart, "make bench" labels them with the git
+ * commit so that the file tracks performance per commit.
+ *
+ * The hardware counters in HwCounters.hpp are read around each timed
+ * rep and reported per item, summed over the reps.  Where they can not
+ * be opened the counters column is "timer" and their columns are empty.
+ *
+ * The cases are
+ *   traverse_<tiling>  forEachPoint of the runtime tilings and
+ *                      forEachIsPoint of the generated .is traversals,
+ *                      the .is traversals have a fixed tile size and
+ *                      are only run for the first tau
+ *   record             recordPoints of SliceRender.hpp, the diamonds
+ *                      points in traversal order as slice-viz records
+ *                      them
+ *   intops_floord      floord and ceild of intops.h
+ *   color_tiles        TileColorer over the recorded diamonds
+ *   colorinfo_lookup   ColorInfo::lookup of the tile colors
+ *   cellfield_set_get  CellFieldArray setFill and getFill of every point
+ *   emit_svg           CellFieldArray::printToSVG of the colored slices
+ *   emit_pov           PrinterPOV::printCircle of every point
+ *   render_svg         recordPoints and renderSVG of SliceRender.hpp
+ *                      for diamonds, which is what slice-viz does for
+ *                      one svg when nothing is cached, leaving out its
+ *                      parsing, file output, and --stats timers
+ *
+ * The Makefile builds it with the -O0 flags of slice-viz and
+ * diamond-slice-viz, so the times are those of the drivers as built.
+ *
+ * To see how to run, type "./slice-viz-bench --help".
+ */
+#include "DiamondTiling.hpp"
+#include "PrismTiling.hpp"
+#include "PipelinedTiling.hpp"
+#include "IsTraversal.hpp"
+#include "TileColorer.hpp"
+#include "SliceRender.hpp"
+#include "ColorInfo.hpp"
+#include "CellFieldArray.hpp"
+#include "svgprinter.hpp"
+#include "PrinterPOV.hpp"
+#include "HwCounters.hpp"
+#include "CmdParams.h"
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+#include "eassert.h"
+#include "intops.h"
+
+//==============================================
+// Global parameters with their default values.
+char sizesN[MAXPOSSVALSTRING];
+char sizesT[MAXPOSSVALSTRING];
+char sizesTau[MAXPOSSVALSTRING];
+int warmup = 2;
+int reps = 10;
+char label[MAXPOSSVALSTRING];
+char outputFile[MAXPOSSVALSTRING];
+char caseFilter[MAXPOSSVALSTRING];
+
+//==============================================
+
+void initParams(CmdParams * cmdparams)
+/*--------------------------------------------------------------*//*!
+  Uses a CmdParams object to describe all of the command line
+  parameters.
+*//*--------------------------------------------------------------*/
+{
+    CmdParams_describeStringParam(cmdparams,"N", 'N', 1,
+            "comma separated spatial sizes, the grid is NxN",
+            "16,32,64");
+
+    CmdParams_describeStringParam(cmdparams,"T", 'T', 1,
+            "comma separated numbers of time steps",
+            "4,8");
+
+    CmdParams_describeStringParam(cmdparams,"tau", 'a', 1,
+            "comma separated tile sizes, used as tau, sigma, and gamma",
+            "6,12");
+
+    CmdParams_describeNumParam(cmdparams,"warmup", 'w', 1,
+            "untimed runs of each case before the timed ones",
+            0, 1000, 2);
+
+    CmdParams_describeNumParam(cmdparams,"reps", 'r', 1,
+            "timed runs of each case",
+            1, 100000, 10);
+
+    CmdParams_describeStringParam(cmdparams,"label", 'l', 1,
+            "first column of the rows, such as the git commit",
+            "none");
+
+    CmdParams_describeStringParam(cmdparams,"output", 'o', 1,
+            "CSV file the rows are appended to, - for stdout",
+            "-");
+
+    CmdParams_describeStringParam(cmdparams,"cases", 'c', 1,
+            "only run the cases whose name contains this, all for all",
+            "all");
+}
+
+// Parses a comma separated list of positive ints, or returns false.
+bool parseSizes(const char* str, std::vector<int>& sizes) {
+    sizes.clear();
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        char* end = NULL;
+        long value = strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || value < 1 || value > 100000) {
+            return false;
+        }
+        sizes.push_back((int)value);
+    }
+    return !sizes.empty();
+}
+
+// Counters of the main thread, which runs all of the cases.
+HwCounters* counters = NULL;
+
+// Keeps the optimizer from dropping the work being timed.
+volatile long long sink = 0;
+
+// The points of a diamonds traversal, recorded as slice-viz does.
+void recordDiamonds(int T, int N, int tau, std::vector<TracePoint>& points) {
+    points.clear();
+    recordPoints(DiamondTiling(T, 1, N, 1, N, tau), points);
+}
+
+// Sizes of one grid point.
+struct BenchSize {
+    int N, T, tau;
+};
+
+// A case returns the function for one run at a grid point, which
+// returns the number of items it did.  Everything the case does before
+// returning is setup and is not timed.
+typedef std::function<long long()> BenchRun;
+struct BenchCase {
+    std::string name;
+    std::string tiling;
+    bool usesTau;
+    std::function<BenchRun(const BenchSize&)> setup;
+};
+
+// Times a counting traversal of the tiling.
+template <typename Tiling>
+BenchRun traverseRun(Tiling tiling) {
+    return [tiling]() {
+        long long count = 0, sum = 0;
+        forEachPoint(tiling, [&](const TileCoord& tile, int t, int i, int j) {
+            count++;
+            sum += tile.c0 + t + i + j;
+        });
+        sink = sink + sum;
+        return count;
+    };
+}
+
+BenchRun isTraverseRun(is_traversal_type traversal, int T, int N) {
+    return [traversal, T, N]() {
+        long long count = 0, sum = 0;
+        forEachIsPoint(traversal, T, N,
+            [&](const TileCoord& tile, int t, int i, int j) {
+                count++;
+                sum += tile.c0 + t + i + j;
+            });
+        sink = sink + sum;
+        return count;
+    };
+}
+
+// Colors of the recorded points of a diamonds traversal.
+std::shared_ptr<std::vector<std::string> > colorPoints(
+        const std::vector<TracePoint>& points) {
+    std::shared_ptr<std::vector<std::string> > colors(
+        new std::vector<std::string>());
+    StartFractionMap none;
+    TileColorer colorer(1, none, false);
+    colors->reserve(points.size());
+    for (size_t k = 0; k < points.size(); k++) {
+        const TracePoint& p = points[k];
+        colors->push_back(colorer.color(p.c1,p.c2,p.c3));
+    }
+    return colors;
+}
+
+// Slices sized like those of slice-viz with every point filled.
+std::shared_ptr<CellFieldArray> fillSlices(const BenchSize& s,
+        const std::vector<TracePoint>& points,
+        const std::vector<std::string>& colors) {
+    std::shared_ptr<CellFieldArray> slices(
+        new CellFieldArray(s.T, s.N+1, s.N+1, 60*(s.N+1), 1, s.T, 60, 20));
+    for (size_t k = 0; k < points.size(); k++) {
+        slices->setFill(points[k].t, points[k].i, points[k].j, colors[k]);
+    }
+    return slices;
+}
+
+std::vector<BenchCase> benchCases() {
+    std::vector<BenchCase> cases;
+
+    // Runtime tilings, with the bounds slice-viz gives them.
+    cases.push_back({"traverse", "diamonds", true,
+        [](const BenchSize& s) {
+            return traverseRun(DiamondTiling(s.T, 1, s.N, 1, s.N, s.tau));
+        }});
+    cases.push_back({"traverse", "diamond_prizms", true,
+        [](const BenchSize& s) {
+            return traverseRun(PrismTiling(s.T, 1, s.N-2, 1, s.N-2,
+                                           s.tau, s.tau));
+        }});
+    cases.push_back({"traverse", "pipelined", true,
+        [](const BenchSize& s) {
+            return traverseRun(PipelinedTiling(s.T, 1, s.N-2, 1, s.N-2,
+                                               s.tau, s.tau, s.tau));
+        }});
+
+    // Generated traversals.
+    static const struct {
+        is_traversal_type traversal;
+        const char* name;
+    } isTilings[] = {{is_pipelined_4x4x4, "pipelined_4x4x4"},
+                     {is_diamond_prizms_6x6, "diamond_prizms_6x6"},
+                     {is_diamond_prizms_8x8, "diamond_prizms_8x8"},
+                     {is_diamond_prizms_12x12, "diamond_prizms_12x12"},
+                     {is_diamond_prizms_6x6_noping,
+                      "diamond_prizms_6x6_noping"}};
+    for (size_t k = 0; k < sizeof(isTilings)/sizeof(isTilings[0]); k++) {
+        is_traversal_type traversal = isTilings[k].traversal;
+        cases.push_back({"traverse", isTilings[k].name, false,
+            [traversal](const BenchSize& s) {
+                return isTraverseRun(traversal, s.T, s.N);
+            }});
+    }
+
+    cases.push_back({"record", "diamonds", true,
+        [](const BenchSize& s) {
+            std::shared_ptr<std::vector<TracePoint> > points(
+                new std::vector<TracePoint>());
+            return BenchRun([s, points]() {
+                recordDiamonds(s.T, s.N, s.tau, *points);
+                return (long long)points->size();
+            });
+        }});
+
+    // The divisions the generated loop bounds do, over the tile
+    // coordinates of a time skewed NxN grid.
+    cases.push_back({"intops_floord", "", true,
+        [](const BenchSize& s) {
+            return BenchRun([s]() {
+                long long count = 0, sum = 0;
+                for (int t = 1; t <= s.T; t++) {
+                    for (int i = -s.N; i <= s.N; i++) {
+                        for (int j = -s.N; j <= s.N; j++) {
+                            int n = 2*t + i - j;
+                            sum += floord(n, s.tau) + ceild(n, s.tau);
+                            count++;
+                        }
+                    }
+                }
+                sink = sink + sum;
+                return count;
+            });
+        }});
+
+    cases.push_back({"color_tiles", "diamonds", true,
+        [](const BenchSize& s) {
+            std::shared_ptr<std::vector<TracePoint> > points(
+                new std::vector<TracePoint>());
+            recordDiamonds(s.T, s.N, s.tau, *points);
+            return BenchRun([points]() {
+                StartFractionMap none;
+                TileColorer colorer(1, none, false);
+                long long sum = 0;
+                for (size_t k = 0; k < points->size(); k++) {
+                    const TracePoint& p = (*points)[k];
+                    sum += colorer.color(p.c1,p.c2,p.c3).size();
+                }
+                sink = sink + sum;
+                return (long long)points->size();
+            });
+        }});
+
+    cases.push_back({"colorinfo_lookup", "diamonds", true,
+        [](const BenchSize& s) {
+            std::vector<TracePoint> points;
+            recordDiamonds(s.T, s.N, s.tau, points);
+            std::shared_ptr<std::vector<std::string> > colors
+                = colorPoints(points);
+            std::shared_ptr<ColorInfo> info(new ColorInfo());
+            return BenchRun([colors, info]() {
+                long long sum = 0;
+                for (size_t k = 0; k < colors->size(); k++) {
+                    sum += info->color(info->lookupOrBlack((*colors)[k]))
+                           .rgb();
+                }
+                sink = sink + sum;
+                return (long long)colors->size();
+            });
+        }});
+
+    cases.push_back({"cellfield_set_get", "diamonds", true,
+        [](const BenchSize& s) {
+            std::shared_ptr<std::vector<TracePoint> > points(
+                new std::vector<TracePoint>());
+            recordDiamonds(s.T, s.N, s.tau, *points);
+            std::shared_ptr<std::vector<std::string> > colors
+                = colorPoints(*points);
+            std::shared_ptr<CellFieldArray> slices
+                = fillSlices(s, *points, *colors);
+            return BenchRun([points, colors, slices]() {
+                long long sum = 0;
+                for (size_t k = 0; k < points->size(); k++) {
+                    const TracePoint& p = (*points)[k];
+                    slices->setFill(p.t, p.i, p.j, (*colors)[k]);
+                    sum += slices->getFill(p.t, p.i, p.j).size();
+                }
+                sink = sink + sum;
+                return (long long)points->size();
+            });
+        }});
+
+    cases.push_back({"emit_svg", "diamonds", true,
+        [](const BenchSize& s) {
+            std::vector<TracePoint> points;
+            recordDiamonds(s.T, s.N, s.tau, points);
+            std::shared_ptr<CellFieldArray> slices
+                = fillSlices(s, points, *colorPoints(points));
+            return BenchRun([s, slices]() {
+                std::ostringstream out;
+                SVGPrinter svg(out, 60*(s.N+1) + (s.T-1)*60*(s.N+1),
+                               (s.N+1)*60);
+                svg.printHeader();
+                slices->printToSVG(svg, 1, s.T);
+                svg.printFooter();
+                sink = sink + (long long)out.tellp();
+                return (long long)s.T*(s.N+1)*(s.N+1);
+            });
+        }});
+
+    cases.push_back({"emit_pov", "diamonds", true,
+        [](const BenchSize& s) {
+            std::shared_ptr<std::vector<TracePoint> > points(
+                new std::vector<TracePoint>());
+            recordDiamonds(s.T, s.N, s.tau, *points);
+            std::shared_ptr<std::vector<std::string> > colors
+                = colorPoints(*points);
+            // Resolve the colors once, as diamond-slice-viz-pov does.
+            ColorInfo info;
+            std::shared_ptr<std::vector<Color> > rgb(new std::vector<Color>());
+            for (size_t k = 0; k < colors->size(); k++) {
+                rgb->push_back(info.color(info.lookupOrBlack((*colors)[k])));
+            }
+            return BenchRun([points, rgb]() {
+                std::ostringstream out;
+                PrinterPOV pov(out);
+                pov.printHeader();
+                for (size_t k = 0; k < points->size(); k++) {
+                    const TracePoint& p = (*points)[k];
+                    const Color& c = (*rgb)[k];
+                    pov.printCircle(p.t, p.i, p.j, c.r, c.b, c.g);
+                }
+                pov.printFooter();
+                sink = sink + (long long)out.tellp();
+                return (long long)points->size();
+            });
+        }});
+
+    // What slice-viz does for one svg of diamonds without caches, with
+    // its default spacing and radius.
+    cases.push_back({"render_svg", "diamonds", true,
+        [](const BenchSize& s) {
+            return BenchRun([s]() {
+                Traversal traversal;
+                recordDiamonds(s.T, s.N, s.tau, traversal.points);
+                RenderJob job = {1, s.T, 60*(s.N+1), 60, 20, false, 1,
+                                 false, 0, 0, 0, false, "", ""};
+                std::ostringstream out;
+                renderSVG(job, traversal, s.T, s.N, false, out,
+                          [](CellFieldArray&) {});
+                sink = sink + (long long)out.tellp();
+                return (long long)traversal.points.size();
+            });
+        }});
+
+    return cases;
+}
+
+// Time of each rep in nanoseconds, the items of the last rep, and the
+// hardware counts of all reps.
+struct BenchTimes {
+    std::vector<double> ns;
+    long long items;
+    HwSample counts;
+};
+
+BenchTimes timeRun(BenchRun& run) {
+    BenchTimes times;
+    times.items = 0;
+    times.counts.clear();
+    for (int k = 0; k < warmup; k++) {
+        times.items = run();
+    }
+    HwSample before, after;
+    for (int k = 0; k < reps; k++) {
+        counters->read(before);
+        std::chrono::steady_clock::time_point start
+            = std::chrono::steady_clock::now();
+        times.items = run();
+        times.ns.push_back(std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count());
+        counters->read(after);
+        times.counts.add(after, before);
+    }
+    return times;
+}
+
+std::string csvHeader() {
+    std::string header = "label,case,tiling,N,T,tau,warmup,reps,items,"
+                         "median_ns,p95_ns,min_ns,mean_ns,ns_per_item,"
+                         "counters";
+    for (int c = 0; c < num_hw_counters; c++) {
+        header += std::string(",") + hwCounterName(c) + "_per_item";
+    }
+    return header;
+}
+
+// Nearest rank percentile of sorted values.
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = (size_t)(p*sorted.size() + 0.999999);
+    if (rank < 1) { rank = 1; }
+    if (rank > sorted.size()) { rank = sorted.size(); }
+    return sorted[rank-1];
+}
+
+int main(int argc, char ** argv) {
+
+    // Do command-line parsing.
+    CmdParams *cmdparams = CmdParams_ctor(0);
+    initParams(cmdparams);
+    CmdParams_parseParams(cmdparams,argc,argv);
+    strncpy(sizesN, CmdParams_getString(cmdparams,'N'), MAXPOSSVALSTRING);
+    strncpy(sizesT, CmdParams_getString(cmdparams,'T'), MAXPOSSVALSTRING);
+    strncpy(sizesTau, CmdParams_getString(cmdparams,'a'), MAXPOSSVALSTRING);
+    warmup = CmdParams_getValue(cmdparams,'w');
+    reps = CmdParams_getValue(cmdparams,'r');
+    strncpy(label, CmdParams_getString(cmdparams,'l'), MAXPOSSVALSTRING);
+    strncpy(outputFile, CmdParams_getString(cmdparams,'o'), MAXPOSSVALSTRING);
+    strncpy(caseFilter, CmdParams_getString(cmdparams,'c'), MAXPOSSVALSTRING);
+
+    std::vector<int> Ns, Ts, taus;
+    if (!parseSizes(sizesN, Ns) || !parseSizes(sizesT, Ts)
+            || !parseSizes(sizesTau, taus)) {
+        std::cerr << "ERROR: slice-viz-bench: N, T, and tau need to be "
+                  << "comma separated positive ints" << std::endl;
+        exit(-1);
+    }
+    for (size_t k = 0; k < Ns.size(); k++) {
+        if (Ns[k] < 4) {
+            std::cerr << "ERROR: slice-viz-bench: N needs to be at least 4"
+                      << std::endl;
+            exit(-1);
+        }
+    }
+
+    counters = new HwCounters();
+    if (!counters->ok()) {
+        std::cerr << "slice-viz-bench: no hardware counters ("
+                  << counters->error() << "), only timing" << std::endl;
+    }
+
+    // Append to the file, with the header only when the file is new.
+    // Rows with other columns can not go in the same file.
+    std::ofstream file;
+    std::ostream* out = &std::cout;
+    bool header = true;
+    if (strcmp(outputFile, "-") != 0) {
+        struct stat st;
+        header = (stat(outputFile, &st) != 0 || st.st_size == 0);
+        if (!header) {
+            std::ifstream in(outputFile);
+            std::string first;
+            std::getline(in, first);
+            if (first != csvHeader()) {
+                std::cerr << "ERROR: slice-viz-bench: " << outputFile
+                          << " has other columns, use a new file"
+                          << std::endl;
+                exit(-1);
+            }
+        }
+        file.open(outputFile, std::ios::app);
+        if (!file) {
+            std::cerr << "ERROR: slice-viz-bench: can not open " << outputFile
+                      << std::endl;
+            exit(-1);
+        }
+        out = &file;
+    }
+    if (header) {
+        *out << csvHeader() << std::endl;
+    }
+
+    std::vector<BenchCase> cases = benchCases();
+    for (size_t c = 0; c < cases.size(); c++) {
+        BenchCase& bc = cases[c];
+        std::string name = bc.name;
+        if (!bc.tiling.empty() && bc.name == "traverse") {
+            name += "_" + bc.tiling;
+        }
+        if (strcmp(caseFilter, "all") != 0
+                && name.find(caseFilter) == std::string::npos) {
+            continue;
+        }
+        for (size_t n = 0; n < Ns.size(); n++) {
+            for (size_t t = 0; t < Ts.size(); t++) {
+                for (size_t a = 0; a < taus.size(); a++) {
+                    if (!bc.usesTau && a > 0) { break; }
+                    BenchSize size = {Ns[n], Ts[t],
+                                      bc.usesTau ? taus[a] : 0};
+                    BenchRun run = bc.setup(size);
+                    BenchTimes times = timeRun(run);
+                    std::vector<double> sorted = times.ns;
+                    std::sort(sorted.begin(), sorted.end());
+                    double mean = 0.0;
+                    for (size_t k = 0; k < sorted.size(); k++) {
+                        mean += sorted[k];
+                    }
+                    mean /= sorted.size();
+                    double median = percentile(sorted, 0.5);
+                    *out << label << "," << name << "," << bc.tiling << ","
+                         << size.N << "," << size.T << "," << size.tau << ","
+                         << warmup << "," << reps << "," << times.items << ","
+                         << (long long)median << ","
+                         << (long long)percentile(sorted, 0.95) << ","
+                         << (long long)sorted[0] << "," << (long long)mean
+                         << ","
+                         << ((times.items > 0) ? median/times.items : 0.0)
+                         << "," << (counters->ok() ? "perf" : "timer");
+                    double total_items = (double)times.items*reps;
+                    for (int k = 0; k < num_hw_counters; k++) {
+                        *out << ",";
+                        if (counters->has(k) && total_items > 0) {
+                            *out << times.counts.value[k]/total_items;
+                        }
+                    }
+                    *out << std::endl;
+                }
+            }
+        }
+    }
+
+    delete counters;
+    CmdParams_dtor(&cmdparams);
+    return 0;
+}
@@ -19,12 +19,14 @@
 #include "Printer.hpp"
 #include "PrinterSVG.hpp"
 #include "PrinterPOV.hpp"
+#include "PhaseStats.hpp"
 
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <cstring>
 
 
 //==============================================
@@ -45,6 +47,7 @@ bool one_tile = false;
 int one_tile_c0 = 1;
 int one_tile_c1 = 1;
 int one_tile_c2 = -1;
+char colorFile[MAXPOSSVALSTRING];
 
 typedef enum {
     normal,
@@ -160,6 +163,11 @@ void initParams(CmdParams * cmdparams)
             "c2 coord for one tile being shown", 
             -10, 20, -1);
 
+    CmdParams_describeStringParam(cmdparams,"color_file", 'f', 1,
+            "file with colors that replace or add to the built in SVG "
+            "colors, see ColorInfo.hpp",
+            "none");
+
 }   
 
 // converts the tile coordinates to a string
@@ -178,14 +186,18 @@ std::string svgColors[] =
 int num_colors = 17;
 
 
-// converts the tile coordinates to a string
+// Indices in the ColorInfo table of red, yellow, green, and white,
+// looked up once in main.
+int waveColors[4];
+
+// converts the tile coordinates to a color index
 // MMS, 2/16/15, making things really simple
 // one color per wave of tiles
-std::string tileCoordToColor(int c0, int c1, int c2) {
-    if (c0==-2) return "red";
-    else if (c0==-1) return "yellow";
-    else if (c0==0) return "green";
-    else return "white";
+int tileCoordToColor(int c0, int c1, int c2) {
+    if (c0==-2) return waveColors[0];
+    else if (c0==-1) return waveColors[1];
+    else if (c0==0) return waveColors[2];
+    else return waveColors[3];
 }
 /*
 std::string tileCoordToColor(int c0, int c1, int c2) {
@@ -217,21 +229,23 @@ std::string tileCoordToColor(int c0, int c1, int c2) {
 
 int c0, c1, c2, c3, c4, c5, c6, c7, c8;
 
-// The computation macro prints the svg for each iteration point.
-// Capturing the c0, c1, and c2 variables in the generated code, which
-// should be the tile coordinates.
+// A point of the slab with its tile coordinates.
+struct SlabPoint {
+    int c0, c1, c2, t, i, j;
+};
+
+// Points are colored and then printed this many at a time, so that each
+// phase is timed once per batch rather than once per point.
+const size_t batchPoints = 4096;
+
+// The computation macro adds each iteration point to the batch, and
+// drawBatch prints the povray for the points of the batch.  Capturing
+// the c0, c1, and c2 variables in the generated code, which should be
+// the tile coordinates.
 #define computation(c0,c1,c2,t,i,j) { \
-    std::string colorstr = tileCoordToColor(c0,c1,c2); \
-    if (debug) { \
-      std::cout << "c0,c1,c2 = " << c0 << ", " << c1 << ", " << c2 << "    "; \
-      std::cout << "t,i,j = " << t << ", " << i << ", " << j << std::endl; \
-      std::cout << "color = " << colorstr << std::endl; \
-    } \
-    pov.printCircle(t,i,j, colorTable.getR(colorstr), \
-                           colorTable.getG(colorstr), \
-                           colorTable.getB(colorstr) ); \
-    std::cout << "{ pos: " << t << " " << i << " " << j << "; color: "; \
-    std::cout << colorTable.getHexCode(colorstr) << "}" << std::endl; \
+    SlabPoint point = {c0, c1, c2, t, i, j}; \
+    batch.push_back(point); \
+    if (batch.size() == batchPoints) { drawBatch(); } \
   }
     //if (label) slices.setLabel(t,i,j,tileCoordToString(c0,c1,c2)); \
     if (!one_tile || (c0==one_tile_c0 && c1==one_tile_c1 && c2==one_tile_c2)) {\
@@ -239,11 +253,15 @@ int c0, c1, c2, c3, c4, c5, c6, c7, c8;
 //Can use for SVG: rgb(205,133,63)
     
 int main(int argc, char ** argv) {
+    StatsReport stats(argc, argv, "diamond-slice-viz-pov");
 
     // Do command-line parsing.
     CmdParams *cmdparams = CmdParams_ctor(1);
-    initParams(cmdparams);
-    CmdParams_parseParams(cmdparams,argc,argv);
+    {
+        PhaseTimer timer(phase_parse);
+        initParams(cmdparams);
+        CmdParams_parseParams(cmdparams,argc,argv);
+    }
     tau = CmdParams_getValue(cmdparams,'t');
 /*    if (tau<15 || (tau%3)!=0) { 
         cerr << "Error: tau must be 15 or greater and a multiple of 3" << endl;
@@ -266,6 +284,7 @@ int main(int argc, char ** argv) {
     one_tile_c0 = CmdParams_getValue(cmdparams,'0');
     one_tile_c1 = CmdParams_getValue(cmdparams,'1');
     one_tile_c2 = CmdParams_getValue(cmdparams,'2');
+    strncpy(colorFile, CmdParams_getString(cmdparams,'f'), MAXPOSSVALSTRING);
 
     // Compute the spacing between slices.
     if (grid_spacing<0) {
@@ -280,7 +299,14 @@ int main(int argc, char ** argv) {
     }
 
     //========================================
-    ColorInfo colorTable("svg-colors-rgb.txt");
+    ColorInfo colorTable;
+    if (strcmp(colorFile,"none") != 0) {
+        colorTable = ColorInfo(colorFile);
+    }
+    const char* waveColorNames[4] = {"red", "yellow", "green", "white"};
+    for (int w = 0; w < 4; w++) {
+        waveColors[w] = colorTable.lookupOrBlack(waveColorNames[w]);
+    }
 
 
     //========================================
@@ -303,52 +329,97 @@ int main(int argc, char ** argv) {
     ofstream povfile(povfilename.c_str());
     PrinterPOV pov(povfile);
     std::cout << "Generating file " << povfilename << std::endl;
-    pov.printHeader();
+    {
+        PhaseTimer timer(phase_emit);
+        pov.printHeader();
+    }
     
     //========================================
     int k1, k2, t, i, j;
     int Li=0, Ui=N, Lj=0, Uj=N;
     int tau_times_3 = 3*tau;
-
-    // loops over bottom left, middle, top right
-    for (int thyme = -2; thyme<=0; thyme+=1){
+    std::vector<SlabPoint> batch;
+    std::vector<const Color*> batchColors;
+    auto drawBatch = [&]() {
+        {
+            PhaseTimer timer(phase_color);
+            batchColors.resize(batch.size());
+            for (size_t k = 0; k < batch.size(); k++) {
+                const SlabPoint& p = batch[k];
+                batchColors[k]
+                    = &colorTable.color(tileCoordToColor(p.c0, p.c1, p.c2));
+            }
+        }
+        PhaseTimer timer(phase_emit);
+        for (size_t k = 0; k < batch.size(); k++) {
+            const SlabPoint& p = batch[k];
+            const Color* color = batchColors[k];
+            if (debug) {
+                std::cout << "c0,c1,c2 = " << p.c0 << ", " << p.c1 << ", "
+                          << p.c2 << "    ";
+                std::cout << "t,i,j = " << p.t << ", " << p.i << ", "
+                          << p.j << std::endl;
+                std::cout << "color = " << color->name << std::endl;
+            }
+            pov.printCircle(p.t, p.i, p.j, color->r, color->g, color->b);
+            std::cout << "{ pos: " << p.t << " " << p.i << " " << p.j
+                      << "; color: ";
+            std::cout << color->hexcode << "}" << std::endl;
+        }
+        batch.clear();
+    };
+    {
+        PhaseTimer timer(phase_traverse);
+        // loops over bottom left, middle, top right
+        for (int thyme = -2; thyme<=0; thyme+=1){
     
-        // MMS, 2/16/15, copied in code from
-        // Jacobi2D-DiamondByHandParam-OMP.test.c
-        // The next two loops iterate within a tile wavefront.
-        int k1_lb = floord(3*Lj+2+(thyme-2)*tau,tau_times_3);
-        int k1_ub = floord(3*Uj+(thyme+2)*tau-2,tau_times_3);
-
-        // These bounds have been unskewed by adding in k1.
-        // That also turns them into a bounding box.
-        int k2_lb = floord((2*thyme-2)*tau-3*Ui+2,tau_times_3);
-        int k2_ub = floord((2+2*thyme)*tau-2-3*Li,tau_times_3);
+            // MMS, 2/16/15, copied in code from
+            // Jacobi2D-DiamondByHandParam-OMP.test.c
+            // The next two loops iterate within a tile wavefront.
+            int k1_lb = floord(3*Lj+2+(thyme-2)*tau,tau_times_3);
+            int k1_ub = floord(3*Uj+(thyme+2)*tau-2,tau_times_3);
+
+            // These bounds have been unskewed by adding in k1.
+            // That also turns them into a bounding box.
+            int k2_lb = floord((2*thyme-2)*tau-3*Ui+2,tau_times_3);
+            int k2_ub = floord((2+2*thyme)*tau-2-3*Li,tau_times_3);
     
-        for (k1=k1_lb; k1<=k1_ub; k1++) {
-          for (int x=k2_lb; x<=k2_ub; x++) {
-            k2 = x-k1; // skew back
-            // Don't have to check bounds based on k1 because the skew
-            // was the only dependence of k2 bounds on k1.
-
-            // Loop over time within a tile.
-            for (t=max(1,floord(thyme*tau,3)); 
-                 t<= min(T,floord((3+thyme)*tau-3,3)); t++) {
-              // Loops over spatial dimensions within tile.
-              for (i=max(Li,max((thyme-k1-k2)*tau-t, 2*t-(2+k1+k2)*tau+2));
-                   i<=min(Ui,min((1+thyme-k1-k2)*tau-t-1, 2*t-(k1+k2)*tau)); i++) {
-                for (j=max(Lj,max(tau*k1-t,t-i-(1+k2)*tau+1));
-                     j<=min(Uj,min((1+k1)*tau-t-1,t-i-k2*tau)); j++) {
-                  computation( thyme,k1,k2, t, i, j);
-                } // for j
-              } // for i
-            } // for t
-          } // for k2
-        } // for k1
-    } // for thyme  
+            for (k1=k1_lb; k1<=k1_ub; k1++) {
+              for (int x=k2_lb; x<=k2_ub; x++) {
+                k2 = x-k1; // skew back
+                long long points = 0;
+                // Don't have to check bounds based on k1 because the skew
+                // was the only dependence of k2 bounds on k1.
+
+                // Loop over time within a tile.
+                for (t=max(1,floord(thyme*tau,3)); 
+                     t<= min(T,floord((3+thyme)*tau-3,3)); t++) {
+                  // Loops over spatial dimensions within tile.
+                  for (i=max(Li,max((thyme-k1-k2)*tau-t, 2*t-(2+k1+k2)*tau+2));
+                       i<=min(Ui,min((1+thyme-k1-k2)*tau-t-1, 2*t-(k1+k2)*tau)); i++) {
+                    for (j=max(Lj,max(tau*k1-t,t-i-(1+k2)*tau+1));
+                         j<=min(Uj,min((1+k1)*tau-t-1,t-i-k2*tau)); j++) {
+                      computation( thyme,k1,k2, t, i, j);
+                      points++;
+                    } // for j
+                  } // for i
+                } // for t
+                phaseStats.countPoints(points);
+                phaseStats.countTiles(1);
+                if (points == 0) { phaseStats.countEmptyTiles(1); }
+              } // for k2
+            } // for k1
+        } // for thyme  
+        drawBatch();
+    }
 
     // End of the file.
     //svg.printFooter();
-    pov.printFooter();
+    {
+        PhaseTimer timer(phase_emit);
+        pov.printFooter();
+    }
+    phaseStats.countBytes(povfile.tellp());
 
     return 0;
 }
@@ -17,10 +17,14 @@
 #include "CellFieldArray.hpp"
 #include "svgprinter.hpp"
 #include "CmdParams.h"
+#include "CoverageChecker.hpp"
+#include "PhaseStats.hpp"
 #include <fstream>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 //==============================================
 // Global parameters with their default values.
@@ -40,6 +44,7 @@ bool one_tile = false;
 int one_tile_c0 = 1;
 int one_tile_c1 = 1;
 int one_tile_c2 = -1;
+bool coverage = false;
 
 typedef enum {
     normal,
@@ -152,6 +157,12 @@ void initParams(CmdParams * cmdparams)
             "c2 coord for one tile being shown", 
             -10, 20, -1);
 
+    CmdParams_describeNumParam(cmdparams,"coverage", 'C', 1,
+            "whether to check that the slab traversal visits every point "
+            "of 1<=t<=subset_s, 0<=i,j<N exactly once instead of "
+            "drawing it",
+            0, 1, 0);
+
 }   
 
 // converts the tile coordinates to a string
@@ -212,12 +223,56 @@ int c0, c1, c2, c3, c4, c5, c6, c7, c8;
     } \
     if (!one_tile || (c0==one_tile_c0 && c1==one_tile_c1 && c2==one_tile_c2)) {\
       slices.setFill(t,i,j,tileCoordToColor(c0,c1,c2)); } }
+
+// A point of the slab with its tile coordinates.
+struct SlabPoint {
+    int c0, c1, c2, t, i, j;
+};
+
+// Points are colored this many at a time, so that coloring is timed
+// once per batch rather than once per point.
+const size_t batchPoints = 4096;
     
+// Calls f(c0,c1,c2,t,i,j) for each point of the slab 1<=t<=subset_s
+// over the NxN grid, in the order the tiles are drawn.  Counts the
+// points and tiles for --stats.
+template <typename F>
+void forEachSlabPoint(F f) {
+    int Li=0, Ui=N, Lj=0, Uj=N;
+    
+    // loops over bottom left, middle, top right
+    for (int c0 = -2; c0<=0; c0+=1)
+      // loops horizontally?
+      for (int c1 = 0; c1 <= (Uj+tau-3)/(tau-3) ; c1 += 1)
+         // loops vertically?, but without skew
+        for (int x = (-Ui-tau+2)/(tau-3); x<=0 ; x += 1){
+          int c2 = x-c1; //skew
+          long long points = 0;
+          // loops for time steps within a slab (slices within slabs)
+          for (int c3 = 1; c3<=subset_s; c3 += 1)
+      
+            for (int c4 = max(max(max(-tau * c1 - tau * c2 + 2 * c3 - (2*tau-2), -Uj - tau * c2 + c3 - (tau-2)), tau * c0 - tau * c1 - tau * c2 - c3), Li); c4 <= min(min(min(tau * c0 - tau * c1 - tau * c2 - c3 + (tau-1), -tau * c1 - tau * c2 + 2 * c3), -Lj - tau * c2 + c3), Ui - 1); c4 += 1)
+        
+              for (int c5 = max(max(tau * c1 - c3, Lj), -tau * c2 + c3 - c4 - (tau-1)); c5 <= min(min(Uj - 1, -tau * c2 + c3 - c4), tau * c1 - c3 + (tau-1)); c5 += 1) {
+                f(c0, c1, c2, c3, c4, c5);
+                points++;
+              }
+          phaseStats.countPoints(points);
+          phaseStats.countTiles(1);
+          if (points == 0) { phaseStats.countEmptyTiles(1); }
+        }
+}
+
 int main(int argc, char ** argv) {
+    StatsReport stats(argc, argv, "diamond-slice-viz");
+
     // Do command-line parsing.
     CmdParams *cmdparams = CmdParams_ctor(1);
-    initParams(cmdparams);
-    CmdParams_parseParams(cmdparams,argc,argv);
+    {
+        PhaseTimer timer(phase_parse);
+        initParams(cmdparams);
+        CmdParams_parseParams(cmdparams,argc,argv);
+    }
     tau = CmdParams_getValue(cmdparams,'t');
     if (tau<15 || (tau%3)!=0) { 
         cerr << "Error: tau must be 15 or greater and a multiple of 3" << endl;
@@ -239,6 +294,20 @@ int main(int argc, char ** argv) {
     one_tile_c0 = CmdParams_getValue(cmdparams,'0');
     one_tile_c1 = CmdParams_getValue(cmdparams,'1');
     one_tile_c2 = CmdParams_getValue(cmdparams,'2');
+    coverage = CmdParams_getValue(cmdparams,'C');
+
+    if (coverage) {
+        CoverageChecker checker(subset_s, 0, N-1, 0, N-1);
+        checker.checkTraversal([&](const auto& visit) {
+            forEachSlabPoint([&](int c0, int c1, int c2,
+                                 int t, int i, int j) {
+                TileCoord tile = {c0, c1, c2};
+                visit(tile, t, i, j);
+            });
+        });
+        printCoverageReport(std::cout, checker.report());
+        return checker.report().exactlyOnce() ? 0 : 1;
+    }
 
     // Compute the spacing between slices.
     if (grid_spacing<0) {
@@ -259,40 +328,50 @@ int main(int argc, char ** argv) {
     // Specify file and height and width.
     SVGPrinter svg(file, cell_spacing*(N+1) + ((Tend-Tstart+1)-1)*grid_spacing,
                          (N+1)*cell_spacing);
-    svg.printHeader();
+    {
+        PhaseTimer timer(phase_emit);
+        svg.printHeader();
+    }
     
     // Declare the array of iteration spaces.
     CellField::sSpacing = cell_spacing;
     CellField::sRadius = cell_radius;
-    CellFieldArray slices(T,N,N,grid_spacing,Tstart,Tend);
-
-    int Li=0, Ui=N, Lj=0, Uj=N;
-    
-    // loops over bottom left, middle, top right
-    for (int c0 = -2; c0<=0; c0+=1)
-      // loops horizontally?
-      for (int c1 = 0; c1 <= (Uj+tau-3)/(tau-3) ; c1 += 1)
-         // loops vertically?, but without skew
-        for (int x = (-Ui-tau+2)/(tau-3); x<=0 ; x += 1){
-          int c2 = x-c1; //skew
-          // loops for time steps within a slab (slices within slabs)
-          for (int c3 = 1; c3<=subset_s; c3 += 1)
-      
-            for (int c4 = max(max(max(-tau * c1 - tau * c2 + 2 * c3 - (2*tau-2), -Uj - tau * c2 + c3 - (tau-2)), tau * c0 - tau * c1 - tau * c2 - c3), Li); c4 <= min(min(min(tau * c0 - tau * c1 - tau * c2 - c3 + (tau-1), -tau * c1 - tau * c2 + 2 * c3), -Lj - tau * c2 + c3), Ui - 1); c4 += 1)
-        
-              for (int c5 = max(max(tau * c1 - c3, Lj), -tau * c2 + c3 - c4 - (tau-1)); c5 <= min(min(Uj - 1, -tau * c2 + c3 - c4), tau * c1 - c3 + (tau-1)); c5 += 1) {
-                computation(c3, c4, c5);
-              }
-        }
-              
-
+    std::unique_ptr<CellFieldArray> allocated;
+    {
+        PhaseTimer timer(phase_allocate);
+        allocated.reset(new CellFieldArray(T,N,N,grid_spacing,Tstart,Tend));
+    }
+    CellFieldArray& slices = *allocated;
+
+    {
+        PhaseTimer timer(phase_traverse);
+        std::vector<SlabPoint> batch;
+        auto colorBatch = [&]() {
+            PhaseTimer timer(phase_color);
+            for (size_t k = 0; k < batch.size(); k++) {
+                int c0 = batch[k].c0, c1 = batch[k].c1, c2 = batch[k].c2;
+                computation(batch[k].t, batch[k].i, batch[k].j);
+            }
+            batch.clear();
+        };
+        forEachSlabPoint([&](int c0, int c1, int c2, int t, int i, int j) {
+            SlabPoint point = {c0, c1, c2, t, i, j};
+            batch.push_back(point);
+            if (batch.size() == batchPoints) { colorBatch(); }
+        });
+        colorBatch();
+    }
 
-    // Print the SVG string out to the file.
-    slices.printToSVG(svg,Tstart,Tend);
-    std::cout << "Generating file " << filename << std::endl;
+    {
+        PhaseTimer timer(phase_emit);
+        // Print the SVG string out to the file.
+        slices.printToSVG(svg,Tstart,Tend);
+        std::cout << "Generating file " << filename << std::endl;
     
-    // End of the file.
-    svg.printFooter();
+        // End of the file.
+        svg.printFooter();
+    }
+    phaseStats.countBytes(file.tellp());
 
     return 0;
 }
@@ -1,3 +1,10 @@
+#ifndef INTOPS_H_
+#define INTOPS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
 #define min2(a,b)	((a)>(b)?(b):(a))
 #define min3(a,b,c)	(min2(min2(a,b), c))
 #define min4(a,b,c,d)	(min2(min2(a,b), min2(c,d)))
@@ -54,3 +61,41 @@ static inline int intMod(int n, int d)
 }
 #endif
 
+/* Overflow checked 64 bit arithmetic for sizes and bounds that can
+ * exceed int on production grids, such as the T*N*N points of a tiling
+ * or the canvas of a drawing.  An overflow is reported and exits, like
+ * a bad command line parameter. */
+static inline void intops_overflow(const char* op, long long a, long long b)
+{
+  fprintf(stderr, "Error: 64 bit overflow in %lld %s %lld\n", a, op, b);
+  exit(1);
+}
+
+static inline long long checkedAdd64(long long a, long long b)
+{
+  long long r;
+  if (__builtin_add_overflow(a, b, &r)) { intops_overflow("+", a, b); }
+  return r;
+}
+
+static inline long long checkedSub64(long long a, long long b)
+{
+  long long r;
+  if (__builtin_sub_overflow(a, b, &r)) { intops_overflow("-", a, b); }
+  return r;
+}
+
+static inline long long checkedMul64(long long a, long long b)
+{
+  long long r;
+  if (__builtin_mul_overflow(a, b, &r)) { intops_overflow("*", a, b); }
+  return r;
+}
+
+/* Whether a 64 bit value can be used as an int bound. */
+static inline int fitsInt(long long a)
+{
+  return INT_MIN <= a && a <= INT_MAX;
+}
+
+#endif
@@ -4,6 +4,27 @@
  * \brief Driver for visualizing 2D slices of 3D diamond
  *        or pipelined tiles.
  *
+ * The tiling is traversed once to record every point with its tile
+ * coordinates, and the svg file is then colored from that record.
+ * With -B batch_file every line of the file gives the parameters of
+ * one svg file.  Lines with the same tiling, T, N, tile sizes, and
+ * simulated run share one traversal, and their files are written in
+ * parallel by -j threads.
+ *
+ * With -S socket_path slice-viz is a daemon that renders requests sent
+ * to the Unix socket and caches traversals and svgs, see serve().
+ *
+ * With -C cache_dir traversals and svg files are also cached on disk
+ * between runs, see RenderCache.hpp.  A file whose svg is cached is
+ * copied without traversing the tiling.
+ *
+ * With -L 1 T, N, and the tile sizes can be production sizes.  Grids
+ * with too many circles for an svg of CellFields are streamed or drawn
+ * as a ppm raster, see chooseOutput().
+ *
+ * With -x trace_file the tiles are colored by when they ran in a real
+ * run, from a trace that stencil-run -x wrote, see traceHeat().
+ *
  * \date Started: 9/21/13
  *
  * \authors Michelle Strout
@@ -16,10 +37,39 @@
 #include "CellFieldArray.hpp"
 #include "svgprinter.hpp"
 #include "CmdParams.h"
+#include "DiamondTiling.hpp"
+#include "PrismTiling.hpp"
+#include "PipelinedTiling.hpp"
+#include "TileFootprint.hpp"
+#include "TileGraph.hpp"
+#include "ExecutionSim.hpp"
+#include "TileColorer.hpp"
+#include "SliceRender.hpp"
+#include "LRUCache.hpp"
+#include "RenderCache.hpp"
+#include "ColorInfo.hpp"
+#include "PhaseStats.hpp"
+#include "TileTrace.hpp"
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <poll.h>
+#include <sys/un.h>
+#include <sys/stat.h>
 
 #include "intops.h"
 
@@ -30,6 +80,9 @@ int Tstart = 1;
 int Tend = 4;
 int N = 10;
 int tau = 15;
+int sigma = 15;
+int height = 0;
+int gamma_size = 15;
 int grid_spacing = -1;
 int cell_spacing = 60;
 int cell_radius = 20;
@@ -40,6 +93,16 @@ bool one_tile = false;
 int one_tile_c1 = 1;
 int one_tile_c2 = 1;
 int one_tile_c3 = -1;
+bool footprint = false;
+int sim_workers = 0;
+int num_threads = 0;
+char batchFile[MAXPOSSVALSTRING];
+char serverSocket[MAXPOSSVALSTRING];
+int cache_mb = 256;
+char cacheDir[MAXPOSSVALSTRING];
+int disk_cache_mb = 1024;
+bool large_scale = false;
+int max_memory_mb = 4096;
 
 typedef enum {
     pipelined_4x4x4,
@@ -47,17 +110,21 @@ typedef enum {
     diamond_prizms_6x6,
     diamond_prizms_8x8,
     diamond_prizms_12x12,
-    diamond_prizms_6x6_noping
+    diamond_prizms_6x6_noping,
+    diamond_prizms,
+    pipelined
 } tiling_type;
 tiling_type tilingChoice = diamonds;
 char tilingStr[MAXPOSSVALSTRING];
-#define num_TPairs 6
+#define num_TPairs 8
 static EnumStringPair TPairs[] = {{pipelined_4x4x4,"pipelined_4x4x4"},
                         {diamonds,"diamonds"},
                         {diamond_prizms_6x6,"diamond_prizms_6x6"},
                         {diamond_prizms_8x8,"diamond_prizms_8x8"},
                         {diamond_prizms_12x12,"diamond_prizms_12x12"},
-                        {diamond_prizms_6x6_noping,"diamond_prizms_6x6_noping"}
+                        {diamond_prizms_6x6_noping,"diamond_prizms_6x6_noping"},
+                        {diamond_prizms,"diamond_prizms"},
+                        {pipelined,"pipelined"}
                 };
 
 typedef enum {
@@ -71,6 +138,29 @@ static EnumStringPair GPairs[] = {{normal,"normal"},
                                   {halfradius,"halfradius"}
                                  };            
 
+policy_type policyChoice = policy_greedy;
+char policyStr[MAXPOSSVALSTRING];
+#define num_PPairs 2
+static EnumStringPair PPairs[] = {{policy_barrier,"barrier"},
+                                  {policy_greedy,"greedy"}
+                                 };
+
+char traceFile[MAXPOSSVALSTRING];
+typedef enum {
+    heat_start,
+    heat_end,
+    heat_duration,
+    heat_worker
+} heat_type;
+heat_type heatChoice = heat_start;
+char heatStr[MAXPOSSVALSTRING];
+#define num_HPairs 4
+static EnumStringPair HPairs[] = {{heat_start,"start"},
+                                  {heat_end,"end"},
+                                  {heat_duration,"duration"},
+                                  {heat_worker,"worker"}
+                                 };
+
 //==============================================
 
 // Create the file name based on parameters.
@@ -81,6 +171,11 @@ std::string create_file_name() {
     ss << tilingStr;
     ss << "-T" << T << "N" << N;
     ss << "-t" << tau;
+    if (tilingChoice==diamond_prizms) {
+        ss << "x" << sigma;
+        if (height > 0) { ss << "h" << height; }
+    }
+    if (tilingChoice==pipelined) { ss << "x" << sigma << "x" << gamma_size; }
     ss << "-s" << Tstart << "e" << Tend;
     ss << "-p" << grid_spacing 
        << "c" << cell_spacing << "r" << cell_radius << "l" << label;
@@ -89,6 +184,9 @@ std::string create_file_name() {
     if (one_tile) { 
        ss << "." << one_tile_c1 << "." << one_tile_c2 << "." << one_tile_c3;
     }
+    if (footprint) { ss << "-f" << footprint; }
+    if (sim_workers > 0) { ss << "-w" << sim_workers << policyStr; }
+    if (strcmp(traceFile,"none") != 0) { ss << "-x" << heatStr; }
     ss << ".svg";
     
     return ss.str();
@@ -108,24 +206,42 @@ void initParams(CmdParams * cmdparams)
             TPairs, num_TPairs, diamonds);
 
     CmdParams_describeNumParam(cmdparams,"numTimeSteps", 'T', 1,
-            "number of time steps",
-            1, 30, 4);
+            "number of time steps, at most 30 without large_scale",
+            1, 1000000, 4);
+
+    CmdParams_describeNumParam(cmdparams,"tau", 'a', 1,
+            "tile size for diamond tiles, along t+i for diamond_prizms, "
+            "and along t for pipelined (tau), at most 30 without "
+            "large_scale",
+            1, 1000000, 15);
+
+    CmdParams_describeNumParam(cmdparams,"sigma", 'b', 1,
+            "tile size along t-i for diamond_prizms "
+            "and along t+i for pipelined (sigma), at most 30 without "
+            "large_scale",
+            2, 1000000, 15);
+
+    CmdParams_describeNumParam(cmdparams,"height", 'E', 1,
+            "time steps a diamond_prizms tile spans, at most "
+            "(tau+sigma)/2, or 0 for (tau+sigma)/2",
+            0, 1000000, 0);
 
-    CmdParams_describeNumParam(cmdparams,"tau", 't', 1,
-            "tile size for diamond tiles (tau)",
-            3, 30, 15);
+    CmdParams_describeNumParam(cmdparams,"gamma", 'G', 1,
+            "tile size along t+j for pipelined (gamma), at most 30 "
+            "without large_scale",
+            2, 1000000, 15);
 
     CmdParams_describeNumParam(cmdparams,"Tstart", 's', 1,
             "start visualization at Tstart",
-            1, 30, 1);
+            1, 1000000, 1);
             
     CmdParams_describeNumParam(cmdparams,"Tend", 'e', 1,
             "end visualization at Tend, will default to T",
-            1, 30, -1);
+            1, 1000000, -1);
             
     CmdParams_describeNumParam(cmdparams,"spatialDim", 'N', 1,
-            "2D data will be NxN", 
-            1, 50, 10);
+            "2D data will be NxN, at most 50 without large_scale", 
+            1, 1000000, 10);
 
     CmdParams_describeEnumParam(cmdparams,"grid_spacing_approach", 'g', 1,
             "approach for spacing between top of slices", 
@@ -168,77 +284,108 @@ void initParams(CmdParams * cmdparams)
             "c2 coord for one tile being shown", 
             -10, 20, 1);
 
-    CmdParams_describeNumParam(cmdparams,"one_tile_c1", '3', 1,
-            "c2 coord for one tile being shown", 
+    CmdParams_describeNumParam(cmdparams,"one_tile_c3", '3', 1,
+            "c3 coord for one tile being shown", 
             -10, 20, -1);
 
-}   
+    CmdParams_describeNumParam(cmdparams,"footprint", 'f', 1,
+            "whether to outline the values the one tile reads from other "
+            "tiles in red and print its footprint, only for diamonds, "
+            "diamond_prizms, and pipelined",
+            0, 1, 0);
 
-// converts the tile coordinates to a string
-std::string tileCoordToString(int c1, int c2, int c3) {
+    CmdParams_describeNumParam(cmdparams,"sim_workers", 'w', 1,
+            "color tiles by their start time in a simulated run on this "
+            "many workers, 0 means color by tile, only for diamonds, "
+            "diamond_prizms, and pipelined",
+            0, 100000, 0);
 
-    std::stringstream ss;
+    CmdParams_describeEnumParam(cmdparams,"policy", 'P', 1,
+            "scheduling policy of the simulated run",
+            PPairs, num_PPairs, policy_greedy);
 
-    switch (tilingChoice) {
-    
-        // Diamond prizms only have 2 dimensions of tiling.
-        case diamond_prizms_6x6:
-        case diamond_prizms_8x8:
-        case diamond_prizms_12x12:
-            ss << c1 << "," << c2;
-            break;
-        default:
-            ss << c1 << "," << c2 << "," << c3;
-            break;
-    }
-    
-    return ss.str();
-}
+    CmdParams_describeStringParam(cmdparams,"trace_file", 'x', 1,
+            "color tiles by a trace of a real run that stencil-run -x "
+            "wrote with the same tiling and tile sizes, only for "
+            "diamonds, diamond_prizms, and pipelined",
+            "none");
 
-// Array of colors.
-std::string svgColors[] = 
-//{"bisque","red","aqua","yellow","blue","green","fuchsia","lime","silver","coral","lavender","pink","powderblue","plum","palegreen"};
-{"red","yellow","green","lime","aqua","blue","fuchsia","silver","bisque","coral","lavender","pink","powderblue","plum","palegreen","teal","navy"};
-//{"maroon","red","olive","yellow","green","lime","teal","aqua","navy","blue","purple","fuchsia","black","grey","silver","white"};
-//{"yellow","green","aqua","navy","red","teal","fuchsia","lime","maroon","silver","olive","blue","black","purple","gray","white"};
-int num_colors = 17;
+    CmdParams_describeEnumParam(cmdparams,"heat", 'H', 1,
+            "what of the traced run colors the tiles, from blue for the "
+            "least to red for the most",
+            HPairs, num_HPairs, heat_start);
 
-// converts the tile coordinates to a string
-std::string tileCoordToColor(int c1, int c2, int c3) {
-    static int count = -1;
-    static int last_c1 = -99;
-    static int last_c2 = -99;
-    static int last_c3 = -99;
+    CmdParams_describeStringParam(cmdparams,"batch_file", 'B', 1,
+            "file with the parameters of one svg file per line, each line "
+            "overriding the command line, jobs with the same tiling, T, "
+            "N, tile sizes, and simulated run share one traversal",
+            "none");
 
-    // We want to change the tile color if the tile coordinate
-    // has changed.
+    CmdParams_describeNumParam(cmdparams,"threads", 'j', 1,
+            "threads that write the svg files of a batch, 0 means one per "
+            "core",
+            0, 1024, 0);
 
-    switch (tilingChoice) {
-    
-        // Diamond prizms only have 2 dimensions of tiling.
-        case diamond_prizms_6x6:
-        case diamond_prizms_8x8:
-        case diamond_prizms_12x12:
-            if (c1!=last_c1 || c2!=last_c2) {
-                last_c1 = c1;
-                last_c2 = c2;
-                last_c3 = c3;
-                count += color_incr;
-            }
-            break;
-        default:
-            if (c1!=last_c1 || c2!=last_c2 || c3!=last_c3) {
-                last_c1 = c1;
-                last_c2 = c2;
-                last_c3 = c3;
-                count += color_incr;
-            }
-            break;
-    }
-    
-    return svgColors[ count % num_colors ];
+    CmdParams_describeStringParam(cmdparams,"server_socket", 'S', 1,
+            "run as a daemon that renders requests sent to this Unix "
+            "socket, see serve()",
+            "none");
+
+    CmdParams_describeNumParam(cmdparams,"cache_mb", 'M', 1,
+            "megabytes for each of the daemon's traversal and svg caches",
+            1, 1000000, 256);
+
+    CmdParams_describeStringParam(cmdparams,"cache_dir", 'C', 1,
+            "directory where traversals and svg files are cached between "
+            "runs, see RenderCache.hpp",
+            "none");
+
+    CmdParams_describeNumParam(cmdparams,"disk_cache_mb", 'D', 1,
+            "megabytes that cache_dir may hold",
+            1, 1000000, 1024);
+
+    CmdParams_describeNumParam(cmdparams,"large_scale", 'L', 1,
+            "allow production sizes of T, N, and the tile sizes, drawing "
+            "large grids as a streamed svg or a ppm raster, see "
+            "chooseOutput()",
+            0, 1, 0);
+
+    CmdParams_describeNumParam(cmdparams,"max_memory_mb", 'X', 1,
+            "megabytes large_scale may use for the drawing",
+            1, 100000000, 4096);
+
+}   
+
+// Diamond prizms only have 2 dimensions of tiling, so their color only
+// changes with c1 and c2.
+bool tilesHaveTwoDims() {
+    return tilingChoice==diamond_prizms_6x6 || tilingChoice==diamond_prizms_8x8
+           || tilingChoice==diamond_prizms_12x12
+           || tilingChoice==diamond_prizms;
+}
+
+// converts the tile coordinates to a string
+std::string tileCoordToString(int c1, int c2, int c3) {
+    return tileLabel(c1, c2, c3, tilesHaveTwoDims());
 }
 
+// Where the calc macros record points.
+Traversal* recording = NULL;
+
+// Parameters that change the traversal.  Jobs that agree on all of
+// them share one traversal.
+struct TraversalParams {
+    tiling_type tilingChoice;
+    std::string tilingStr;
+    int T, N, tau, sigma, height, gamma_size;
+    int sim_workers;
+    policy_type policyChoice;
+    std::string policyStr;
+    std::string traceFile;
+    heat_type heatChoice;
+    std::string heatStr;
+};
+
 // Definitions and declarations needed for diamonds-tij-skew.is
 #include "eassert.h"
 #include "intops.h"
@@ -251,53 +398,751 @@ std::string tileCoordToColor(int c1, int c2, int c3) {
 
 int c1, c2, c3, c4, c5, c6, c7, c8;
 
-// The calc_ping and calc_pong macros are capturing the slices,
+// The calc_ping and calc_pong macros are capturing the
 // c1, c2, and c3 variables.
 #define calc_ping(t,i,j) { \
-    if (label) slices.setLabel(t,i,j,tileCoordToString(c1,c2,c3)); \
     if (debug) { \
       cout << "c1,c2,c3 = " << c1 << ", " << c2 << ", " << c3 << "    "; \
       cout << "t,i,j = " << t << ", " << i << ", " << j << std::endl; \
     } \
-    if (!one_tile || (c1==one_tile_c1 && c2==one_tile_c2 && c3==one_tile_c3)) {\
-      slices.setFill(t,i,j,tileCoordToColor(c1,c2,c3)); } }
-    
-#define calc_pong(t,i,j) { \
-    if (label) slices.setLabel(t,i,j,tileCoordToString(c1,c2,c3)); \
-    if (debug) { \
-      cout << "c1,c2,c3 = " << c1 << ", " << c2 << ", " << c3 << "    "; \
-      cout << "t,i,j = " << t << ", " << i << ", " << j << std::endl; \
-    } \
-    if (!one_tile || (c1==one_tile_c1 && c2==one_tile_c2 && c3==one_tile_c3)) {\
-      slices.setFill(t,i,j,tileCoordToColor(c1,c2,c3)); } }
+    TracePoint p = {t, i, j, c1, c2, c3, true}; \
+    recording->points.push_back(p); }
+
+#define calc_pong(t,i,j) calc_ping(t,i,j)
 
 // Used for debugging problem with diamond prizms.
 #define calc(t,i,j) { \
-    if (label) slices.setLabel(t,i,j,tileCoordToString(c1,c2,c2)); \
     if (debug) { \
       cout << "c1,c2 = " << c1 << ", " << c2 << "    "; \
       cout << "t,i,j = " << t << ", " << i << ", " << j << std::endl; \
     } \
-    if (!one_tile || (c1==one_tile_c1 && c2==one_tile_c2)) {\
-      slices.setFill(t,i,j,tileCoordToColor(c1,c2,c2)); } }
+    TracePoint p = {t, i, j, c1, c2, c2, false}; \
+    recording->points.push_back(p); }
 
-// Taking the ping and pong out of diamonds.
-#define calc_diamond(kt,k1,k2,t,i,j) { \
-    if (label) slices.setLabel(t,i,j,tileCoordToString(kt,k1,k2)); \
-    if (debug) { \
-      cout << "kt,k1,k2 = " << kt << ", " << k1 << ", " << k2 << "    "; \
-      cout << "t,i,j = " << t << ", " << i << ", " << j << std::endl; \
-    } \
-    if (!one_tile || (kt==one_tile_c1 && k1==one_tile_c2 && k2==one_tile_c3)) {\
-      slices.setFill(t,i,j,tileCoordToColor(kt,k1,k2)); } }
-    
+// Calls f(tiling) with the runtime tiling for the chosen tiling type.
+// Does nothing for the generated .is traversals.
+template <typename F>
+void withRuntimeTiling(F f) {
+    switch (tilingChoice) {
+        case diamonds:
+            // Copied from ICS 2014 paper, see DiamondTiling.hpp.
+            f(DiamondTiling(T, 1, N, 1, N, tau));
+            break;
+        case diamond_prizms:
+            // Same iteration space as the generated prizm code,
+            // 0<i<N-1 and 0<j<N-1.
+            f(PrismTiling(T, 1, N-2, 1, N-2, tau, sigma, height));
+            break;
+        case pipelined:
+            f(PipelinedTiling(T, 1, N-2, 1, N-2, tau, sigma, gamma_size));
+            break;
+        default:
+            break;
+    }
+}
 
+// Outlines the values that the one tile reads from other tiles and
+// prints the footprint of the one tile with ping/pong buffers of doubles.
+template <typename Tiling>
+void markFootprint(CellFieldArray& slices, const Tiling& tiling,
+                   RenderJob& job) {
+    if (!job.footprint || !job.one_tile) { return; }
+    TileCoord tile = {job.one_tile_c1, job.one_tile_c2, job.one_tile_c3};
+    if (tilingChoice==diamond_prizms) { tile.c2 = 0; }
+    forEachHaloPoint(tiling, tile, [&](int t, int i, int j) {
+        if (i>=0 && i<=N && j>=0 && j<=N) {
+            slices.setStroke(t,i,j,"red");
+        }
+    });
+    Footprint fp = tileFootprint(tiling, tile, 2, sizeof(double));
+    std::stringstream ss;
+    ss << "Tile " << tileCoordToString(tile.c0,tile.c1,tile.c2)
+       << ": points = " << fp.points
+       << ", read = " << fp.readBytes << " bytes"
+       << ", write = " << fp.writeBytes << " bytes"
+       << ", footprint = " << fp.totalBytes << " bytes"
+       << ", halo = " << fp.haloBytes << " bytes" << std::endl;
+    job.log += ss.str();
+}
 
-int main(int argc, char ** argv) {
-    // Do command-line parsing.
-    CmdParams *cmdparams = CmdParams_ctor(1);
-    initParams(cmdparams);
-    CmdParams_parseParams(cmdparams,argc,argv);
+// Simulates running the tiling on sim_workers workers where each tile
+// costs its number of points, and records when each tile starts.
+template <typename Tiling>
+void simulateStartTimes(const Tiling& tiling,
+                        StartFractionMap& start_fraction) {
+    if (sim_workers <= 0) { return; }
+    TileGraph graph(tiling);
+    std::vector<double> cost(graph.numTiles()), start;
+    for (int k = 0; k < graph.numTiles(); k++) {
+        cost[k] = (double)tiling.numPoints(graph.tile(k));
+    }
+    ExecutionStats stats = simulateExecution(graph, cost, sim_workers,
+                                             policyChoice, &start);
+    for (int k = 0; k < graph.numTiles(); k++) {
+        const TileCoord& tile = graph.tile(k);
+        start_fraction[std::make_tuple(tile.c0,tile.c1,tile.c2)]
+            = (stats.makespan > 0.0) ? start[k]/stats.makespan : 0.0;
+    }
+    std::cout << "Simulated " << policyStr << " run on " << sim_workers
+              << " workers: makespan = " << stats.makespan
+              << " points, utilization = " << 100.0*stats.utilization
+              << "%" << std::endl;
+}
+
+// Value of key=value in the words of a trace name, or -1 without one.
+int traceNameValue(const std::string& name, const std::string& key) {
+    std::istringstream words(name);
+    std::string word;
+    while (words >> word) {
+        if (word.compare(0, key.size()+1, key + "=") == 0) {
+            return atoi(word.c_str() + key.size() + 1);
+        }
+    }
+    return -1;
+}
+
+// Reads the tiles of traceFile, and checks that the stencil-run that
+// wrote it used the chosen tiling and tile sizes.  The diamonds of
+// slice-viz span 1..N while stencil-run updates 1..N-2 of its grid, so
+// they match a run with N+2.
+bool readTrace(std::vector<TracedTile>& tiles, std::string& error) {
+    std::string name;
+    if (!readTileTrace(traceFile, name, tiles, error)) { return false; }
+    if (name.compare(0, 11, "stencil-run") == 0) {
+        std::string tiling = " " + std::string(tilingStr) + " ";
+        int run_N = (tilingChoice == diamonds) ? N+2 : N;
+        std::stringstream ss;
+        if (name.find(tiling) == std::string::npos) {
+            ss << "the trace is of another tiling than " << tilingStr;
+        } else if (traceNameValue(name, "N") != run_N) {
+            ss << "the trace is of N = " << traceNameValue(name, "N")
+               << ", it matches N = " << run_N << " of stencil-run";
+        } else if (traceNameValue(name, "tau") != tau) {
+            ss << "the trace is of tau = " << traceNameValue(name, "tau");
+        } else if (tilingChoice != diamonds
+                   && traceNameValue(name, "sigma") >= 0
+                   && traceNameValue(name, "sigma") != sigma) {
+            ss << "the trace is of sigma = "
+               << traceNameValue(name, "sigma");
+        } else if (tilingChoice == diamond_prizms
+                   && traceNameValue(name, "height") >= 0
+                   && traceNameValue(name, "height") != height) {
+            ss << "the trace is of height = "
+               << traceNameValue(name, "height");
+        } else if (tilingChoice == pipelined
+                   && traceNameValue(name, "gamma") >= 0
+                   && traceNameValue(name, "gamma") != gamma_size) {
+            ss << "the trace is of gamma = "
+               << traceNameValue(name, "gamma");
+        }
+        if (!ss.str().empty()) {
+            error = ss.str() + " (" + name + ")";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Colors each tile by heatChoice in the traced run, as a fraction from
+// the least to the most over the tiles of the first slab.  Tiles that
+// are not in the trace keep the first color.
+void traceHeat(StartFractionMap& fraction) {
+    if (strcmp(traceFile,"none") == 0) { return; }
+    std::vector<TracedTile> all, tiles;
+    std::string error;
+    if (!readTrace(all, error)) {
+        std::cerr << "Warning: slice-viz: " << error << std::endl;
+        return;
+    }
+    for (size_t k = 0; k < all.size(); k++) {
+        if (all[k].toff == 0) { tiles.push_back(all[k]); }
+    }
+    if (tiles.empty()) {
+        std::cerr << "Warning: slice-viz: " << traceFile
+                  << " has no tiles of the first slab to color by"
+                  << std::endl;
+        return;
+    }
+    if (tiles.size() < all.size()) {
+        std::cerr << "Warning: slice-viz: only coloring the first of the "
+                  << "slabs in " << traceFile << std::endl;
+    }
+    double first = tiles[0].start, last = 0.0, longest = 0.0;
+    int workers = 0;
+    std::vector<double> durations;
+    for (size_t k = 0; k < tiles.size(); k++) {
+        const TracedTile& t = tiles[k];
+        first = min2(first, t.start);
+        last = max2(last, t.start + t.duration);
+        longest = max2(longest, t.duration);
+        workers = max2(workers, t.worker+1);
+        durations.push_back(t.duration);
+    }
+    double span = last - first;
+    for (size_t k = 0; k < tiles.size(); k++) {
+        const TracedTile& t = tiles[k];
+        double value = 0.0;
+        switch (heatChoice) {
+            case heat_start:
+                value = (span > 0.0) ? (t.start-first)/span : 0.0;
+                break;
+            case heat_end:
+                value = (span > 0.0)
+                        ? (t.start+t.duration-first)/span : 0.0;
+                break;
+            case heat_duration:
+                value = (longest > 0.0) ? t.duration/longest : 0.0;
+                break;
+            case heat_worker:
+                value = (workers > 1) ? (double)t.worker/(workers-1) : 0.0;
+                break;
+        }
+        fraction[std::make_tuple(t.tile.c0,t.tile.c1,t.tile.c2)] = value;
+    }
+    std::nth_element(durations.begin(),
+                     durations.begin() + durations.size()/2,
+                     durations.end());
+    std::cout << "Traced run of " << tiles.size() << " tiles on " << workers
+              << " workers: makespan = " << span
+              << " us, longest tile = " << longest
+              << " us, median tile = " << durations[durations.size()/2]
+              << " us, colored by " << heatStr << std::endl;
+}
+
+// Counts the tiles the tiling enumerates and the empty ones, for --stats.
+template <typename Tiling>
+void countTiles(const Tiling& tiling) {
+    if (!phaseStats.enabled()) { return; }
+    long long tiles = 0, empty = 0;
+    for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront(); w++) {
+        tiling.forEachTile(w, [&](const TileCoord& tile) {
+            tiles++;
+            if (tiling.numPoints(tile) == 0) { empty++; }
+        });
+    }
+    phaseStats.countTiles(tiles);
+    phaseStats.countEmptyTiles(empty);
+}
+
+// Counts the points and tiles of a recorded traversal for --stats.  The
+// generated traversals only record the tiles with points.
+void countTraversal(const Traversal& traversal) {
+    if (!phaseStats.enabled()) { return; }
+    phaseStats.countPoints(traversal.points.size());
+    bool runtime = false;
+    withRuntimeTiling([&](const auto& tiling) {
+        countTiles(tiling);
+        runtime = true;
+    });
+    if (runtime) { return; }
+    long long tiles = 0;
+    for (size_t k = 0; k < traversal.points.size(); k++) {
+        const TracePoint& p = traversal.points[k];
+        if (k == 0 || p.c1 != traversal.points[k-1].c1
+                || p.c2 != traversal.points[k-1].c2
+                || p.c3 != traversal.points[k-1].c3) {
+            tiles++;
+        }
+    }
+    phaseStats.countTiles(tiles);
+}
+
+// Records the points of the chosen tiling in traversal order, and the
+// simulated start times if sim_workers is set.
+void recordTraversal(Traversal& traversal) {
+    PhaseTimer timer(phase_traverse);
+    traversal.points.clear();
+    traversal.startFraction.clear();
+    recording = &traversal;
+    withRuntimeTiling([&](const auto& tiling) {
+        simulateStartTimes(tiling, traversal.startFraction);
+    });
+    traceHeat(traversal.startFraction);
+
+    // Have the particular tiling type mark iterations
+    // in each tile.
+    switch (tilingChoice) {
+
+        case pipelined_4x4x4:
+            #include "pipelined-4x4x4.is"
+            break;
+        case diamond_prizms_6x6:
+            #include "diamond-prizms-skew-6x6.is"
+            break;
+        case diamond_prizms_8x8:
+            #include "diamond-prizms-skew-8x8.is"
+            break;
+        case diamond_prizms_12x12:
+            #include "diamond-prizms-skew-12x12.is"
+            break;
+        case diamond_prizms_6x6_noping:
+            #include "diamond-prizms-skew-noping-6x6.is"
+            break;
+        case diamonds:
+        case diamond_prizms:
+        case pipelined:
+            withRuntimeTiling([&](const auto& tiling) {
+                recordPoints(tiling, traversal.points);
+            });
+            for (size_t k = 0; debug && k < traversal.points.size(); k++) {
+                const TracePoint& p = traversal.points[k];
+                cout << "kt,k1,k2 = " << p.c1 << ", " << p.c2 << ", "
+                     << p.c3 << "    ";
+                cout << "t,i,j = " << p.t << ", " << p.i << ", " << p.j
+                     << std::endl;
+            }
+            break;
+
+        default:
+            std::cerr << "ERROR: slice-viz: unknown tiling type" << std::endl;
+    }
+}
+
+// Wall clock time in seconds.
+double wallTime() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Colors the recorded traversal for the job and writes its svg to out,
+// with the footprint of the one tile if the job asks for it.
+void drawSVG(RenderJob& job, const Traversal& traversal, ostream& out) {
+    renderSVG(job, traversal, T, N, tilesHaveTwoDims(), out,
+        [&](CellFieldArray& slices) {
+            withRuntimeTiling([&](const auto& tiling) {
+                markFootprint(slices, tiling, job);
+            });
+        });
+}
+
+//==============================================
+// Render cache on disk, when cache_dir is given.
+
+// Changes whenever the svg drawn from a traversal changes.
+#define SLICE_VIZ_RENDER_VERSION 1
+
+RenderCache* diskCache = NULL;
+
+// The trace file with its size and modification time in ns, so a cached
+// traversal is not used after the trace is rewritten, even within the
+// same second.
+std::string traceIdentity() {
+    struct stat st;
+    std::stringstream ss;
+    ss << "trace=" << traceFile << " heat=" << heatStr;
+    if (stat(traceFile, &st) == 0) {
+        ss << " size=" << st.st_size << " mtime=" << st.st_mtim.tv_sec
+           << "." << st.st_mtim.tv_nsec;
+    }
+    return ss.str();
+}
+
+// Everything the traversal of the global parameters depends on.
+std::string traversalCacheKey() {
+    std::stringstream ss;
+    ss << "slice-viz trace engine=" << TILING_ENGINE_VERSION
+       << " tiling=" << tilingStr << " T=" << T << " N=" << N
+       << " tau=" << tau << " sigma=" << sigma << " gamma=" << gamma_size
+       << " sim_workers=" << sim_workers << " policy=" << policyStr;
+    if (height > 0) { ss << " height=" << height; }
+    if (strcmp(traceFile,"none") != 0) {
+        ss << " " << traceIdentity();
+    }
+    return ss.str();
+}
+
+// Everything the svg of the job depends on, with the traversal of the
+// global parameters.
+std::string svgCacheKey(const RenderJob& job) {
+    std::stringstream ss;
+    ss << traversalCacheKey() << " svg render=" << SLICE_VIZ_RENDER_VERSION
+       << " Tstart=" << job.Tstart << " Tend=" << job.Tend
+       << " grid_spacing=" << job.grid_spacing
+       << " cell_spacing=" << job.cell_spacing
+       << " cell_radius=" << job.cell_radius << " label=" << job.label
+       << " color_incr=" << job.color_incr << " one_tile=" << job.one_tile
+       << " c1=" << job.one_tile_c1 << " c2=" << job.one_tile_c2
+       << " c3=" << job.one_tile_c3 << " footprint=" << job.footprint;
+    return ss.str();
+}
+
+template <typename V>
+void appendRaw(std::string& data, V value) {
+    data.append((const char*)&value, sizeof(value));
+}
+
+template <typename V>
+bool readRaw(const std::string& data, size_t& pos, V& value) {
+    if (pos+sizeof(value) > data.size()) { return false; }
+    memcpy(&value, data.data()+pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+// The points as seven ints each, then the start fractions.
+std::string serializeTraversal(const Traversal& traversal) {
+    std::string data;
+    data.reserve(8 + traversal.points.size()*7*sizeof(int));
+    appendRaw(data, (long long)traversal.points.size());
+    for (size_t k = 0; k < traversal.points.size(); k++) {
+        const TracePoint& p = traversal.points[k];
+        int fields[7] = {p.t, p.i, p.j, p.c1, p.c2, p.c3, p.matchC3};
+        data.append((const char*)fields, sizeof(fields));
+    }
+    appendRaw(data, (long long)traversal.startFraction.size());
+    for (StartFractionMap::const_iterator iter
+             = traversal.startFraction.begin();
+         iter != traversal.startFraction.end(); iter++) {
+        appendRaw(data, std::get<0>(iter->first));
+        appendRaw(data, std::get<1>(iter->first));
+        appendRaw(data, std::get<2>(iter->first));
+        appendRaw(data, iter->second);
+    }
+    return data;
+}
+
+bool deserializeTraversal(const std::string& data, Traversal& traversal) {
+    size_t pos = 0;
+    long long num_points, num_tiles;
+    if (!readRaw(data, pos, num_points) || num_points < 0
+            || (size_t)num_points > data.size()/(7*sizeof(int))) {
+        return false;
+    }
+    traversal.points.resize(num_points);
+    for (long long k = 0; k < num_points; k++) {
+        int fields[7];
+        readRaw(data, pos, fields);
+        TracePoint p = {fields[0], fields[1], fields[2], fields[3],
+                        fields[4], fields[5], fields[6] != 0};
+        traversal.points[k] = p;
+    }
+    traversal.startFraction.clear();
+    if (!readRaw(data, pos, num_tiles)) { return false; }
+    for (long long k = 0; k < num_tiles; k++) {
+        int c1, c2, c3;
+        double fraction;
+        if (!readRaw(data, pos, c1) || !readRaw(data, pos, c2)
+                || !readRaw(data, pos, c3) || !readRaw(data, pos, fraction)) {
+            return false;
+        }
+        traversal.startFraction[std::make_tuple(c1,c2,c3)] = fraction;
+    }
+    return pos == data.size();
+}
+
+// Reads the traversal of the global parameters from the render cache,
+// or records it and stores it there.  Returns whether it was cached.
+bool cachedTraversal(Traversal& traversal) {
+    std::string data;
+    bool cached = diskCache
+        && diskCache->fetch(traversalCacheKey(), "trace", data)
+        && deserializeTraversal(data, traversal);
+    if (!cached) {
+        recordTraversal(traversal);
+        if (diskCache) {
+            diskCache->store(traversalCacheKey(), "trace",
+                             serializeTraversal(traversal));
+        }
+    }
+    countTraversal(traversal);
+    return cached;
+}
+
+// Reads the svg and the log of the job from the render cache.
+bool fetchCachedSVG(RenderJob& job, std::string& svg) {
+    std::string log;
+    std::string key = svgCacheKey(job);
+    if (!diskCache || !diskCache->fetch(key, "svg", svg)
+            || !diskCache->fetch(key, "log", log)) {
+        return false;
+    }
+    job.log += log;
+    return true;
+}
+
+void storeCachedSVG(const RenderJob& job, const std::string& svg) {
+    if (!diskCache) { return; }
+    std::string key = svgCacheKey(job);
+    diskCache->store(key, "svg", svg);
+    diskCache->store(key, "log", job.log);
+}
+
+// Writes the svg file of the job.
+void renderJob(RenderJob& job, const Traversal& traversal) {
+    std::ostringstream svg;
+    drawSVG(job, traversal, svg);
+    {
+        PhaseTimer timer(phase_emit);
+        ofstream file(job.filename.c_str());
+        file << svg.str();
+    }
+    phaseStats.countBytes(svg.str().size());
+    storeCachedSVG(job, svg.str());
+    job.log += "Generating file " + job.filename + "\n";
+}
+
+//==============================================
+// Large scale output, when large_scale is set.
+
+// How the svg or image of the global parameters is produced.
+typedef enum {
+    output_svg,         // record the traversal and fill a CellFieldArray
+    output_stream,      // write a circle per point while traversing
+    output_raster       // a ppm image with a pixel per point
+} output_type;
+
+// Above these many circles an svg is streamed and then rasterized.
+const long long maxBufferedCircles = 100000;
+const long long maxStreamedCircles = 4000000;
+
+bool isRuntimeTiling() {
+    return tilingChoice==diamonds || tilingChoice==diamond_prizms
+           || tilingChoice==pipelined;
+}
+
+// Without large_scale every point of every time step is drawn as an
+// svg circle, so the sizes stay small.
+bool checkSizes(std::string& error) {
+    if (tilingChoice == diamond_prizms && 2*height > tau+sigma) {
+        error = "the height of diamond_prizms is at most (tau+sigma)/2";
+        return false;
+    }
+    if (large_scale) { return true; }
+    if (T > 30 || N > 50 || tau > 30 || sigma > 30 || gamma_size > 30) {
+        error = "T, tau, sigma, and gamma above 30 or N above 50 need "
+                "large_scale (-L 1)";
+        return false;
+    }
+    return true;
+}
+
+// The trace heatmap colors the tiles of a runtime tiling, and reads the
+// trace up front so a bad trace is reported before anything is drawn.
+bool checkTrace(std::string& error) {
+    if (strcmp(traceFile,"none") == 0) { return true; }
+    if (!isRuntimeTiling()) {
+        error = "trace_file needs diamonds, diamond_prizms, or pipelined";
+        return false;
+    }
+    if (sim_workers > 0) {
+        error = "trace_file and sim_workers both color by start times, "
+                "pick one";
+        return false;
+    }
+    std::vector<TracedTile> tiles;
+    return readTrace(tiles, error);
+}
+
+// Picks the output for the global parameters, or returns false with the
+// reason in error.  All sizes are computed in checked 64 bit.
+//   - The svg output records all T*(N+1)^2 points and keeps strings for
+//     each cell of every time step.
+//   - The streamed svg keeps one bit per drawn cell.
+//   - The raster keeps one slice of 3*(N+1)^2 bytes, and traverses
+//     the tiles once per time step it draws.
+// The streamed and raster outputs need a runtime tiling and do not
+// mark footprints.
+bool chooseOutput(output_type& output, std::string& error) {
+    output = output_svg;
+    if (!large_scale) { return true; }
+
+    // The bounds of the runtime tilings are sums of a few multiples of
+    // T, N, and the tile sizes, see DiamondTiling.hpp.  Flattened prisms
+    // scale them by up to tau+sigma, see PrismTiling.hpp.
+    long long extent = checkedAdd64(checkedAdd64(T, N),
+                           checkedAdd64(tau, checkedAdd64(sigma, gamma_size)));
+    if (tilingChoice == diamond_prizms && height > 0) {
+        extent = checkedMul64(extent, checkedAdd64(tau, sigma));
+    }
+    if (!fitsInt(checkedMul64(8, extent))) {
+        error = "T, N, and the tile sizes are too large for int bounds";
+        return false;
+    }
+
+    long long side = (long long)N+1;
+    long long cells = checkedMul64(side, side);
+    long long slices = Tend-Tstart+1;
+    long long circles = checkedMul64(slices, cells);
+    long long budget = checkedMul64(max_memory_mb, 1LL << 20);
+    long long buffered = checkedMul64(checkedMul64(T, cells),
+                                      sizeof(TracePoint)
+                                      + 3*sizeof(std::string));
+    long long canvas = checkedAdd64(checkedMul64(cell_spacing, side),
+                           checkedMul64(slices-1, grid_spacing));
+    if (circles <= maxBufferedCircles && buffered <= budget
+            && fitsInt(canvas)) {
+        return true;
+    }
+
+    std::stringstream ss;
+    if (!isRuntimeTiling()) {
+        ss << tilingStr << " has no runtime tiling to stream, and drawing "
+           << circles << " circles from a recorded traversal needs about "
+           << (buffered >> 20) << " MB";
+    } else if (footprint) {
+        ss << "footprint needs the svg output, which needs about "
+           << (buffered >> 20) << " MB for " << circles << " circles";
+    } else if (circles <= maxStreamedCircles && fitsInt(canvas)) {
+        output = output_stream;
+        return true;
+    } else if (checkedMul64(3, cells) <= budget) {
+        output = output_raster;
+        return true;
+    } else {
+        ss << "a raster slice of " << side << " x " << side
+           << " pixels needs " << (checkedMul64(3, cells) >> 20)
+           << " MB, more than max_memory_mb = " << max_memory_mb;
+    }
+    error = ss.str();
+    return false;
+}
+
+// Calls f(tile, color) for each tile with points in traversal order,
+// with the fill color the svg output would give its points.
+template <typename Tiling, typename F>
+void forEachColoredTile(const Tiling& tiling,
+                        const StartFractionMap& start_fraction, F f) {
+    TileColorer colorer(color_incr, start_fraction, tilesHaveTwoDims());
+    PhaseAccumulator coloring(phase_color);
+    for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront(); w++) {
+        tiling.forEachTile(w, [&](const TileCoord& tile) {
+            if (tiling.numPoints(tile) == 0) { return; }
+            coloring.start();
+            std::string fill = colorer.color(tile.c0, tile.c1, tile.c2);
+            if (one_tile && (tile.c0 != one_tile_c1
+                             || tile.c1 != one_tile_c2
+                             || tile.c2 != one_tile_c3)) {
+                fill = "white";
+            }
+            coloring.stop();
+            f(tile, fill);
+        });
+    }
+}
+
+// Writes the circles of each point while traversing, then the cells no
+// tile visits.  The circles are the same as the svg output's, in a
+// different order.
+template <typename Tiling>
+void streamSVG(const Tiling& tiling, const StartFractionMap& start_fraction,
+               ostream& out) {
+    int slices = Tend-Tstart+1;
+    long long side = N+1;
+    SVGPrinter svg(out, cell_spacing*(N+1) + (slices-1)*grid_spacing,
+                   (N+1)*cell_spacing);
+    svg.printHeader();
+    std::vector<bool> drawn(slices*side*side, false);
+    // The circles of each tile, and then the undrawn cells with the
+    // footer, are each timed as one span of emitting.
+    PhaseAccumulator emitting(phase_emit);
+    auto circle = [&](int t, int i, int j, const std::string& fill,
+                      const std::string& text) {
+        int x = (i+1)*cell_spacing;
+        int y = (t-Tstart)*grid_spacing + (N+1-j)*cell_spacing;
+        svg.printCircle(x, y, cell_radius, "black", fill);
+        svg.printCenteredText(x, y, text);
+        drawn[((t-Tstart)*side + i)*side + j] = true;
+    };
+    forEachColoredTile(tiling, start_fraction,
+        [&](const TileCoord& tile, const std::string& fill) {
+            std::string text = label
+                ? tileCoordToString(tile.c0, tile.c1, tile.c2) : "";
+            emitting.start();
+            tiling.forEachRow(tile, [&](int t, int i, int jlo, int jhi) {
+                if (t < Tstart || t > Tend) { return; }
+                phaseStats.countPoints(jhi-jlo+1);
+                for (int j = jlo; j <= jhi; j++) {
+                    circle(t, i, j, fill, text);
+                }
+            });
+            emitting.stop();
+        });
+    emitting.start();
+    for (int t = Tstart; t <= Tend; t++) {
+        for (int i = 0; i <= N; i++) {
+            for (int j = 0; j <= N; j++) {
+                if (!drawn[((t-Tstart)*side + i)*side + j]) {
+                    circle(t, i, j, "white", "");
+                }
+            }
+        }
+    }
+    svg.printFooter();
+    emitting.stop();
+}
+
+// Packed 0xRRGGBB of a color name or of "rgb(r,g,b)".
+unsigned int fillToRGB(ColorInfo& colors, const std::string& fill) {
+    int r, g, b;
+    if (sscanf(fill.c_str(), "rgb(%d,%d,%d)", &r, &g, &b) == 3) {
+        return (r << 16) | (g << 8) | b;
+    }
+    return colors.getRGB(fill);
+}
+
+// Writes a binary ppm with one pixel per point, the slices from Tstart
+// to Tend stacked like in the svg and separated by white rows.  Only one
+// slice is kept in memory, so the tiles are traversed once per slice.
+template <typename Tiling>
+void rasterPPM(const Tiling& tiling, const StartFractionMap& start_fraction,
+               ostream& out) {
+    ColorInfo colors;
+    int slices = Tend-Tstart+1;
+    long long side = N+1;
+    int gap = 1 + N/32;
+    out << "P6\n" << side << " "
+        << checkedAdd64(checkedMul64(slices, side),
+                        checkedMul64(slices-1, gap)) << "\n255\n";
+    std::vector<unsigned char> pixels(3*side*side);
+    for (int t = Tstart; t <= Tend; t++) {
+        std::fill(pixels.begin(), pixels.end(), 255);
+        forEachColoredTile(tiling, start_fraction,
+            [&](const TileCoord& tile, const std::string& fill) {
+                unsigned int rgb = fillToRGB(colors, fill);
+                tiling.forEachRow(tile, [&](int tt, int i, int jlo, int jhi) {
+                    if (tt != t) { return; }
+                    phaseStats.countPoints(jhi-jlo+1);
+                    for (int j = jlo; j <= jhi; j++) {
+                        // Row N-j and column i, like the svg.
+                        unsigned char* pixel = &pixels[3*((N-j)*side + i)];
+                        pixel[0] = rgb >> 16;
+                        pixel[1] = (rgb >> 8) & 0xff;
+                        pixel[2] = rgb & 0xff;
+                    }
+                });
+            });
+        PhaseTimer timer(phase_emit);
+        out.write((const char*)&pixels[0], pixels.size());
+        if (t < Tend) {
+            std::vector<unsigned char> white(3*side*gap, 255);
+            out.write((const char*)&white[0], white.size());
+        }
+    }
+}
+
+// Writes the streamed svg or the raster of the global parameters.
+void renderLarge(output_type output, const std::string& filename) {
+    ofstream file(filename.c_str(), std::ios::binary);
+    withRuntimeTiling([&](const auto& tiling) {
+        countTiles(tiling);
+        PhaseTimer timer(phase_traverse);
+        StartFractionMap start_fraction;
+        simulateStartTimes(tiling, start_fraction);
+        traceHeat(start_fraction);
+        if (output == output_stream) {
+            streamSVG(tiling, start_fraction, file);
+        } else {
+            rasterPPM(tiling, start_fraction, file);
+        }
+    });
+    phaseStats.countBytes(file.tellp());
+    std::cout << "Generating file " << filename
+              << ((output == output_stream) ? " (streamed svg)" : " (raster)")
+              << std::endl;
+}
+
+// Sets the global parameters from the parsed command line.
+void readParams(CmdParams * cmdparams) {
     tilingChoice = (tiling_type)CmdParams_getValue(cmdparams,'t');
     strncpy(tilingStr, CmdParams_getString(cmdparams,'t'), MAXPOSSVALSTRING);
     T = CmdParams_getValue(cmdparams,'T');
@@ -305,6 +1150,10 @@ int main(int argc, char ** argv) {
     Tend = CmdParams_getValue(cmdparams,'e');
     if (Tend<0) { Tend = T; }  // if Tend not set, then default for Tend is T
     N = CmdParams_getValue(cmdparams,'N');
+    tau = CmdParams_getValue(cmdparams,'a');
+    sigma = CmdParams_getValue(cmdparams,'b');
+    height = CmdParams_getValue(cmdparams,'E');
+    gamma_size = CmdParams_getValue(cmdparams,'G');
     grid_spacing = CmdParams_getValue(cmdparams,'p');
     gridspacingChoice = (gridspacing_type)CmdParams_getValue(cmdparams,'g');
     cell_spacing = CmdParams_getValue(cmdparams,'c');
@@ -316,6 +1165,22 @@ int main(int argc, char ** argv) {
     one_tile_c1 = CmdParams_getValue(cmdparams,'1');
     one_tile_c2 = CmdParams_getValue(cmdparams,'2');
     one_tile_c3 = CmdParams_getValue(cmdparams,'3');
+    footprint = CmdParams_getValue(cmdparams,'f');
+    sim_workers = CmdParams_getValue(cmdparams,'w');
+    policyChoice = (policy_type)CmdParams_getValue(cmdparams,'P');
+    strncpy(policyStr, CmdParams_getString(cmdparams,'P'), MAXPOSSVALSTRING);
+    strncpy(traceFile, CmdParams_getString(cmdparams,'x'), MAXPOSSVALSTRING);
+    heatChoice = (heat_type)CmdParams_getValue(cmdparams,'H');
+    strncpy(heatStr, CmdParams_getString(cmdparams,'H'), MAXPOSSVALSTRING);
+    strncpy(batchFile, CmdParams_getString(cmdparams,'B'), MAXPOSSVALSTRING);
+    num_threads = CmdParams_getValue(cmdparams,'j');
+    strncpy(serverSocket, CmdParams_getString(cmdparams,'S'),
+            MAXPOSSVALSTRING);
+    cache_mb = CmdParams_getValue(cmdparams,'M');
+    strncpy(cacheDir, CmdParams_getString(cmdparams,'C'), MAXPOSSVALSTRING);
+    disk_cache_mb = CmdParams_getValue(cmdparams,'D');
+    large_scale = CmdParams_getValue(cmdparams,'L');
+    max_memory_mb = CmdParams_getValue(cmdparams,'X');
 
     // Compute the spacing between slices.
     if (grid_spacing<0) {
@@ -328,90 +1193,597 @@ int main(int argc, char ** argv) {
                 break;
         }
     }
+}
 
-    // Open the svg file and print the header.
-    std::string filename = create_file_name();
-    ofstream file(filename.c_str());
-        
-    // Specify file and height and width.
-    SVGPrinter svg(file, cell_spacing*(N+1) + ((Tend-Tstart+1)-1)*grid_spacing,
-                         (N+1)*cell_spacing);
-    svg.printHeader();
-    
-    // Declare the array of iteration spaces.
-    CellField::sSpacing = cell_spacing;
-    CellField::sRadius = cell_radius;
-    // FIXME: the N+1 is so we can start our spatial dimensions at 1.
-    // The CellFieldArray handles the fact that T starts at 1, but not
-    // that N starts at 1.
-    CellFieldArray slices(T,N+1,N+1,grid_spacing,Tstart,Tend);
+// The job and traversal parameters of the global parameters.
+RenderJob currentJob() {
+    RenderJob job;
+    job.Tstart = Tstart;
+    job.Tend = Tend;
+    job.grid_spacing = grid_spacing;
+    job.cell_spacing = cell_spacing;
+    job.cell_radius = cell_radius;
+    job.label = label;
+    job.color_incr = color_incr;
+    job.one_tile = one_tile;
+    job.one_tile_c1 = one_tile_c1;
+    job.one_tile_c2 = one_tile_c2;
+    job.one_tile_c3 = one_tile_c3;
+    job.footprint = footprint;
+    job.filename = create_file_name();
+    return job;
+}
 
-    // Have the particular tiling type mark iterations
-    // in each tile.
-    switch (tilingChoice) {
-    
-        case pipelined_4x4x4:
-            #include "pipelined-4x4x4.is"
-            break;
-        case diamonds:
-            {
-            int kt, k1, k2, t, i, j;
-            int Li=1;
-            int Lj=1;
-            int Ui=N;
-            int Uj=N;
-            // Copied from ICS 2014 paper.
-            // Loop over tile wavefronts.
-            for (kt=ceild(3,tau)-3; kt<=floord(3*T,tau); kt++) {
-              // The next two loops iterate within a tile wavefront.
-              int k1_lb = ceild(3*Lj+2+(kt-2)*tau,tau*3);
-              int k1_ub = floord(3*Uj+(kt+2)*tau,tau*3);
-              //Loops over tile coordinates within a parallel tile wavefront.
-              for (k1 = k1_lb; k1 <= k1_ub; k1++) {
-                int k2_lb = floord((2*kt-2)*tau-3*Ui+2,tau*3)-k1;
-                int k2_ub = floord((2+2*kt)*tau-3*Li-2,tau*3)-k1;
-                for (k2 = k2_lb; k2 <= k2_ub; k2++) {
-                  // Loop over time within a tile.
-                  for (t = max(1, floord(kt*tau-1, 3)); 
-                       t < min(T+1, tau + floord(kt*tau, 3)); t++) {
-                    // Loops over the spatial dimensions within each tile.
-                    for (i = max(Li,max((kt-k1-k2)*tau-t, 2*t-(2+k1+k2)*tau+2));
-                         i <= min(Ui,min((1+kt-k1-k2)*tau-t-1, 
-                                         2*t-(k1+k2)*tau)); i++) {
-                      for (j = max(Lj,max(tau*k1-t, t-i-(1+k2)*tau+1));
-                           j <= min(Uj,min((1+k1)*tau-t-1, t-i-k2*tau)); j++) {
-                        calc_diamond(kt,k1,k2,t,i,j);
-                      }
-                    }
-                  }
+TraversalParams currentTraversal() {
+    TraversalParams params = {tilingChoice, tilingStr, T, N, tau, sigma,
+                              height, gamma_size, sim_workers, policyChoice,
+                              policyStr, traceFile, heatChoice, heatStr};
+    return params;
+}
+
+void setTraversal(const TraversalParams& params) {
+    tilingChoice = params.tilingChoice;
+    strncpy(tilingStr, params.tilingStr.c_str(), MAXPOSSVALSTRING);
+    T = params.T;
+    N = params.N;
+    tau = params.tau;
+    sigma = params.sigma;
+    height = params.height;
+    gamma_size = params.gamma_size;
+    sim_workers = params.sim_workers;
+    policyChoice = params.policyChoice;
+    strncpy(policyStr, params.policyStr.c_str(), MAXPOSSVALSTRING);
+    strncpy(traceFile, params.traceFile.c_str(), MAXPOSSVALSTRING);
+    heatChoice = params.heatChoice;
+    strncpy(heatStr, params.heatStr.c_str(), MAXPOSSVALSTRING);
+}
+
+// Jobs that share a traversal.
+struct JobGroup {
+    TraversalParams params;
+    std::vector<RenderJob> jobs;
+};
+
+// Traversal parameters of the global parameters as a map key.
+typedef std::tuple<int,int,int,int,int,int,int,int,int,std::string>
+    TraversalKey;
+TraversalKey currentTraversalKey() {
+    std::string trace;
+    if (strcmp(traceFile,"none") != 0) { trace = traceIdentity(); }
+    return std::make_tuple((int)tilingChoice, T, N, tau, sigma, height,
+                           gamma_size, sim_workers, (int)policyChoice,
+                           trace);
+}
+
+// Sets the global parameters from the command line and then from the
+// words of a batch line or daemon request.  A word is either a flag
+// followed by its value as on the command line, or name=value where name
+// is a parameter name of initParams or a flag letter.  Returns false
+// with the reason in error instead of exiting on a bad parameter.  The
+// batch, daemon, and cache parameters only apply to the whole run and
+// are an error here.
+bool parseRequest(int argc, char ** argv,
+                  const std::vector<std::string>& words, std::string& error) {
+    PhaseTimer timer(phase_parse);
+    CmdParams *cmdparams = CmdParams_ctor(0);
+    initParams(cmdparams);
+    const char* run_flags = "BSjMCD";
+    std::vector<std::string> flags;
+    for (size_t w = 0; w < words.size(); w++) {
+        size_t eq = words[w].find('=');
+        bool is_flag = (words[w][0] == '-' || eq == std::string::npos);
+        std::string name = is_flag ? words[w] : words[w].substr(0, eq);
+        char flag = '\0';
+        if (is_flag) {
+            if (name.size() == 2 && name[0] == '-') { flag = name[1]; }
+        } else {
+            flag = (name.size() == 1) ? name[0]
+                   : CmdParams_flagForName(cmdparams, name.c_str());
+            if (flag == '\0') {
+                error = "unknown parameter " + name;
+                CmdParams_dtor(&cmdparams);
+                return false;
+            }
+        }
+        if (flag != '\0' && strchr(run_flags, flag) != NULL) {
+            error = name + " only applies to the whole run";
+            CmdParams_dtor(&cmdparams);
+            return false;
+        }
+        if (is_flag) {
+            flags.push_back(words[w]);
+        } else {
+            flags.push_back(std::string("-") + flag);
+            flags.push_back(words[w].substr(eq+1));
+        }
+    }
+
+    std::vector<char*> args(1, argv[0]);
+    for (size_t w = 0; w < flags.size(); w++) {
+        args.push_back(&flags[w][0]);
+    }
+    char errstr[256];
+    if (!CmdParams_checkParams(cmdparams, (int)args.size(), &args[0],
+                               errstr, sizeof(errstr))) {
+        error = errstr;
+        CmdParams_dtor(&cmdparams);
+        return false;
+    }
+    args.assign(argv, argv+argc);
+    for (size_t w = 0; w < flags.size(); w++) {
+        args.push_back(&flags[w][0]);
+    }
+    CmdParams_parseParams(cmdparams, (int)args.size(), &args[0]);
+    readParams(cmdparams);
+    CmdParams_dtor(&cmdparams);
+
+    // CellFieldArray asserts these.
+    if (Tstart > Tend || Tend > T) {
+        error = "need Tstart <= Tend <= T";
+        return false;
+    }
+    output_type output;
+    if (!checkSizes(error) || !checkTrace(error)
+            || !chooseOutput(output, error)) {
+        return false;
+    }
+    if (output != output_svg) {
+        error = "streamed and raster output need a single run without -B "
+                "or -S";
+        return false;
+    }
+    return true;
+}
+
+// Splits a line into words, none if it is blank or a # comment.
+std::vector<std::string> splitWords(const std::string& line) {
+    std::istringstream tokens(line);
+    std::vector<std::string> words;
+    std::string word;
+    while (tokens >> word) { words.push_back(word); }
+    if (!words.empty() && words[0][0] == '#') { words.clear(); }
+    return words;
+}
+
+// Reads the batch file, where each line has the command line parameters
+// of one svg file.  Parameters missing from a line come from the
+// command line.  Blank lines and lines starting with # are skipped.
+// Returns false if the file can not be read or has a bad line.
+bool readBatchFile(int argc, char ** argv, std::vector<JobGroup>& groups) {
+    ifstream infile(batchFile);
+    if (!infile.is_open()) {
+        std::cerr << "Error: slice-viz: can not open batch file "
+                  << batchFile << std::endl;
+        return false;
+    }
+    std::map<TraversalKey, int> index;
+    std::set<std::string> filenames;
+    std::string line, error;
+    int line_num = 0;
+    while (std::getline(infile, line)) {
+        line_num++;
+        std::vector<std::string> words = splitWords(line);
+        if (words.empty()) { continue; }
+        if (!parseRequest(argc, argv, words, error)) {
+            std::cerr << "Error: slice-viz: " << batchFile << ":" << line_num
+                      << ": " << error << std::endl;
+            return false;
+        }
+
+        // Two threads must not write the same file.
+        RenderJob job = currentJob();
+        if (!filenames.insert(job.filename).second) {
+            std::cout << "Skipping the second job for " << job.filename
+                      << std::endl;
+            continue;
+        }
+
+        TraversalKey key = currentTraversalKey();
+        if (index.find(key) == index.end()) {
+            index[key] = (int)groups.size();
+            groups.push_back(JobGroup());
+            groups.back().params = currentTraversal();
+        }
+        groups[index[key]].jobs.push_back(job);
+    }
+    return true;
+}
+
+// Latency of the daemon's requests in ms, for those served from the svg
+// cache and for those that were rendered.
+struct LatencyStats {
+    long long count;
+    double total, max;
+
+    void add(double ms) {
+        count++;
+        total += ms;
+        if (ms > max) { max = ms; }
+    }
+    double mean() const { return (count > 0) ? total/count : 0.0; }
+};
+
+template <typename Cache>
+void printCacheStats(std::ostream& out, const char* name, const Cache& cache) {
+    long long lookups = cache.hits() + cache.misses();
+    out << "  \"" << name << "\": {\"hits\": " << cache.hits()
+        << ", \"misses\": " << cache.misses()
+        << ", \"hit_rate\": "
+        << ((lookups > 0) ? (double)cache.hits()/lookups : 0.0)
+        << ", \"entries\": " << cache.size()
+        << ", \"bytes\": " << cache.bytes()
+        << ", \"max_bytes\": " << cache.maxBytes()
+        << ", \"evictions\": " << cache.evictions() << "}," << std::endl;
+}
+
+// Sends all of data, returns false if the client went away.
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data()+sent, data.size()-sent,
+                         MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return false; }
+        sent += n;
+    }
+    return true;
+}
+
+// A client of the daemon with what it sent after its last whole line.
+struct DaemonClient {
+    int fd;
+    std::string buffer;
+    bool closed;            // sent all it will send
+    double last;            // wallTime of its last data
+};
+
+// Limits on the daemon's clients.  A client is dropped when its request
+// line grows past max_request_line, when it is idle or does not read
+// for client_timeout_s, and past max_clients a new one is turned away.
+const size_t max_request_line = 1 << 16;
+const int client_timeout_s = 30;
+const size_t max_clients = 64;
+
+// Runs slice-viz as a daemon on the Unix socket serverSocket.  A client
+// sends one request per line and gets back "OK <bytes> <name>\n"
+// followed by <bytes> bytes, or "ERROR <reason>\n".  A request is
+//   - slice-viz parameters, see parseRequest, answered with the svg,
+//     named by create_file_name,
+//   - "stats", answered with the cache and latency counters as JSON,
+//   - "quit", which stops the daemon.
+// Recorded traversals and rendered svgs are kept in LRU caches of
+// cache_mb megabytes each, so a repeated request is served from the
+// svg cache and a request that only changes how the slices are drawn
+// reuses the traversal.  The clients are polled together and served
+// one request each in turn, so a slow client does not hold up the
+// others.
+bool serve(int argc, char ** argv) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(serverSocket) >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: slice-viz: socket path is too long" << std::endl;
+        return false;
+    }
+    strncpy(addr.sun_path, serverSocket, sizeof(addr.sun_path)-1);
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(serverSocket);
+    if (listen_fd < 0 || bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0
+            || listen(listen_fd, 16) < 0) {
+        std::cerr << "Error: slice-viz: can not listen on " << serverSocket
+                  << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::cout << "Listening on " << serverSocket << std::endl;
+
+    size_t cache_bytes = (size_t)cache_mb << 20;
+    LRUCache<TraversalKey, Traversal> traversals(cache_bytes);
+    LRUCache<std::string, std::string> svgs(cache_bytes);
+    LatencyStats hit_latency = {0, 0.0, 0.0};
+    LatencyStats miss_latency = {0, 0.0, 0.0};
+    long long requests = 0, errors = 0;
+    bool running = true;
+
+    // Answers one request line, returns false if the client went away.
+    auto serveLine = [&](int client, const std::string& request) {
+        std::string line = request;
+        if (!line.empty() && line[line.size()-1] == '\r') {
+            line.erase(line.size()-1);
+        }
+        std::vector<std::string> words = splitWords(line);
+        if (words.empty()) { return true; }
+
+        double start = wallTime();
+        std::string header, body, error;
+        if (words.size() == 1 && words[0] == "quit") {
+            header = "OK 0 quit\n";
+            running = false;
+        } else if (words.size() == 1 && words[0] == "stats") {
+            std::stringstream ss;
+            ss << "{" << std::endl
+               << "  \"requests\": " << requests
+               << ", \"errors\": " << errors << "," << std::endl;
+            printCacheStats(ss, "svg_cache", svgs);
+            printCacheStats(ss, "traversal_cache", traversals);
+            ss << "  \"latency_ms\": {\"hit_count\": "
+               << hit_latency.count << ", \"hit_mean\": "
+               << hit_latency.mean() << ", \"hit_max\": "
+               << hit_latency.max << ", \"miss_count\": "
+               << miss_latency.count << ", \"miss_mean\": "
+               << miss_latency.mean() << ", \"miss_max\": "
+               << miss_latency.max << "}" << std::endl
+               << "}" << std::endl;
+            body = ss.str();
+            header = "OK " + std::to_string(body.size()) + " stats\n";
+        } else if (!parseRequest(argc, argv, words, error)) {
+            requests++;
+            errors++;
+            header = "ERROR " + error + "\n";
+        } else {
+            requests++;
+            RenderJob job = currentJob();
+            // The file name leaves out the trace file and its heat.
+            std::string svg_key = svgCacheKey(job);
+            std::shared_ptr<const std::string> svg = svgs.get(svg_key);
+            bool hit = (bool)svg;
+            std::shared_ptr<std::string> rendered(new std::string);
+            if (!hit && fetchCachedSVG(job, *rendered)) {
+                svgs.put(svg_key, rendered, rendered->size());
+                svg = rendered;
+                std::cout << job.log << "Read " << job.filename
+                          << " from " << cacheDir << std::endl;
+            } else if (!hit) {
+                TraversalKey key = currentTraversalKey();
+                std::shared_ptr<const Traversal> traversal
+                    = traversals.get(key);
+                if (!traversal) {
+                    std::shared_ptr<Traversal> recorded(new Traversal);
+                    cachedTraversal(*recorded);
+                    traversals.put(key, recorded, recorded->bytes());
+                    traversal = recorded;
                 }
-              }
+                std::ostringstream out;
+                drawSVG(job, *traversal, out);
+                *rendered = out.str();
+                storeCachedSVG(job, *rendered);
+                if (diskCache) { diskCache->evict(); }
+                svgs.put(svg_key, rendered, rendered->size());
+                svg = rendered;
+                std::cout << job.log << "Rendered " << job.filename
+                          << std::endl;
             }
+            header = "OK " + std::to_string(svg->size()) + " "
+                     + job.filename + "\n";
+            bool connected = sendAll(client, header)
+                             && sendAll(client, *svg);
+            double ms = 1000.0*(wallTime()-start);
+            if (hit) { hit_latency.add(ms); } else { miss_latency.add(ms); }
+            return connected;
+        }
+        return sendAll(client, header) && sendAll(client, body);
+    };
+
+    std::vector<DaemonClient> clients;
+    while (running) {
+        // Clients with a whole line left are served without waiting.
+        bool pending = false;
+        std::vector<pollfd> fds(1);
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+        for (size_t c = 0; c < clients.size(); c++) {
+            pollfd p = {clients[c].fd, POLLIN, 0};
+            fds.push_back(p);
+            if (clients[c].buffer.find('\n') != std::string::npos) {
+                pending = true;
             }
+        }
+        if (poll(&fds[0], fds.size(), pending ? 0 : 1000) < 0) {
+            if (errno == EINTR) { continue; }
+            std::cerr << "Error: slice-viz: poll: " << strerror(errno)
+                      << std::endl;
             break;
-        case diamond_prizms_6x6:
-            #include "diamond-prizms-skew-6x6.is"
-            break;
-        case diamond_prizms_8x8:
-            #include "diamond-prizms-skew-8x8.is"
-            break;
-        case diamond_prizms_12x12:
-            #include "diamond-prizms-skew-12x12.is"
-            break;
-        case diamond_prizms_6x6_noping:
-            #include "diamond-prizms-skew-noping-6x6.is"
-            break;
+        }
 
-        default:
-            std::cerr << "ERROR: slice-viz: unknown tiling type" << std::endl;
-    }  
+        double now = wallTime();
+        for (size_t c = 0; c < clients.size() && running; c++) {
+            DaemonClient& client = clients[c];
+            bool connected = true;
+            if (fds[c+1].revents != 0 && !client.closed) {
+                char chunk[4096];
+                ssize_t n = recv(client.fd, chunk, sizeof(chunk), 0);
+                if (n > 0) {
+                    client.buffer.append(chunk, n);
+                    client.last = now;
+                } else if (n == 0) {
+                    client.closed = true;
+                } else if (errno != EINTR && errno != EAGAIN) {
+                    connected = false;
+                }
+            }
+            size_t end = client.buffer.find('\n');
+            if (end != std::string::npos) {
+                std::string line = client.buffer.substr(0, end);
+                client.buffer.erase(0, end+1);
+                connected = connected && serveLine(client.fd, line);
+                client.last = wallTime();
+            } else if (client.buffer.size() > max_request_line) {
+                sendAll(client.fd, "ERROR request line is too long\n");
+                connected = false;
+            } else if (client.closed
+                       || now-client.last > client_timeout_s) {
+                connected = false;
+            }
+            if (!connected) {
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+        size_t kept = 0;
+        for (size_t c = 0; c < clients.size(); c++) {
+            if (clients[c].fd >= 0) { clients[kept++] = clients[c]; }
+        }
+        clients.resize(kept);
 
-    // Print the array of iteration slices out to the file.
-    slices.printToSVG(svg,Tstart,Tend);
-    std::cout << "Generating file " << filename << std::endl;
-    
-    // End of the file.
-    svg.printFooter();
+        if (running && (fds[0].revents & POLLIN)) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd < 0) {
+                if (errno == EINTR) { continue; }
+                std::cerr << "Error: slice-viz: accept: " << strerror(errno)
+                          << std::endl;
+                break;
+            }
+            if (clients.size() >= max_clients) {
+                sendAll(fd, "ERROR too many clients\n");
+                close(fd);
+                continue;
+            }
+            // recv only follows poll, the timeouts keep a stalled
+            // client from blocking the daemon in send.
+            timeval timeout = {client_timeout_s, 0};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                       sizeof(timeout));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                       sizeof(timeout));
+            DaemonClient client = {fd, "", false, now};
+            clients.push_back(client);
+        }
+    }
+    for (size_t c = 0; c < clients.size(); c++) {
+        close(clients[c].fd);
+    }
+    close(listen_fd);
+    unlink(serverSocket);
+    return true;
+}
+
+int main(int argc, char ** argv) {
+    StatsReport stats(argc, argv, "slice-viz");
+
+    // Do command-line parsing.
+    CmdParams *cmdparams = CmdParams_ctor(1);
+    {
+        PhaseTimer timer(phase_parse);
+        initParams(cmdparams);
+        CmdParams_parseParams(cmdparams,argc,argv);
+        readParams(cmdparams);
+    }
+
+    RenderCache* cache = NULL;
+    if (strcmp(cacheDir,"none") != 0) {
+        cache = new RenderCache(cacheDir, (size_t)disk_cache_mb << 20);
+        if (!cache->ok()) { return 1; }
+        diskCache = cache;
+    }
+
+    if (strcmp(serverSocket,"none") != 0) {
+        bool served = serve(argc, argv);
+        delete cache;
+        return served ? 0 : 1;
+    }
+
+    std::vector<JobGroup> groups;
+    bool batch = strcmp(batchFile,"none") != 0;
+    if (batch) {
+        if (!readBatchFile(argc, argv, groups)) { return 1; }
+    } else {
+        std::string error;
+        output_type output;
+        if (!checkSizes(error) || !checkTrace(error)
+                || !chooseOutput(output, error)) {
+            std::cerr << "Error: slice-viz: " << error << std::endl;
+            return 1;
+        }
+        if (output == output_raster) {
+            std::string filename = create_file_name();
+            filename.replace(filename.size()-4, 4, ".ppm");
+            renderLarge(output, filename);
+            return 0;
+        } else if (output == output_stream) {
+            renderLarge(output, create_file_name());
+            return 0;
+        }
+        groups.push_back(JobGroup());
+        groups.back().params = currentTraversal();
+        groups.back().jobs.push_back(currentJob());
+    }
+
+    // Each group is traversed once and then its jobs are rendered, each
+    // thread taking the next job that is left.
+    int workers = num_threads;
+    if (workers <= 0) { workers = (int)std::thread::hardware_concurrency(); }
+    if (workers <= 0) { workers = 1; }
+    int num_jobs = 0, num_traversals = 0, svg_hits = 0, trace_hits = 0;
+    double traverse_time = 0.0, render_time = 0.0;
+    for (size_t g = 0; g < groups.size(); g++) {
+        std::vector<RenderJob>& jobs = groups[g].jobs;
+        num_jobs += (int)jobs.size();
+        setTraversal(groups[g].params);
+
+        // Cached svg files are copied without traversing or rendering.
+        std::vector<int> todo;
+        for (size_t k = 0; k < jobs.size(); k++) {
+            std::string svg;
+            if (fetchCachedSVG(jobs[k], svg)) {
+                PhaseTimer timer(phase_emit);
+                writeFileAtomic(jobs[k].filename, svg);
+                phaseStats.countBytes(svg.size());
+                jobs[k].log += "Generating file " + jobs[k].filename
+                               + " from " + cacheDir + "\n";
+                svg_hits++;
+            } else {
+                todo.push_back((int)k);
+            }
+        }
+        if (todo.empty()) {
+            for (size_t k = 0; k < jobs.size(); k++) {
+                std::cout << jobs[k].log;
+            }
+            continue;
+        }
+
+        double start = wallTime();
+        Traversal traversal;
+        if (cachedTraversal(traversal)) { trace_hits++; }
+        num_traversals++;
+        traverse_time += wallTime()-start;
+
+        start = wallTime();
+        std::atomic<int> next(0);
+        auto work = [&]() {
+            int k;
+            while ((k = next.fetch_add(1)) < (int)todo.size()) {
+                renderJob(jobs[todo[k]], traversal);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int w = 1; w < workers && w < (int)todo.size(); w++) {
+            threads.push_back(std::thread(work));
+        }
+        work();
+        for (size_t w = 0; w < threads.size(); w++) {
+            threads[w].join();
+        }
+        render_time += wallTime()-start;
+
+        for (size_t k = 0; k < jobs.size(); k++) {
+            std::cout << jobs[k].log;
+        }
+    }
+
+    if (batch) {
+        std::cout << "Batch: " << num_jobs << " files from "
+                  << num_traversals << " traversals, traversal time = "
+                  << traverse_time << " s, render time = " << render_time
+                  << " s on " << workers << " threads" << std::endl;
+    }
+    if (cache) {
+        cache->evict();
+        std::cout << "Cache " << cacheDir << ": " << svg_hits << " of "
+                  << num_jobs << " files and " << trace_hits << " of "
+                  << num_traversals << " traversals were cached, "
+                  << cache->evictions() << " evicted" << std::endl;
+        delete cache;
+    }
 
     return 0;
 }
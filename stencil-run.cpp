@@ -0,0 +1,694 @@
+/*!
+ * \file stencil-run.cpp
+ *
+ * \brief Driver for executing the Jacobi 2D stencil with the tilings
+ *        that slice-viz visualizes.
+ *
+ * Runs the stencil from facts.piscc over double buffered grids using
+ * the requested traversal, and checks the result against the naive
+ * untiled sweep.  With -H 1 the hardware counters of every thread are
+ * read around each tile wavefront of the serial and wavefront modes, see
+ * HwCounters.hpp, and the misses per point are reported next to the
+ * footprint of the largest tile.  With -x file the tiles of the last
+ * repetition are written as a Chrome trace, see TileTrace.hpp.  To see
+ * how to run, type "./stencil-run --help".
+ */
+#include "Jacobi2D.hpp"
+#include "DiamondTiling.hpp"
+#include "PrismTiling.hpp"
+#include "PipelinedTiling.hpp"
+#include "TileGraph.hpp"
+#include "TileScheduler.hpp"
+#include "TileSpace.hpp"
+#include "Autotuner.hpp"
+#include "TileFootprint.hpp"
+#include "CacheSizes.hpp"
+#include "HwCounters.hpp"
+#include "TileTrace.hpp"
+#include "CmdParams.h"
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <assert.h>
+#include <chrono>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//==============================================
+// Global parameters with their default values.
+int T = 100;
+int N = 1000;
+int tau = 15;
+int sigma = 15;
+int height = 0;
+int gamma_size = 15;
+int slab = 0;
+int num_threads = 0;
+int num_reps = 1;
+bool check = true;
+bool hw_counters = false;
+char cacheFile[MAXPOSSVALSTRING];
+char traceFile[MAXPOSSVALSTRING];
+kernel_type kernelChoice = kernel_auto;
+#define num_KPairs 4
+static EnumStringPair KPairs[] = {{kernel_auto,"auto"},
+                                  {kernel_scalar,"scalar"},
+                                  {kernel_avx2,"avx2"},
+                                  {kernel_avx512,"avx512"}
+                                 };
+
+typedef enum {
+    naive,
+    serial,
+    wavefront,
+    wavefront_static,
+    workstealing,
+    replay,
+    autotune
+} mode_type;
+mode_type modeChoice = wavefront;
+char modeStr[MAXPOSSVALSTRING];
+#define num_MPairs 7
+static EnumStringPair MPairs[] = {{naive,"naive"},
+                                  {serial,"serial"},
+                                  {wavefront,"wavefront"},
+                                  {wavefront_static,"static"},
+                                  {workstealing,"workstealing"},
+                                  {replay,"replay"},
+                                  {autotune,"autotune"}
+                                 };
+
+typedef enum {
+    diamonds,
+    diamond_prizms,
+    pipelined
+} tiling_type;
+tiling_type tilingChoice = diamonds;
+char tilingStr[MAXPOSSVALSTRING];
+#define num_TPairs 3
+static EnumStringPair TPairs[] = {{diamonds,"diamonds"},
+                                  {diamond_prizms,"diamond_prizms"},
+                                  {pipelined,"pipelined"}
+                                 };
+
+// Tile graph and scheduler for workstealing and replay modes.
+TileGraph *graph = NULL;
+TileScheduler *scheduler = NULL;
+
+// Timeline of the tiles when there is a trace file.
+TileTrace *trace = NULL;
+
+//==============================================
+
+void initParams(CmdParams * cmdparams)
+/*--------------------------------------------------------------*//*!
+  Uses a CmdParams object to describe all of the command line
+  parameters.
+*//*--------------------------------------------------------------*/
+{
+    CmdParams_describeEnumParam(cmdparams, "mode", 'm', 1,
+            "how to execute the stencil, static is wavefront over only "
+            "the non-empty tiles with static scheduling, replay only runs "
+            "the workstealing schedule without computing, autotune searches "
+            "for the best diamond tau, slab, and threads",
+            MPairs, num_MPairs, wavefront);
+
+    CmdParams_describeEnumParam(cmdparams, "tiling", 'y', 1,
+            "tiling for the serial, wavefront, static, and workstealing "
+            "modes",
+            TPairs, num_TPairs, diamonds);
+
+    CmdParams_describeNumParam(cmdparams,"numTimeSteps", 'T', 1,
+            "number of time steps",
+            1, 100000, 100);
+
+    CmdParams_describeNumParam(cmdparams,"spatialDim", 'N', 1,
+            "2D data will be NxN, including the fixed edges",
+            3, 100000, 1000);
+
+    CmdParams_describeNumParam(cmdparams,"tau", 't', 1,
+            "tile size for diamonds, along t+i for diamond_prizms, "
+            "and along t for pipelined (tau)",
+            1, 10000, 15);
+
+    CmdParams_describeNumParam(cmdparams,"sigma", 'b', 1,
+            "tile size along t-i for diamond_prizms "
+            "and along t+i for pipelined (sigma)",
+            2, 10000, 15);
+
+    CmdParams_describeNumParam(cmdparams,"height", 'E', 1,
+            "time steps a diamond_prizms tile spans, at most "
+            "(tau+sigma)/2, or 0 for (tau+sigma)/2",
+            0, 10000, 0);
+
+    CmdParams_describeNumParam(cmdparams,"gamma", 'G', 1,
+            "tile size along t+j for pipelined (gamma)",
+            2, 10000, 15);
+
+    CmdParams_describeNumParam(cmdparams,"slab", 'u', 1,
+            "number of time steps per slab in the serial, wavefront, and "
+            "static modes, 0 means no slabs",
+            0, 100000, 0);
+
+    CmdParams_describeEnumParam(cmdparams, "kernel", 'k', 1,
+            "row kernel for the stencil, auto picks the widest supported",
+            KPairs, num_KPairs, kernel_auto);
+
+    CmdParams_describeNumParam(cmdparams,"threads", 'p', 1,
+            "number of threads, 0 means use the OpenMP default",
+            0, 1024, 0);
+
+    CmdParams_describeNumParam(cmdparams,"reps", 'r', 1,
+            "number of repetitions, best time is reported",
+            1, 1000, 1);
+
+    CmdParams_describeNumParam(cmdparams,"check", 'c', 1,
+            "whether to check the result against the naive sweep",
+            0, 1, 1);
+
+    CmdParams_describeNumParam(cmdparams,"counters", 'H', 1,
+            "whether to read the hardware counters around each wavefront "
+            "of the serial and wavefront modes, falls back to timing each "
+            "wavefront if there are no counters",
+            0, 1, 0);
+
+    CmdParams_describeStringParam(cmdparams,"cache_file", 'f', 1,
+            "file where autotune results are cached",
+            "stencil-autotune.cache");
+
+    CmdParams_describeStringParam(cmdparams,"trace", 'x', 1,
+            "Chrome trace-event JSON file for the tiles of the last "
+            "repetition of the serial, wavefront, static, or workstealing "
+            "mode, none for no trace",
+            "none");
+}
+
+// Wall clock time in seconds.
+double wallTime() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//==============================================
+// Hardware counters around each wavefront, for -H 1.
+
+// Counters of each OpenMP thread.  A thread opens its own so that they
+// count its work, and the master thread reads all of them between
+// wavefronts when the other threads wait.
+std::vector<HwCounters*> threadCounters;
+
+void openThreadCounters() {
+    threadCounters.assign(num_threads, (HwCounters*)NULL);
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(num_threads)
+    {
+        threadCounters[omp_get_thread_num()] = new HwCounters();
+    }
+#else
+    threadCounters[0] = new HwCounters();
+#endif
+}
+
+void readThreadCounters(HwSample& sum) {
+    sum.clear();
+    HwSample sample;
+    for (size_t k = 0; k < threadCounters.size(); k++) {
+        threadCounters[k]->read(sample);
+        for (int c = 0; c < num_hw_counters; c++) {
+            sum.value[c] += sample.value[c];
+        }
+    }
+}
+
+// What one wavefront did, summed over the slabs and reps.
+struct WavefrontCounts {
+    long long tiles, points;
+    double seconds;
+    HwSample counts;
+};
+std::vector<WavefrontCounts> wavefrontCounts;
+
+// Same as Jacobi2D::runWavefront, or runSerial if not parallel, with the
+// counters read around each wavefront.
+template <typename Tiling>
+void runCounted(Jacobi2D& grid, const Tiling& tiling, bool parallel,
+                int toff) {
+    std::vector<TileCoord> tiles;
+    int first = tiling.firstWavefront();
+    for (int w = first; w <= tiling.lastWavefront(); w++) {
+        if ((int)wavefrontCounts.size() <= w-first) {
+            WavefrontCounts empty = {0, 0, 0.0, HwSample()};
+            empty.counts.clear();
+            wavefrontCounts.resize(w-first+1, empty);
+        }
+        WavefrontCounts& wc = wavefrontCounts[w-first];
+        tiles.clear();
+        tiling.forEachTile(w, [&](const TileCoord& tile) {
+            tiles.push_back(tile);
+            wc.points += tiling.numPoints(tile);
+        });
+        int num_tiles = (int)tiles.size();
+        wc.tiles += num_tiles;
+
+        HwSample before, after;
+        readThreadCounters(before);
+        double start = wallTime();
+        if (parallel) {
+            #pragma omp parallel
+            {
+                int worker = Jacobi2D::threadNum();
+                #pragma omp for schedule(dynamic)
+                for (int k = 0; k < num_tiles; k++) {
+                    grid.runTile(tiling, tiles[k], toff, worker);
+                }
+            }
+        } else {
+            for (int k = 0; k < num_tiles; k++) {
+                grid.runTile(tiling, tiles[k], toff, 0);
+            }
+        }
+        wc.seconds += wallTime() - start;
+        readThreadCounters(after);
+        wc.counts.add(after, before);
+    }
+}
+
+// Prints the counters of each wavefront and the totals per point, and
+// the misses a tile would have if its footprint stays in a cache level
+// and every line it touches is missed once.
+template <typename Tiling>
+void reportCounters(const Tiling& tiling) {
+    HwCounters& counters = *threadCounters[0];
+    if (counters.ok()) {
+        std::cout << "counters = perf_event_open, threads = "
+                  << threadCounters.size() << std::endl;
+    } else {
+        std::cout << "counters unavailable (" << counters.error()
+                  << "), only timing each wavefront" << std::endl;
+    }
+    std::cout << "wavefront,tiles,points,seconds";
+    for (int c = 0; c < num_hw_counters; c++) {
+        if (counters.has(c)) { std::cout << "," << hwCounterName(c); }
+    }
+    std::cout << std::endl;
+
+    WavefrontCounts total = {0, 0, 0.0, HwSample()};
+    total.counts.clear();
+    for (size_t k = 0; k < wavefrontCounts.size(); k++) {
+        const WavefrontCounts& wc = wavefrontCounts[k];
+        std::cout << tiling.firstWavefront()+(int)k << "," << wc.tiles << ","
+                  << wc.points << "," << wc.seconds;
+        for (int c = 0; c < num_hw_counters; c++) {
+            if (counters.has(c)) { std::cout << "," << wc.counts.value[c]; }
+            total.counts.value[c] += wc.counts.value[c];
+        }
+        std::cout << std::endl;
+        total.points += wc.points;
+        total.seconds += wc.seconds;
+    }
+
+    std::cout << "per point: ns = " << 1e9*total.seconds/total.points;
+    for (int c = 0; c < num_hw_counters; c++) {
+        if (counters.has(c)) {
+            std::cout << ", " << hwCounterName(c) << " = "
+                      << (double)total.counts.value[c]/total.points;
+        }
+    }
+    if (counters.has(hw_cycles) && counters.has(hw_instructions)
+            && total.counts.value[hw_cycles] > 0) {
+        std::cout << ", IPC = " << (double)total.counts.value[hw_instructions]
+                                   /total.counts.value[hw_cycles];
+    }
+    std::cout << std::endl;
+
+    TileCoord tile = largestTile(tiling);
+    Footprint fp = tileFootprint(tiling, tile, 2, sizeof(double));
+    std::cout << "largest tile (" << tile.c0 << "," << tile.c1 << ","
+              << tile.c2 << "): points = " << fp.points << ", footprint = "
+              << fp.totalBytes << " bytes" << std::endl;
+    static const char* levelNames[NUM_CACHE_LEVELS] = {"L1", "L2", "L3"};
+    CacheLevel levels[NUM_CACHE_LEVELS];
+    detectCacheSizes(levels);
+    for (int l = 0; l < NUM_CACHE_LEVELS; l++) {
+        std::cout << levelNames[l] << " = ";
+        if (levels[l].size <= 0) {
+            std::cout << "unknown" << std::endl;
+            continue;
+        }
+        int line = (levels[l].lineSize > 0) ? levels[l].lineSize : 64;
+        std::cout << levels[l].size << " bytes, tile "
+                  << (fp.totalBytes <= levels[l].size ? "fits" : "does not fit")
+                  << ", predicted misses per point >= "
+                  << (double)fp.totalBytes/line/imax(fp.points, 1);
+        if (l == 0 && counters.has(hw_l1d_misses)) {
+            std::cout << ", measured l1d_misses per point = "
+                      << (double)total.counts.value[hw_l1d_misses]
+                         /total.points;
+        }
+        if (l == NUM_CACHE_LEVELS-1 && counters.has(hw_llc_misses)) {
+            std::cout << ", measured llc_misses per point = "
+                      << (double)total.counts.value[hw_llc_misses]
+                         /total.points;
+        }
+        std::cout << std::endl;
+    }
+}
+
+//==============================================
+
+// Runs T time steps with Jacobi2D::runStatic.  The tile space of a
+// full slab is built once and reused for every slab, and the last slab
+// gets its own if it is shorter.
+template <typename MakeTiling>
+void runStaticSlabs(Jacobi2D& grid, MakeTiling make_tiling) {
+    typedef TileSpace<decltype(make_tiling(T))> Space;
+    int Ts = (slab>0 && slab<T) ? slab : T;
+    Space full(make_tiling(Ts));
+    int toff = 0;
+    for (; toff+Ts <= T; toff += Ts) {
+        grid.runStatic(full, toff);
+    }
+    if (toff < T) {
+        grid.runStatic(Space(make_tiling(T-toff)), toff);
+    }
+}
+
+// Runs the stencil for the given mode into grid and returns the time.
+// make_tiling(Ts) returns the chosen tiling for Ts time steps.
+template <typename MakeTiling>
+double runMode(mode_type mode, Jacobi2D& grid, MakeTiling make_tiling) {
+    grid.init(1);
+    if (trace) { trace->clear(); }
+    double start = wallTime();
+    switch (mode) {
+        case naive:
+            grid.runNaive(T);
+            break;
+        case serial:
+        case wavefront:
+            if (hw_counters) {
+                int Ts = (slab>0 && slab<T) ? slab : T;
+                for (int toff = 0; toff < T; toff += Ts) {
+                    runCounted(grid, make_tiling(imin(Ts, T-toff)),
+                               mode==wavefront, toff);
+                }
+            } else if (slab>0) {
+                grid.runSlabs(T, slab, mode==wavefront, make_tiling);
+            } else if (mode==wavefront) {
+                grid.runWavefront(make_tiling(T));
+            } else {
+                grid.runSerial(make_tiling(T));
+            }
+            break;
+        case wavefront_static:
+            runStaticSlabs(grid, make_tiling);
+            break;
+        case workstealing:
+            {
+            auto tiling = make_tiling(T);
+            scheduler->run([&](int k, int worker) {
+                grid.runTile(tiling, graph->tile(k), 0, worker);
+            });
+            }
+            break;
+        case replay:
+            scheduler->run([](int, int) {});
+            break;
+        case autotune:
+            // main() tunes without running a mode.
+            assert(false);
+            break;
+    }
+    return wallTime() - start;
+}
+
+// Runs the mode num_reps times with the chosen tiling and returns the
+// best time.
+double bestTime(mode_type mode, Jacobi2D& grid) {
+    int L = grid.lower(), U = grid.upper();
+    auto make_diamond = [&](int Ts) {
+        return DiamondTiling(Ts, L, U, L, U, tau);
+    };
+    auto make_prism = [&](int Ts) {
+        return PrismTiling(Ts, L, U, L, U, tau, sigma, height);
+    };
+    auto make_pipe = [&](int Ts) {
+        return PipelinedTiling(Ts, L, U, L, U, tau, sigma, gamma_size);
+    };
+
+    double best = -1.0;
+    for (int r = 0; r < num_reps; r++) {
+        double time = 0.0;
+        switch (tilingChoice) {
+            case diamonds:
+                time = runMode(mode, grid, make_diamond);
+                break;
+            case diamond_prizms:
+                time = runMode(mode, grid, make_prism);
+                break;
+            case pipelined:
+                time = runMode(mode, grid, make_pipe);
+                break;
+        }
+        if (best < 0 || time < best) { best = time; }
+    }
+    return best;
+}
+
+// Calls f(tiling) with the chosen tiling for Ts time steps over the
+// interior of the grid.
+template <typename F>
+void withTiling(int Ts, F f) {
+    switch (tilingChoice) {
+        case diamonds:
+            f(DiamondTiling(Ts, 1, N-2, 1, N-2, tau));
+            break;
+        case diamond_prizms:
+            f(PrismTiling(Ts, 1, N-2, 1, N-2, tau, sigma, height));
+            break;
+        case pipelined:
+            f(PipelinedTiling(Ts, 1, N-2, 1, N-2, tau, sigma, gamma_size));
+            break;
+    }
+}
+
+// Time steps per slab of the chosen mode.
+int slabSteps() {
+    return (slab>0 && slab<T && modeChoice!=workstealing) ? slab : T;
+}
+
+// Number of tiles with points the chosen tiling runs in one run, which
+// is the number of events in a trace.
+long long numRunTiles() {
+    long long tiles = 0;
+    for (int toff = 0; toff < T; toff += slabSteps()) {
+        withTiling(imin(slabSteps(), T-toff), [&](const auto& tiling) {
+            for (int w = tiling.firstWavefront();
+                 w <= tiling.lastWavefront(); w++) {
+                tiling.forEachTile(w, [&](const TileCoord& tile) {
+                    if (tiling.numPoints(tile) > 0) { tiles++; }
+                });
+            }
+        });
+    }
+    return tiles;
+}
+
+// Sets the points of the traced tiles once the runs are done.
+void countTracePoints() {
+    for (int toff = 0; toff < T; toff += slabSteps()) {
+        withTiling(imin(slabSteps(), T-toff), [&](const auto& tiling) {
+            trace->countPoints(tiling, toff);
+        });
+    }
+}
+
+// Builds the tile graph for the chosen tiling.
+TileGraph* buildGraph() {
+    switch (tilingChoice) {
+        case diamond_prizms:
+            return new TileGraph(PrismTiling(T, 1, N-2, 1, N-2,
+                                             tau, sigma, height));
+        case pipelined:
+            return new TileGraph(PipelinedTiling(T, 1, N-2, 1, N-2,
+                                                 tau, sigma, gamma_size));
+        default:
+            return new TileGraph(DiamondTiling(T, 1, N-2, 1, N-2, tau));
+    }
+}
+
+int main(int argc, char ** argv) {
+    // Do command-line parsing.
+    CmdParams *cmdparams = CmdParams_ctor(1);
+    initParams(cmdparams);
+    CmdParams_parseParams(cmdparams,argc,argv);
+    modeChoice = (mode_type)CmdParams_getValue(cmdparams,'m');
+    strncpy(modeStr, CmdParams_getString(cmdparams,'m'), MAXPOSSVALSTRING);
+    T = CmdParams_getValue(cmdparams,'T');
+    N = CmdParams_getValue(cmdparams,'N');
+    tilingChoice = (tiling_type)CmdParams_getValue(cmdparams,'y');
+    strncpy(tilingStr, CmdParams_getString(cmdparams,'y'), MAXPOSSVALSTRING);
+    tau = CmdParams_getValue(cmdparams,'t');
+    sigma = CmdParams_getValue(cmdparams,'b');
+    height = CmdParams_getValue(cmdparams,'E');
+    gamma_size = CmdParams_getValue(cmdparams,'G');
+    slab = CmdParams_getValue(cmdparams,'u');
+    num_threads = CmdParams_getValue(cmdparams,'p');
+    num_reps = CmdParams_getValue(cmdparams,'r');
+    check = CmdParams_getValue(cmdparams,'c');
+    kernelChoice = (kernel_type)CmdParams_getValue(cmdparams,'k');
+    strncpy(cacheFile, CmdParams_getString(cmdparams,'f'), MAXPOSSVALSTRING);
+    strncpy(traceFile, CmdParams_getString(cmdparams,'x'), MAXPOSSVALSTRING);
+    hw_counters = CmdParams_getValue(cmdparams,'H');
+    if (strcmp(traceFile,"none")!=0 && modeChoice!=serial
+            && modeChoice!=wavefront && modeChoice!=wavefront_static
+            && modeChoice!=workstealing) {
+        std::cerr << "Error: stencil-run: a trace needs the serial, "
+                  << "wavefront, static, or workstealing mode" << std::endl;
+        return 1;
+    }
+    if (tilingChoice==diamond_prizms && 2*height > tau+sigma) {
+        std::cerr << "Error: stencil-run: the height of diamond_prizms is "
+                  << "at most (tau+sigma)/2" << std::endl;
+        return 1;
+    }
+    if (hw_counters && modeChoice!=serial && modeChoice!=wavefront) {
+        std::cerr << "Error: stencil-run: counters need the serial or "
+                  << "wavefront mode" << std::endl;
+        return 1;
+    }
+
+#ifdef _OPENMP
+    if (num_threads>0) { omp_set_num_threads(num_threads); }
+    num_threads = omp_get_max_threads();
+#else
+    num_threads = 1;
+#endif
+
+    if (modeChoice==autotune) {
+        Autotuner tuner(N, T, num_threads, num_reps);
+        TuneConfig best = tuner.tune(cacheFile);
+        std::cout << "best: tau = " << best.tau << ", slab = " << best.slab
+                  << ", threads = " << best.threads << ", time = "
+                  << best.time << " s, cores = " << tuner.cores()
+                  << std::endl;
+        std::cout << "run with: ./stencil-run -m wavefront -N " << N
+                  << " -T " << T << " -t " << best.tau << " -u " << best.slab
+                  << " -p " << best.threads << std::endl;
+
+        // diamond-slice-viz can only draw small grids, so clamp the
+        // sizes to its parameter ranges.
+        int viz_T = (T < 30) ? T : 30;
+        int viz_slab = (best.slab > 0 && best.slab < viz_T) ? best.slab
+                                                           : viz_T;
+        int viz_N = (N < 75) ? N : 75;
+        int viz_tau = (best.tau < 129) ? best.tau : 129;
+        std::cout << "visualize with: ./diamond-slice-viz -t " << viz_tau
+                  << " -u " << viz_slab << " -T " << viz_T
+                  << " -N " << viz_N << std::endl;
+        int tuned_slab = (best.slab > 0 && best.slab < T) ? best.slab : T;
+        if (viz_T != T || viz_N != N || viz_tau != best.tau
+                || viz_slab != tuned_slab) {
+            std::cout << "note: the visualized parameters are clamped to "
+                      << "what diamond-slice-viz draws and differ from "
+                      << "the tuned ones" << std::endl;
+        }
+        return 0;
+    }
+
+    if (modeChoice==workstealing || modeChoice==replay) {
+        double start = wallTime();
+        graph = buildGraph();
+        scheduler = new TileScheduler(*graph, num_threads);
+        std::cout << "tile graph: " << graph->numTiles() << " tiles, "
+                  << graph->numEdges() << " edges, built in "
+                  << wallTime()-start << " s" << std::endl;
+    }
+
+    if (hw_counters) { openThreadCounters(); }
+
+    Jacobi2D grid(N);
+    grid.setKernel(kernelChoice);
+    if (strcmp(traceFile,"none")!=0) {
+        // Serial runs every tile on worker 0, the others get room for
+        // twice a fair share of the tiles in each buffer, so that the
+        // buffers do not grow during the traced repetition.
+        long long tiles = numRunTiles();
+        if (modeChoice==serial) {
+            trace = new TileTrace(1, tiles);
+        } else {
+            trace = new TileTrace(num_threads,
+                                  2*tiles/num_threads + 1024);
+        }
+        grid.setTrace(trace);
+    }
+    double time = bestTime(modeChoice, grid);
+    double points = (double)T*(N-2)*(N-2);
+    std::cout << "mode = " << modeStr << ", tiling = " << tilingStr
+              << ", N = " << N << ", T = " << T
+              << ", tau = " << tau << ", sigma = " << sigma
+              << ", gamma = " << gamma_size << ", height = " << height
+              << ", slab = " << slab
+              << ", threads = " << num_threads
+              << ", kernel = " << kernelName(kernelChoice) << std::endl;
+    std::cout << "time = " << time << " s, "
+              << points/time/1e6 << " Mpoints/s" << std::endl;
+    if (trace) {
+        countTracePoints();
+        std::ostringstream name;
+        name << "stencil-run " << modeStr << " " << tilingStr << " N=" << N
+             << " T=" << T << " tau=" << tau << " sigma=" << sigma
+             << " gamma=" << gamma_size << " height=" << height;
+        if (!trace->writeChromeJSON(traceFile, name.str())) {
+            std::cerr << "Error: stencil-run: can not write " << traceFile
+                      << std::endl;
+            return 1;
+        }
+        std::cout << "Generating file " << traceFile << " with "
+                  << trace->numEvents() << " tiles" << std::endl;
+    }
+    if (hw_counters) {
+        int Ts = (slab>0 && slab<T) ? slab : T;
+        int L = grid.lower(), U = grid.upper();
+        switch (tilingChoice) {
+            case diamonds:
+                reportCounters(DiamondTiling(Ts, L, U, L, U, tau));
+                break;
+            case diamond_prizms:
+                reportCounters(PrismTiling(Ts, L, U, L, U,
+                                           tau, sigma, height));
+                break;
+            case pipelined:
+                reportCounters(PipelinedTiling(Ts, L, U, L, U,
+                                               tau, sigma, gamma_size));
+                break;
+        }
+    }
+    if (scheduler) {
+        std::cout << "steals = " << scheduler->numSteals() << ", "
+                  << time/graph->numTiles()*1e9 << " ns per tile"
+                  << std::endl;
+    }
+
+    // Replay does not compute anything so there is nothing to check.
+    if (check && modeChoice!=replay) {
+        // The reference uses the same kernel so the speedup is only
+        // due to the tiling.
+        Jacobi2D reference(N);
+        reference.setKernel(kernelChoice);
+        double naive_time = bestTime(naive, reference);
+        double diff = grid.maxDiff(reference, T);
+        std::cout << "naive time = " << naive_time << " s, speedup = "
+                  << naive_time/time << std::endl;
+        if (diff > 1e-12) {
+            std::cerr << "Error: stencil-run: result differs from naive "
+                      << "sweep by " << diff << std::endl;
+            return 1;
+        }
+        std::cout << "check passed" << std::endl;
+    }
+
+    return 0;
+}
@@ -6,34 +6,35 @@ SVGPrinter::SVGPrinter(ostream &out, int height, int width) :
 }
 
 void SVGPrinter::printHeader() {
-    mOut << "<?xml version=\"1.0\" standalone=\"no\"?>" << endl;
-    mOut << "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\"" << endl;
-    mOut << "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">" << endl;
-    mOut << "" << endl;
+    mOut << "<?xml version=\"1.0\" standalone=\"no\"?>\n";
+    mOut << "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\"\n";
+    mOut << "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n";
+    mOut << "\n";
     mOut << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" ";
     mOut << "height=\"" << mHeight << "px\" ";
-    mOut << "width=\"" << mWidth << "px\">" << endl;
+    mOut << "width=\"" << mWidth << "px\">\n";
 }
 
 void SVGPrinter::printFooter() {
    mOut << "</svg>" << endl;
 }
 
-void SVGPrinter::printCircle(int x, int y, int r, string stroke, string fill) {
+void SVGPrinter::printCircle(int x, int y, int r, const string& stroke,
+                              const string& fill) {
     mOut << "<circle cx=\"" << x << "\" cy=\"" << y << "\" r=\"" << r << "\" "
-         << "stroke=\"" << stroke << "\" fill=\"" << fill << "\" />" << endl;
+         << "stroke=\"" << stroke << "\" fill=\"" << fill << "\" />\n";
 }
 
-void SVGPrinter::printCenteredText(int x, int y, string text) {
+void SVGPrinter::printCenteredText(int x, int y, const string& text) {
     mOut << "<text x=\"" << x << "\" y=\"" << y
          << "\" alignment-baseline=\"central\" "
-         << "text-anchor=\"middle\">" << endl;
-    mOut << text << endl;
-    mOut << "</text>" << endl;
+         << "text-anchor=\"middle\">\n";
+    mOut << text << "\n";
+    mOut << "</text>\n";
 }
 
 void SVGPrinter::printRectangle(
-    int x, int y, int w, int h, string stroke, string fill)
+    int x, int y, int w, int h, const string& stroke, const string& fill)
 {
     mOut << "<rect "
          << "x=\"" << x << "\" "
@@ -41,5 +42,5 @@ void SVGPrinter::printRectangle(
          << "width=\"" << w << "\" "
          << "height=\"" << h << "\" "
          << "fill=\"" << fill << "\" "
-         << "stroke=\"" << stroke << "\" />" << endl;
+         << "stroke=\"" << stroke << "\" />\n";
 }
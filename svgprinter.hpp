@@ -18,9 +18,11 @@ class SVGPrinter {
 
     void printHeader();
     void printFooter();
-    void printCircle(int x, int y, int r, string stroke, string fill);
-    void printCenteredText(int x, int y, string text);
-    void printRectangle(int x, int y, int w, int h, string stroke, string fill);
+    void printCircle(int x, int y, int r, const string& stroke,
+                     const string& fill);
+    void printCenteredText(int x, int y, const string& text);
+    void printRectangle(int x, int y, int w, int h, const string& stroke,
+                        const string& fill);
 
   private:
     ostream &mOut;
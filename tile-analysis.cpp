@@ -0,0 +1,1141 @@
+/*!
+ * \file tile-analysis.cpp
+ *
+ * \brief Driver for analyzing the tilings that slice-viz visualizes
+ *        without running the stencil.
+ *
+ * The footprint mode computes the data footprint of a full tile in
+ * bytes, compares it against the L1, L2, and L3 sizes of this machine,
+ * and recommends the largest tau whose tile fits in each level.  For
+ * diamond_prizms and pipelined, sigma, height, and gamma stay fixed
+ * while tau varies.
+ *
+ * The cachesim mode feeds the address stream of the stencil in each
+ * tiling's schedule order through CacheSim and reports misses per
+ * cache level and per tile.  Every combination of tau and cache
+ * configuration is simulated on its own thread.
+ *
+ * The profile mode writes the ParallelismProfile of the tiling as CSV
+ * or JSON.
+ *
+ * The count mode counts the points of every tile with numPoints and
+ * checks the counts against visiting the rows of each tile.
+ *
+ * The tilespace mode builds the TileSpace of the tiling, reports how many
+ * of the tiles enumerated by the loose bounds are empty, and checks that
+ * the TileSpace and its flat index give the non-empty tiles in the same
+ * order as the tiling.
+ *
+ * The dag mode writes the TileGraph with the points and halo bytes of
+ * every tile to the binary file described in TileDag.hpp, and to a DOT
+ * file when the graph is small enough to draw.
+ *
+ * The simulate mode simulates running the tile graph on 1 to
+ * max_workers workers with a barrier after every wavefront and with
+ * greedy dataflow (see ExecutionSim.hpp), where a tile costs its points
+ * times the ns per point.  The ns per point is measured by running the
+ * tiling with Jacobi2D unless it is given.
+ *
+ * The legality mode runs the tiling, or one of the generated .is
+ * traversals, through DependenceChecker and reports the first point
+ * that runs before one of its stencil predecessors.  The slab_param,
+ * slab_fixed, slab_unskew, slab_simple, and slab_projected tilings are
+ * the hand edited tile bounds of tile-space-viz.cpp for one slab of
+ * T <= tau/3-2 time steps (see SlabDiamondTiling.hpp), so they can be
+ * checked the same way, and the tilespace mode reports how many of the
+ * tiles they enumerate are empty.
+ *
+ * The coverage mode runs the tiling, or one of the generated .is
+ * traversals, through CoverageChecker and reports the points that are
+ * never visited and the tiles that visit points more than once or
+ * outside of the iteration space.
+ *
+ * To see how to run, type "./tile-analysis --help".
+ */
+#include "DiamondTiling.hpp"
+#include "PrismTiling.hpp"
+#include "PipelinedTiling.hpp"
+#include "NaiveTiling.hpp"
+#include "SlabDiamondTiling.hpp"
+#include "TileFootprint.hpp"
+#include "CacheSizes.hpp"
+#include "CacheSim.hpp"
+#include "ParallelismProfile.hpp"
+#include "TileDag.hpp"
+#include "ExecutionSim.hpp"
+#include "Jacobi2D.hpp"
+#include "DependenceChecker.hpp"
+#include "IsTraversal.hpp"
+#include "CoverageChecker.hpp"
+#include "TileSpace.hpp"
+#include "CmdParams.h"
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <type_traits>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <omp.h>
+
+//==============================================
+// Global parameters with their default values.
+int T = 100;
+int N = 1000;
+int tau = 15;
+int sigma = 15;
+int height = 0;
+int gamma_size = 15;
+int elem_size = 8;
+int num_buffers = 2;
+int max_tau = 1000;
+int tau_step = 0;
+int num_threads = 0;
+char cacheSpecs[MAXPOSSVALSTRING];
+char outFile[MAXPOSSVALSTRING];
+char dotFile[MAXPOSSVALSTRING];
+char inFile[MAXPOSSVALSTRING];
+char nsPerPointStr[MAXPOSSVALSTRING];
+int max_workers = 256;
+
+typedef enum {
+    footprint,
+    cachesim,
+    profile,
+    count,
+    dag,
+    simulate,
+    legality,
+    coverage,
+    tilespace
+} mode_type;
+mode_type modeChoice = footprint;
+char modeStr[MAXPOSSVALSTRING];
+#define num_MPairs 9
+static EnumStringPair MPairs[] = {{footprint,"footprint"},
+                                  {cachesim,"cachesim"},
+                                  {profile,"profile"},
+                                  {count,"count"},
+                                  {dag,"dag"},
+                                  {simulate,"simulate"},
+                                  {legality,"legality"},
+                                  {coverage,"coverage"},
+                                  {tilespace,"tilespace"}
+                                 };
+
+typedef enum {
+    csv,
+    json
+} format_type;
+format_type formatChoice = csv;
+#define num_FPairs 2
+static EnumStringPair FPairs[] = {{csv,"csv"},
+                                  {json,"json"}
+                                 };
+
+typedef enum {
+    diamonds,
+    diamond_prizms,
+    pipelined,
+    naive,
+    slab_param,
+    slab_fixed,
+    slab_unskew,
+    slab_simple,
+    slab_projected
+} tiling_type;
+tiling_type tilingChoice = diamonds;
+char tilingStr[MAXPOSSVALSTRING];
+#define num_TPairs 9
+static EnumStringPair TPairs[] = {{diamonds,"diamonds"},
+                                  {diamond_prizms,"diamond_prizms"},
+                                  {pipelined,"pipelined"},
+                                  {naive,"naive"},
+                                  {slab_param,"slab_param"},
+                                  {slab_fixed,"slab_fixed"},
+                                  {slab_unskew,"slab_unskew"},
+                                  {slab_simple,"slab_simple"},
+                                  {slab_projected,"slab_projected"}
+                                 };
+
+bool isSlabTiling() {
+    return tilingChoice==slab_param || tilingChoice==slab_fixed
+           || tilingChoice==slab_unskew || tilingChoice==slab_simple
+           || tilingChoice==slab_projected;
+}
+
+// Which of the tile-space-viz.cpp bounds the slab tiling uses.
+slab_bounds_type slabBounds() {
+    switch (tilingChoice) {
+        case slab_param:
+            return slab_bounds_param;
+        case slab_fixed:
+            return slab_bounds_fixed;
+        case slab_simple:
+            return slab_bounds_simple;
+        case slab_projected:
+            return slab_bounds_projected;
+        default:
+            return slab_bounds_unskew;
+    }
+}
+
+is_traversal_type isChoice = is_none;
+char isStr[MAXPOSSVALSTRING];
+#define num_IPairs 7
+static EnumStringPair IPairs[] = {{is_none,"none"},
+                                  {is_pipelined_4x4x4,"pipelined_4x4x4"},
+                                  {is_diamonds_tij_skew,"diamonds_tij_skew"},
+                                  {is_diamond_prizms_6x6,"diamond_prizms_6x6"},
+                                  {is_diamond_prizms_8x8,"diamond_prizms_8x8"},
+                                  {is_diamond_prizms_12x12,
+                                   "diamond_prizms_12x12"},
+                                  {is_diamond_prizms_6x6_noping,
+                                   "diamond_prizms_6x6_noping"}
+                                 };
+
+static const char* levelNames[NUM_CACHE_LEVELS] = {"L1", "L2", "L3"};
+
+//==============================================
+
+void initParams(CmdParams * cmdparams)
+/*--------------------------------------------------------------*//*!
+  Uses a CmdParams object to describe all of the command line
+  parameters.
+*//*--------------------------------------------------------------*/
+{
+    CmdParams_describeEnumParam(cmdparams, "mode", 'm', 1,
+            "which analysis to do",
+            MPairs, num_MPairs, footprint);
+
+    CmdParams_describeEnumParam(cmdparams, "tiling", 'y', 1,
+            "tiling to analyze",
+            TPairs, num_TPairs, diamonds);
+
+    CmdParams_describeNumParam(cmdparams,"numTimeSteps", 'T', 1,
+            "number of time steps for cachesim, profile, count, "
+            "tilespace, dag, simulate, legality, and coverage",
+            1, 100000, 100);
+
+    CmdParams_describeNumParam(cmdparams,"spatialDim", 'N', 1,
+            "2D data will be NxN, for footprint it only matters for "
+            "diamond_prizms and naive since their tiles span all of j",
+            3, 100000, 1000);
+
+    CmdParams_describeNumParam(cmdparams,"tau", 't', 1,
+            "tile size for diamonds, along t+i for diamond_prizms, "
+            "and along t for pipelined (tau)",
+            2, 10000, 15);
+
+    CmdParams_describeNumParam(cmdparams,"sigma", 'b', 1,
+            "tile size along t-i for diamond_prizms "
+            "and along t+i for pipelined (sigma)",
+            2, 10000, 15);
+
+    CmdParams_describeNumParam(cmdparams,"height", 'E', 1,
+            "time steps a diamond_prizms tile spans, at most "
+            "(tau+sigma)/2, or 0 for (tau+sigma)/2",
+            0, 10000, 0);
+
+    CmdParams_describeNumParam(cmdparams,"gamma", 'G', 1,
+            "tile size along t+j for pipelined (gamma)",
+            2, 10000, 15);
+
+    CmdParams_describeNumParam(cmdparams,"elem_size", 'e', 1,
+            "bytes per data element",
+            1, 1024, 8);
+
+    CmdParams_describeNumParam(cmdparams,"buffers", 'n', 1,
+            "number of data buffers, 2 is ping/pong",
+            1, 100000, 2);
+
+    CmdParams_describeNumParam(cmdparams,"max_tau", 'x', 1,
+            "largest tau to consider when recommending a tau, "
+            "and the last tau of the cachesim sweep",
+            2, 10000, 1000);
+
+    CmdParams_describeNumParam(cmdparams,"tau_step", 's', 1,
+            "cachesim sweeps tau from tau to max_tau in steps of "
+            "tau_step, 0 means only simulate tau",
+            0, 10000, 0);
+
+    CmdParams_describeStringParam(cmdparams,"caches", 'c', 1,
+            "cache configurations for cachesim separated by ';', each "
+            "is a list of levels like 48K:12,2M:16:64 with "
+            "size:associativity:line size, detect uses this machine",
+            "detect");
+
+    CmdParams_describeNumParam(cmdparams,"threads", 'p', 1,
+            "number of threads for cachesim, legality, and coverage, 0 "
+            "means one per core",
+            0, 1024, 0);
+
+    CmdParams_describeStringParam(cmdparams,"out_file", 'o', 1,
+            "file for the cachesim misses of every tile as CSV, for "
+            "the profile, for the binary dag, or for the simulate "
+            "results as CSV, none means no per tile misses and the "
+            "profile goes to stdout",
+            "none");
+
+    CmdParams_describeStringParam(cmdparams,"dot_file", 'd', 1,
+            "DOT file for the dag, none means no DOT file",
+            "none");
+
+    CmdParams_describeStringParam(cmdparams,"in_file", 'i', 1,
+            "binary dag written by the dag mode to simulate, none means "
+            "build the graph of the tiling",
+            "none");
+
+    CmdParams_describeStringParam(cmdparams,"ns_per_point", 'k', 1,
+            "cost of one point in ns for simulate, calibrate measures it "
+            "by running the tiling",
+            "calibrate");
+
+    CmdParams_describeEnumParam(cmdparams, "is_traversal", 'I', 1,
+            "generated .is traversal for legality and coverage to check "
+            "instead of the tiling, these have fixed tile sizes",
+            IPairs, num_IPairs, is_none);
+
+    CmdParams_describeEnumParam(cmdparams, "format", 'f', 1,
+            "output format for profile",
+            FPairs, num_FPairs, csv);
+
+    CmdParams_describeNumParam(cmdparams,"max_workers", 'w', 1,
+            "profile reports the ideal speedup for 1 to max_workers, "
+            "and simulate runs powers of 2 up to max_workers",
+            1, 100000, 256);
+}
+
+// The prism height for tile size tt.  Tile sizes too small for the
+// height get the default height.
+int prismHeight(int tt) {
+    return (2*height <= tt+sigma) ? height : 0;
+}
+
+// Calls f(tiling) with a tiling for tile size tt over a domain that is
+// big enough to contain full tiles.
+template <typename F>
+void withSampleTiling(int tt, F f) {
+    int ext = tt + sigma + gamma_size;
+    switch (tilingChoice) {
+        case diamonds:
+            f(DiamondTiling(2*tt, 1, 3*tt, 1, 3*tt, tt));
+            break;
+        case diamond_prizms:
+            f(PrismTiling(2*ext, 1, 3*ext, 1, N-2, tt, sigma,
+                          prismHeight(tt)));
+            break;
+        case pipelined:
+            f(PipelinedTiling(2*ext, 1, 3*ext, 1, 3*ext,
+                              tt, sigma, gamma_size));
+            break;
+        case naive:
+            f(NaiveTiling(2, 1, N-2, 1, N-2));
+            break;
+        case slab_param:
+        case slab_fixed:
+        case slab_unskew:
+        case slab_simple:
+        case slab_projected:
+            f(SlabDiamondTiling(imax(tt/3-2, 1), 1, 3*tt, 1, 3*tt, tt,
+                                slabBounds()));
+            break;
+    }
+}
+
+// Calls f(tiling) with the tiling for tile size tt over the interior of
+// an nxn grid for nt time steps, the same as stencil-run.
+template <typename F>
+void withTilingSize(int nt, int n, int tt, F f) {
+    switch (tilingChoice) {
+        case diamonds:
+            f(DiamondTiling(nt, 1, n-2, 1, n-2, tt));
+            break;
+        case diamond_prizms:
+            f(PrismTiling(nt, 1, n-2, 1, n-2, tt, sigma, prismHeight(tt)));
+            break;
+        case pipelined:
+            f(PipelinedTiling(nt, 1, n-2, 1, n-2, tt, sigma, gamma_size));
+            break;
+        case naive:
+            f(NaiveTiling(nt, 1, n-2, 1, n-2));
+            break;
+        case slab_param:
+        case slab_fixed:
+        case slab_unskew:
+        case slab_simple:
+        case slab_projected:
+            f(SlabDiamondTiling(nt, 1, n-2, 1, n-2, tt, slabBounds()));
+            break;
+    }
+}
+
+// Same as withTilingSize for the T and N parameters.
+template <typename F>
+void withTiling(int tt, F f) {
+    withTilingSize(T, N, tt, f);
+}
+
+// Footprint of a full tile for tile size tt.
+Footprint fullTileFootprint(int tt, TileCoord& tile) {
+    Footprint fp = {0, 0, 0, 0, 0};
+    withSampleTiling(tt, [&](const auto& tiling) {
+        tile = largestTile(tiling);
+        fp = tileFootprint(tiling, tile, num_buffers, elem_size);
+    });
+    return fp;
+}
+
+// Largest tau up to max_tau whose full tile footprint fits in size
+// bytes, or 0 if none does.  Diamonds only use multiples of 3.
+int largestFittingTau(long long size) {
+    int step = (tilingChoice==diamonds || isSlabTiling()) ? 3 : 1;
+    int lo = 1, hi = max_tau/step;
+    if (step==1) { lo = 2; }
+    if (isSlabTiling()) { lo = 3; }
+    TileCoord tile;
+    if (fullTileFootprint(lo*step, tile).totalBytes > size) { return 0; }
+    // The footprint grows with tau, so binary search.
+    while (lo < hi) {
+        int mid = (lo+hi+1)/2;
+        if (fullTileFootprint(mid*step, tile).totalBytes <= size) {
+            lo = mid;
+        } else {
+            hi = mid-1;
+        }
+    }
+    return lo*step;
+}
+
+std::string bytesToString(long long bytes) {
+    std::ostringstream ss;
+    if (bytes >= 1024LL*1024*1024) {
+        ss << (double)bytes/(1024.0*1024*1024) << " GB";
+    } else if (bytes >= 1024*1024) {
+        ss << (double)bytes/(1024.0*1024) << " MB";
+    } else if (bytes >= 1024) {
+        ss << (double)bytes/1024.0 << " KB";
+    } else {
+        ss << bytes << " B";
+    }
+    return ss.str();
+}
+
+void printFootprint(int tt, const Footprint& fp, const TileCoord& tile) {
+    std::cout << "tau = " << tt << ": tile (" << tile.c0 << "," << tile.c1
+              << "," << tile.c2 << "), points = " << fp.points
+              << ", read = " << bytesToString(fp.readBytes)
+              << ", write = " << bytesToString(fp.writeBytes)
+              << ", footprint = " << bytesToString(fp.totalBytes)
+              << ", halo = " << bytesToString(fp.haloBytes) << std::endl;
+}
+
+// One simulation in the cachesim sweep.
+struct SimConfig {
+    int tau;
+    std::string caches;
+    std::vector<CacheLevel> levels;
+    // Results.
+    long long numTiles;
+    long long accesses;
+    std::vector<long long> misses;
+    std::vector<long long> maxTileMisses;
+    // Per tile results, only kept when writing the tile file.
+    std::vector<TileCoord> tiles;
+    std::vector<long long> tilePoints;
+    std::vector<long long> tileMisses;  // numLevels per tile
+};
+
+std::string cacheLevelsToString(const std::vector<CacheLevel>& levels) {
+    std::ostringstream ss;
+    for (size_t l = 0; l < levels.size(); l++) {
+        if (l > 0) { ss << ","; }
+        long long size = levels[l].size;
+        if (size % (1024*1024) == 0) {
+            ss << size/(1024*1024) << "M";
+        } else if (size % 1024 == 0) {
+            ss << size/1024 << "K";
+        } else {
+            ss << size;
+        }
+        ss << ":" << levels[l].assoc << ":" << levels[l].lineSize;
+    }
+    return ss.str();
+}
+
+void simulateCaches(SimConfig& config) {
+    CacheSim sim(config.levels);
+    int num_levels = sim.numLevels();
+    config.maxTileMisses.assign(num_levels, 0);
+    config.numTiles = 0;
+    bool keep_tiles = (strcmp(outFile,"none") != 0);
+    withTiling(config.tau, [&](const auto& tiling) {
+        simulateTiling(tiling, N, sim,
+            [&](const TileCoord& tile, long long points,
+                const std::vector<long long>& misses) {
+                if (points == 0) { return; }
+                for (int l = 0; l < num_levels; l++) {
+                    if (misses[l] > config.maxTileMisses[l]) {
+                        config.maxTileMisses[l] = misses[l];
+                    }
+                }
+                config.numTiles++;
+                if (keep_tiles) {
+                    config.tiles.push_back(tile);
+                    config.tilePoints.push_back(points);
+                    config.tileMisses.insert(config.tileMisses.end(),
+                                             misses.begin(), misses.end());
+                }
+            });
+    });
+    config.accesses = sim.accesses();
+    config.misses.resize(num_levels);
+    for (int l = 0; l < num_levels; l++) {
+        config.misses[l] = sim.misses(l);
+    }
+}
+
+bool cachesimMode() {
+    // Cache configurations.
+    std::vector<std::string> specs;
+    std::stringstream list(cacheSpecs);
+    std::string spec;
+    while (std::getline(list, spec, ';')) {
+        if (!spec.empty()) { specs.push_back(spec); }
+    }
+    std::vector< std::vector<CacheLevel> > cache_configs;
+    for (size_t k = 0; k < specs.size(); k++) {
+        std::vector<CacheLevel> levels;
+        if (specs[k] == "detect") {
+            CacheLevel detected[NUM_CACHE_LEVELS];
+            detectCacheSizes(detected);
+            for (int l = 0; l < NUM_CACHE_LEVELS; l++) {
+                if (detected[l].size > 0) { levels.push_back(detected[l]); }
+            }
+        } else if (!parseCacheLevels(specs[k], levels)) {
+            std::cerr << "Error: tile-analysis: bad cache configuration "
+                      << specs[k] << std::endl;
+            return false;
+        }
+        if (levels.empty()) {
+            std::cerr << "Error: tile-analysis: no cache levels in "
+                      << specs[k] << std::endl;
+            return false;
+        }
+        cache_configs.push_back(levels);
+    }
+
+    // Every tau with every cache configuration.
+    std::vector<int> taus;
+    taus.push_back(tau);
+    if (tau_step > 0 && tilingChoice != naive) {
+        for (int tt = tau+tau_step; tt <= max_tau; tt += tau_step) {
+            if (isSlabTiling() && tt%3 != 0) { continue; }
+            taus.push_back(tt);
+        }
+    }
+    std::vector<SimConfig> configs;
+    for (size_t k = 0; k < taus.size(); k++) {
+        for (size_t c = 0; c < cache_configs.size(); c++) {
+            SimConfig config;
+            config.tau = taus[k];
+            config.levels = cache_configs[c];
+            config.caches = cacheLevelsToString(cache_configs[c]);
+            configs.push_back(config);
+        }
+    }
+
+    // Each thread takes the next configuration that is left.
+    int workers = num_threads;
+    if (workers <= 0) { workers = (int)std::thread::hardware_concurrency(); }
+    if (workers <= 0) { workers = 1; }
+    if (workers > (int)configs.size()) { workers = (int)configs.size(); }
+    std::atomic<int> next(0);
+    auto work = [&]() {
+        int k;
+        while ((k = next.fetch_add(1)) < (int)configs.size()) {
+            simulateCaches(configs[k]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int w = 1; w < workers; w++) {
+        threads.push_back(std::thread(work));
+    }
+    work();
+    for (size_t w = 0; w < threads.size(); w++) {
+        threads[w].join();
+    }
+
+    std::cout << "tiling = " << tilingStr << ", N = " << N << ", T = " << T
+              << ", sigma = " << sigma << ", gamma = " << gamma_size
+              << ", threads = " << workers << std::endl;
+    for (size_t k = 0; k < configs.size(); k++) {
+        const SimConfig& config = configs[k];
+        std::cout << "tau = " << config.tau << ", caches = " << config.caches
+                  << ": tiles = " << config.numTiles
+                  << ", accesses = " << config.accesses;
+        for (size_t l = 0; l < config.misses.size(); l++) {
+            std::cout << ", L" << l+1 << " misses = " << config.misses[l]
+                      << " (" << 100.0*config.misses[l]/config.accesses
+                      << "%, max per tile " << config.maxTileMisses[l]
+                      << ")";
+        }
+        std::cout << std::endl;
+    }
+
+    if (strcmp(outFile,"none") != 0) {
+        std::ofstream out(outFile);
+        if (!out) {
+            std::cerr << "Error: tile-analysis: can not write " << outFile
+                      << std::endl;
+            return false;
+        }
+        out << "tau,caches,c0,c1,c2,points,level,misses" << std::endl;
+        for (size_t k = 0; k < configs.size(); k++) {
+            const SimConfig& config = configs[k];
+            size_t num_levels = config.misses.size();
+            for (size_t n = 0; n < config.tiles.size(); n++) {
+                const TileCoord& tile = config.tiles[n];
+                for (size_t l = 0; l < num_levels; l++) {
+                    out << config.tau << ",\"" << config.caches << "\","
+                        << tile.c0 << "," << tile.c1 << "," << tile.c2
+                        << "," << config.tilePoints[n] << ",L" << l+1 << ","
+                        << config.tileMisses[n*num_levels+l] << std::endl;
+                }
+            }
+        }
+        std::cout << "Generating file " << outFile << std::endl;
+    }
+    return true;
+}
+
+void footprintMode() {
+    std::cout << "tiling = " << tilingStr << ", tau = " << tau
+              << ", sigma = " << sigma << ", gamma = " << gamma_size
+              << ", elem_size = " << elem_size
+              << ", buffers = " << num_buffers << std::endl;
+
+    TileCoord tile;
+    Footprint fp = fullTileFootprint(tau, tile);
+    printFootprint(tau, fp, tile);
+
+    CacheLevel levels[NUM_CACHE_LEVELS];
+    detectCacheSizes(levels);
+    for (int l = 0; l < NUM_CACHE_LEVELS; l++) {
+        std::cout << levelNames[l] << " = ";
+        if (levels[l].size <= 0) {
+            std::cout << "unknown" << std::endl;
+            continue;
+        }
+        std::cout << bytesToString(levels[l].size) << ", tile "
+                  << (fp.totalBytes <= levels[l].size ? "fits" : "does not fit");
+        // The naive sweep has no tile size to pick.
+        if (tilingChoice==naive) {
+            std::cout << std::endl;
+            continue;
+        }
+        std::cout << ", ";
+        int best = largestFittingTau(levels[l].size);
+        if (best == 0) {
+            std::cout << "no tau fits" << std::endl;
+        } else if (best >= max_tau - 2) {
+            std::cout << "largest tau that fits is at least " << best
+                      << std::endl;
+        } else {
+            Footprint best_fp = fullTileFootprint(best, tile);
+            std::cout << "largest tau that fits = " << best << " ("
+                      << bytesToString(best_fp.totalBytes) << ")"
+                      << std::endl;
+        }
+    }
+}
+
+bool profileMode() {
+    std::ofstream file;
+    bool to_file = (strcmp(outFile,"none") != 0);
+    if (to_file) {
+        file.open(outFile);
+        if (!file) {
+            std::cerr << "Error: tile-analysis: can not write " << outFile
+                      << std::endl;
+            return false;
+        }
+    }
+    std::ostream& out = to_file ? file : std::cout;
+    withTiling(tau, [&](const auto& tiling) {
+        ParallelismProfile prof(tiling);
+        if (formatChoice==json) {
+            prof.writeJSON(out, max_workers);
+        } else {
+            prof.writeCSV(out, max_workers);
+        }
+    });
+    if (to_file) { std::cout << "Generating file " << outFile << std::endl; }
+    return true;
+}
+
+// Wall clock time in seconds.
+double wallTime() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool countMode() {
+    bool ok = true;
+    withTiling(tau, [&](const auto& tiling) {
+        long long tiles = 0, empty = 0, points = 0;
+        long long min_points = -1, max_points = 0;
+        double start = wallTime();
+        for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront();
+             w++) {
+            tiling.forEachTile(w, [&](const TileCoord& tile) {
+                long long n = tiling.numPoints(tile);
+                tiles++;
+                if (n == 0) { empty++; return; }
+                points += n;
+                if (min_points < 0 || n < min_points) { min_points = n; }
+                if (n > max_points) { max_points = n; }
+            });
+        }
+        double count_time = wallTime()-start;
+
+        // Check against the rows.
+        long long mismatches = 0;
+        start = wallTime();
+        for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront();
+             w++) {
+            tiling.forEachTile(w, [&](const TileCoord& tile) {
+                long long n = 0;
+                tiling.forEachRow(tile, [&](int, int, int j_lb, int j_ub) {
+                    n += j_ub-j_lb+1;
+                });
+                if (n != tiling.numPoints(tile)) { mismatches++; }
+            });
+        }
+        double row_time = wallTime()-start;
+
+        std::cout << "tiling = " << tilingStr << ", N = " << N
+                  << ", T = " << T << ", tau = " << tau
+                  << ", sigma = " << sigma << ", gamma = " << gamma_size
+                  << std::endl;
+        std::cout << "tiles = " << tiles << " (" << empty << " empty, "
+                  << 100.0*empty/tiles << "%)"
+                  << ", points = " << points << " of "
+                  << (long long)T*(N-2)*(N-2)
+                  << ", points per tile = " << min_points << " to "
+                  << max_points << std::endl;
+        std::cout << "numPoints time = " << count_time << " s, "
+                  << count_time/tiles*1e9 << " ns per tile, row time = "
+                  << row_time << " s" << std::endl;
+        if (mismatches > 0 || points != (long long)T*(N-2)*(N-2)) {
+            std::cerr << "Error: tile-analysis: numPoints differs from the "
+                      << "rows for " << mismatches << " tiles" << std::endl;
+            ok = false;
+        } else {
+            std::cout << "check passed" << std::endl;
+        }
+    });
+    return ok;
+}
+
+bool tilespaceMode() {
+    bool ok = true;
+    withTiling(tau, [&](const auto& tiling) {
+        double start = wallTime();
+        TileSpace<typename std::decay<decltype(tiling)>::type> space(tiling);
+        double build_time = wallTime()-start;
+
+        // Non-empty tiles of the loose bounds, in order.
+        std::vector<TileCoord> tiles;
+        start = wallTime();
+        for (int w = tiling.firstWavefront(); w <= tiling.lastWavefront();
+             w++) {
+            tiling.forEachTile(w, [&](const TileCoord& tile) {
+                if (tiling.numPoints(tile) > 0) { tiles.push_back(tile); }
+            });
+        }
+        double loose_time = wallTime()-start;
+
+        long long mismatches = 0;
+        size_t next = 0;
+        start = wallTime();
+        for (int w = space.firstWavefront(); w <= space.lastWavefront();
+             w++) {
+            space.forEachTile(w, [&](const TileCoord& tile) {
+                if (next >= tiles.size() || tile.c0 != tiles[next].c0
+                        || tile.c1 != tiles[next].c1
+                        || tile.c2 != tiles[next].c2) {
+                    mismatches++;
+                }
+                next++;
+            });
+        }
+        double tight_time = wallTime()-start;
+        if (next != tiles.size()) { mismatches++; }
+
+        // The flat index gives the same tiles, and each wavefront is
+        // its own range.
+        for (int w = space.firstWavefront(); w <= space.lastWavefront();
+             w++) {
+            for (int k = space.wavefrontBegin(w); k < space.wavefrontEnd(w);
+                 k++) {
+                TileCoord tile = space.tile(k);
+                if (k >= (int)tiles.size() || tile.c0 != tiles[k].c0
+                        || tile.c1 != tiles[k].c1 || tile.c2 != tiles[k].c2) {
+                    mismatches++;
+                }
+            }
+        }
+
+        std::cout << "tiling = " << tilingStr << ", N = " << N
+                  << ", T = " << T << ", tau = " << tau
+                  << ", sigma = " << sigma << ", gamma = " << gamma_size
+                  << std::endl;
+        std::cout << "enumerated tiles = " << space.numEnumerated()
+                  << ", empty = " << space.numEmpty() << " ("
+                  << 100.0*space.emptyRatio() << "%), tiles = "
+                  << space.numTiles() << " in " << space.rows().size()
+                  << " rows" << std::endl;
+        std::cout << "build time = " << build_time << " s, loose "
+                  << "enumeration = " << loose_time << " s, tight "
+                  << "enumeration = " << tight_time << " s" << std::endl;
+        if (mismatches > 0) {
+            std::cerr << "Error: tile-analysis: the tile space differs from "
+                      << "the non-empty tiles of the tiling for "
+                      << mismatches << " tiles" << std::endl;
+            ok = false;
+        } else {
+            std::cout << "check passed" << std::endl;
+        }
+    });
+    return ok;
+}
+
+// Largest graph that the dag mode writes as DOT.
+#define MAX_DOT_TILES 10000
+
+bool dagMode() {
+    if (strcmp(outFile,"none") == 0 && strcmp(dotFile,"none") == 0) {
+        std::cerr << "Error: tile-analysis: dag needs an out_file or "
+                  << "dot_file" << std::endl;
+        return false;
+    }
+    bool ok = true;
+    withTiling(tau, [&](const auto& tiling) {
+        double start = wallTime();
+        TileGraph graph(tiling);
+        double graph_time = wallTime()-start;
+
+        start = wallTime();
+        int num_tiles = graph.numTiles();
+        std::vector<long long> points(num_tiles), halo_bytes(num_tiles);
+        HaloCounter halo;
+        for (int k = 0; k < num_tiles; k++) {
+            points[k] = tiling.numPoints(graph.tile(k));
+            halo_bytes[k] = halo.count(tiling, graph.tile(k))
+                            * (long long)elem_size;
+        }
+        double annotate_time = wallTime()-start;
+
+        std::cout << "tiling = " << tilingStr << ", N = " << N
+                  << ", T = " << T << ", tau = " << tau
+                  << ", sigma = " << sigma << ", gamma = " << gamma_size
+                  << std::endl;
+        std::cout << "tiles = " << num_tiles << ", edges = "
+                  << graph.numEdges() << ", graph time = " << graph_time
+                  << " s, points and halo time = " << annotate_time << " s"
+                  << std::endl;
+
+        if (strcmp(outFile,"none") != 0) {
+            start = wallTime();
+            if (!writeTileDag(outFile, graph, points, halo_bytes)) {
+                std::cerr << "Error: tile-analysis: can not write "
+                          << outFile << std::endl;
+                ok = false;
+                return;
+            }
+            std::cout << "Generating file " << outFile << " ("
+                      << wallTime()-start << " s)" << std::endl;
+        }
+        if (strcmp(dotFile,"none") != 0) {
+            if (num_tiles > MAX_DOT_TILES) {
+                std::cerr << "Error: tile-analysis: " << num_tiles
+                          << " tiles is too many for DOT, the limit is "
+                          << MAX_DOT_TILES << std::endl;
+                ok = false;
+                return;
+            }
+            if (!writeTileDot(dotFile, graph, points, halo_bytes)) {
+                std::cerr << "Error: tile-analysis: can not write "
+                          << dotFile << std::endl;
+                ok = false;
+                return;
+            }
+            std::cout << "Generating file " << dotFile << std::endl;
+        }
+    });
+    return ok;
+}
+
+// Measures the ns per point of running the tiling serially with the
+// fastest row kernel, on at most a 1000x1000 grid for 50 time steps.
+double calibrateNsPerPoint() {
+    int n = imin(N, 1000);
+    int nt = imin(T, 50);
+    Jacobi2D grid(n);
+    kernel_type kernel = kernel_auto;
+    grid.setKernel(kernel);
+    grid.init(1);
+    double best = -1.0;
+    withTilingSize(nt, n, tau, [&](const auto& tiling) {
+        for (int rep = 0; rep < 3; rep++) {
+            double start = wallTime();
+            grid.runSerial(tiling);
+            double time = wallTime()-start;
+            if (best < 0.0 || time < best) { best = time; }
+        }
+    });
+    return best*1e9 / ((double)nt*(n-2)*(n-2));
+}
+
+// Simulates the graph with both policies for powers of 2 workers up to
+// max_workers, and for max_workers.
+template <typename Graph>
+void simulateGraph(const Graph& graph, const std::vector<long long>& points,
+                   double ns_per_point, std::ostream& out, bool csv_format) {
+    std::vector<double> cost(points.size());
+    for (size_t k = 0; k < points.size(); k++) {
+        cost[k] = points[k]*ns_per_point;
+    }
+    std::vector<int> workers;
+    for (int P = 1; P < max_workers; P *= 2) { workers.push_back(P); }
+    workers.push_back(max_workers);
+
+    if (csv_format) {
+        out << "workers,policy,makespan_ns,speedup,utilization,idle_ns"
+            << std::endl;
+    }
+    static const char* policyNames[] = {"barrier", "greedy"};
+    for (size_t w = 0; w < workers.size(); w++) {
+        for (int p = policy_barrier; p <= policy_greedy; p++) {
+            ExecutionStats stats = simulateExecution(graph, cost,
+                                       workers[w], (policy_type)p);
+            double speedup = (stats.makespan > 0.0)
+                           ? stats.work/stats.makespan : 1.0;
+            if (csv_format) {
+                out << stats.workers << "," << policyNames[p] << ","
+                    << stats.makespan << "," << speedup << ","
+                    << stats.utilization << "," << stats.idle << std::endl;
+            } else {
+                out << "workers = " << stats.workers << ", "
+                    << policyNames[p] << ": makespan = "
+                    << stats.makespan*1e-6 << " ms, speedup = " << speedup
+                    << ", utilization = " << 100.0*stats.utilization
+                    << "%, idle = " << stats.idle*1e-6 << " ms" << std::endl;
+            }
+        }
+    }
+}
+
+bool simulateMode() {
+    double ns_per_point;
+    if (strcmp(nsPerPointStr,"calibrate") == 0) {
+        ns_per_point = calibrateNsPerPoint();
+    } else {
+        ns_per_point = atof(nsPerPointStr);
+        if (ns_per_point <= 0.0) {
+            std::cerr << "Error: tile-analysis: bad ns_per_point "
+                      << nsPerPointStr << std::endl;
+            return false;
+        }
+    }
+
+    std::ofstream file;
+    bool to_file = (strcmp(outFile,"none") != 0);
+    if (to_file) {
+        file.open(outFile);
+        if (!file) {
+            std::cerr << "Error: tile-analysis: can not write " << outFile
+                      << std::endl;
+            return false;
+        }
+    }
+    std::ostream& out = to_file ? file : std::cout;
+
+    if (strcmp(inFile,"none") != 0) {
+        MappedTileDag dag;
+        if (!dag.open(inFile)) {
+            std::cerr << "Error: tile-analysis: can not read dag file "
+                      << inFile << std::endl;
+            return false;
+        }
+        std::vector<long long> points(dag.numTiles());
+        for (int k = 0; k < dag.numTiles(); k++) { points[k] = dag.points(k); }
+        std::cout << "dag = " << inFile << ", tiles = " << dag.numTiles()
+                  << ", ns per point = " << ns_per_point << std::endl;
+        simulateGraph(dag, points, ns_per_point, out, to_file);
+    } else {
+        withTiling(tau, [&](const auto& tiling) {
+            TileGraph graph(tiling);
+            std::vector<long long> points(graph.numTiles());
+            for (int k = 0; k < graph.numTiles(); k++) {
+                points[k] = tiling.numPoints(graph.tile(k));
+            }
+            std::cout << "tiling = " << tilingStr << ", N = " << N
+                      << ", T = " << T << ", tau = " << tau
+                      << ", sigma = " << sigma << ", gamma = " << gamma_size
+                      << ", tiles = " << graph.numTiles()
+                      << ", ns per point = " << ns_per_point << std::endl;
+            simulateGraph(graph, points, ns_per_point, out, to_file);
+        });
+    }
+    if (to_file) { std::cout << "Generating file " << outFile << std::endl; }
+    return true;
+}
+
+void printViolation(const DependenceViolation& v) {
+    std::cout << "illegal: tile (" << v.tile.c0 << "," << v.tile.c1 << ","
+              << v.tile.c2 << ")";
+    if (v.wavefront >= 0) { std::cout << " in wavefront " << v.wavefront; }
+    std::cout << " computes (" << v.t << "," << v.i << "," << v.j << ")";
+    if (v.outside) {
+        std::cout << ", which is outside of the iteration space";
+    } else {
+        std::cout << " before (" << v.predT << "," << v.predI << ","
+                  << v.predJ << ")";
+    }
+    std::cout << std::endl;
+}
+
+bool legalityMode() {
+    if (num_threads > 0) { omp_set_num_threads(num_threads); }
+    DependenceChecker checker(T, 1, N-2, 1, N-2);
+    double start = wallTime();
+    bool legal = true;
+    if (isChoice != is_none) {
+        std::cout << "is_traversal = " << isStr << ", N = " << N
+                  << ", T = " << T << std::endl;
+        forEachIsPoint(isChoice, T, N,
+            [&](const TileCoord& tile, int t, int i, int j) {
+                checker.visitPoint(tile, t, i, j);
+            });
+        legal = !checker.hasViolation();
+    } else {
+        std::cout << "tiling = " << tilingStr << ", N = " << N
+                  << ", T = " << T << ", tau = " << tau
+                  << ", sigma = " << sigma << ", gamma = " << gamma_size
+                  << ", threads = " << omp_get_max_threads() << std::endl;
+        withTiling(tau, [&](const auto& tiling) {
+            legal = checker.checkTiling(tiling);
+        });
+    }
+    double time = wallTime()-start;
+    std::cout << "points checked = " << checker.numPoints() << " of "
+              << (long long)T*(N-2)*(N-2) << ", time = " << time << " s, "
+              << time/(checker.numPoints() > 0 ? checker.numPoints() : 1)*1e9
+              << " ns per point" << std::endl;
+    if (!legal) {
+        printViolation(checker.violation());
+        return false;
+    }
+    std::cout << "legal" << std::endl;
+    return true;
+}
+
+bool coverageMode() {
+    if (num_threads > 0) { omp_set_num_threads(num_threads); }
+    CoverageChecker checker(T, 1, N-2, 1, N-2);
+    double start = wallTime();
+    if (isChoice != is_none) {
+        std::cout << "is_traversal = " << isStr << ", N = " << N
+                  << ", T = " << T << std::endl;
+        checker.checkTraversal([&](const auto& f) {
+            forEachIsPoint(isChoice, T, N, f);
+        });
+    } else {
+        std::cout << "tiling = " << tilingStr << ", N = " << N
+                  << ", T = " << T << ", tau = " << tau
+                  << ", sigma = " << sigma << ", gamma = " << gamma_size
+                  << ", threads = " << omp_get_max_threads() << std::endl;
+        withTiling(tau, [&](const auto& tiling) {
+            checker.checkTiling(tiling);
+        });
+    }
+    double time = wallTime()-start;
+    printCoverageReport(std::cout, checker.report());
+    std::cout << "time = " << time << " s" << std::endl;
+    return checker.report().exactlyOnce();
+}
+
+int main(int argc, char ** argv) {
+    // Do command-line parsing.
+    CmdParams *cmdparams = CmdParams_ctor(1);
+    initParams(cmdparams);
+    CmdParams_parseParams(cmdparams,argc,argv);
+    modeChoice = (mode_type)CmdParams_getValue(cmdparams,'m');
+    strncpy(modeStr, CmdParams_getString(cmdparams,'m'), MAXPOSSVALSTRING);
+    tilingChoice = (tiling_type)CmdParams_getValue(cmdparams,'y');
+    strncpy(tilingStr, CmdParams_getString(cmdparams,'y'), MAXPOSSVALSTRING);
+    T = CmdParams_getValue(cmdparams,'T');
+    N = CmdParams_getValue(cmdparams,'N');
+    tau = CmdParams_getValue(cmdparams,'t');
+    sigma = CmdParams_getValue(cmdparams,'b');
+    height = CmdParams_getValue(cmdparams,'E');
+    gamma_size = CmdParams_getValue(cmdparams,'G');
+    elem_size = CmdParams_getValue(cmdparams,'e');
+    num_buffers = CmdParams_getValue(cmdparams,'n');
+    max_tau = CmdParams_getValue(cmdparams,'x');
+    tau_step = CmdParams_getValue(cmdparams,'s');
+    strncpy(cacheSpecs, CmdParams_getString(cmdparams,'c'), MAXPOSSVALSTRING);
+    num_threads = CmdParams_getValue(cmdparams,'p');
+    strncpy(outFile, CmdParams_getString(cmdparams,'o'), MAXPOSSVALSTRING);
+    strncpy(dotFile, CmdParams_getString(cmdparams,'d'), MAXPOSSVALSTRING);
+    strncpy(inFile, CmdParams_getString(cmdparams,'i'), MAXPOSSVALSTRING);
+    strncpy(nsPerPointStr, CmdParams_getString(cmdparams,'k'),
+            MAXPOSSVALSTRING);
+    isChoice = (is_traversal_type)CmdParams_getValue(cmdparams,'I');
+    strncpy(isStr, CmdParams_getString(cmdparams,'I'), MAXPOSSVALSTRING);
+    formatChoice = (format_type)CmdParams_getValue(cmdparams,'f');
+    max_workers = CmdParams_getValue(cmdparams,'w');
+    if (isSlabTiling() && (tau < 9 || tau%3 != 0)) {
+        std::cerr << "Error: tile-analysis: the slab tilings need tau to "
+                  << "be a multiple of 3 and at least 9" << std::endl;
+        return 1;
+    }
+
+    switch (modeChoice) {
+        case footprint:
+            footprintMode();
+            break;
+        case cachesim:
+            if (!cachesimMode()) { return 1; }
+            break;
+        case profile:
+            if (!profileMode()) { return 1; }
+            break;
+        case count:
+            if (!countMode()) { return 1; }
+            break;
+        case tilespace:
+            if (!tilespaceMode()) { return 1; }
+            break;
+        case dag:
+            if (!dagMode()) { return 1; }
+            break;
+        case simulate:
+            if (!simulateMode()) { return 1; }
+            break;
+        case legality:
+            if (!legalityMode()) { return 1; }
+            break;
+        case coverage:
+            if (!coverageMode()) { return 1; }
+            break;
+    }
+
+    return 0;
+}
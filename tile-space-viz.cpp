@@ -231,6 +231,19 @@ int main() {
 
     printf("==== Doing unskew\n");
     // It does cut down on the bounds a bit.
+    //
+    // These bounds, and the two versions above, are copied into
+    // SlabDiamondTiling.hpp so that tile-analysis -m legality and
+    // -m coverage with -y slab_param, slab_fixed, or slab_unskew can check
+    // them.  All three are legal, but the fixed and unskewed versions
+    // leave holes: c1_ub should be floord(Uj + ((tau/3)-3), tau), which
+    // is floord(T + Uj - 1, tau) with T = tau/3-2, so the last column of
+    // tiles is dropped (e.g. tau=33, N=100), and the unskewed c2 bounds
+    // drop more points still (e.g. tau=9, N=20).  The SIMPLER LOOPS and
+    // the projected unskewed c2 loops at the end are copied there too,
+    // as slab_simple and slab_projected.  Both are legal, the simple
+    // loops cover the slab but 47% of their tiles are empty at tau=33,
+    // N=100, and the projected ones leave holes (e.g. tau=15, N=1000).
 
     for (int c0 = -2; c0 <= 0; c0 += 1){
 